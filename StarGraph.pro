@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui opengl
+QT       += core gui opengl concurrent svg network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -33,7 +33,36 @@ HEADERS += \
         mainwindow.h \
     converter.h \
     gl_diagram.h \
-    file_manager.h
+    file_manager.h \
+    base64_codec.h \
+    memory_budget.h \
+    file_dialogs.h \
+    parameter_calculation.h \
+    journal_manager.h \
+    star_dataset.h \
+    compact_storage.h \
+    column_store.h \
+    density_pyramid.h \
+    diagram_projection.h \
+    diagram_painter.h \
+    stargraph_core/stargraph_core.h \
+    star_selection.h \
+    list_merge.h \
+    list_sampling.h \
+    list_preview.h \
+    name_index.h \
+    list_sort.h \
+    list_statistics.h \
+    live_ingest.h \
+    snapshot_playback.h \
+    playback_panel.h \
+    startup_trace.h \
+    style_loader.h \
+    statistics_panel.h \
+    memory_panel.h \
+    catalog_layers.h \
+    vector_export.h \
+    tiled_export.h
 
 FORMS += \
         mainwindow.ui
@@ -49,6 +78,22 @@ RESOURCES += qdarkstyle/style.qrc \
 
 RC_FILE = icon.rc
 
-LIBS += -lOpengl32
+win32: LIBS += -lOpengl32
+
+# The lists, the files and the offscreen renderer come from the core library, built first by StarGraphSuite.pro
+INCLUDEPATH += $$PWD/stargraph_core
+DEPENDPATH += $$PWD/stargraph_core
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/stargraph_core/release -lstargraph_core
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/stargraph_core/debug -lstargraph_core
+else: LIBS += -L$$OUT_PWD/stargraph_core -lstargraph_core
+
+win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/stargraph_core/release/libstargraph_core.a
+else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/stargraph_core/debug/libstargraph_core.a
+else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/stargraph_core/release/stargraph_core.lib
+else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/stargraph_core/debug/stargraph_core.lib
+else: PRE_TARGETDEPS += $$OUT_PWD/stargraph_core/libstargraph_core.a
+
+# zlib is bundled with Qt on Windows, elsewhere the system library is used
+unix: LIBS += -lz
 
 DISTFILES +=
@@ -0,0 +1,18 @@
+#-------------------------------------------------
+#
+# Builds the core library, then StarGraph, the command line converter and the unit tests
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    stargraph_core \
+    app \
+    stargraph_convert \
+    tests
+
+app.file = StarGraph.pro
+app.depends = stargraph_core
+stargraph_convert.depends = stargraph_core
+tests.depends = stargraph_core
@@ -0,0 +1,273 @@
+/*
+    BASE64 CODEC
+*/
+#pragma once
+
+#include <QtGlobal>
+
+//SSE2 is part of every x86-64 processor and NEON of every AArch64 one, so their paths need no compiler flag; other targets only use the tables
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BASE64_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define BASE64_NEON
+#endif
+
+using namespace std;
+
+//Class containing the base64url functions used by the '.sgl' lists, without padding, working on buffers the caller owns
+//Most of the bytes are encoded in blocks with SSE2 or NEON, and most of the characters decoded in blocks with NEON, which loads them already split by their position in a group
+//The groups left are decoded with one lookup per character in tables holding the six bits already shifted into place
+//The validity of a whole buffer is checked once at its end
+class Base64UrlFunctions
+{
+public:
+    //Returns the bytes decoded from 'length' characters, an incomplete group of two or three characters gives one or two bytes
+    static int get_decoded_size(int length)
+    {
+        return length / 4 * 3 + (length % 4 > 1 ? length % 4 - 1 : 0);
+    }
+
+    //Returns the characters encoding 'size' bytes, without padding
+    static int get_encoded_size(int size)
+    {
+        return size / 3 * 4 + (size % 3 > 0 ? size % 3 + 1 : 0);
+    }
+
+    //Decode the 'length' characters of 'input' to 'output', which must have room for 'get_decoded_size(length)' bytes
+    //Returns the number of bytes written, or '-1' if 'input' has a character outside the base64url alphabet or a single character after its last group
+    static int decode(const char* input, int length, char* output)
+    {
+        const DecodeTables& tables = get_decode_tables();
+        bool block_invalid = false;
+        int block_length = decode_blocks(input, length, output, block_invalid);
+        const unsigned char* in = reinterpret_cast<const unsigned char*>(input) + block_length;
+        char* out = output + block_length / 4 * 3;
+        quint32 invalid = block_invalid ? invalid_flag : 0;
+
+        for(int i = 0; i < (length - block_length) / 4; i ++)
+        {
+            quint32 word = tables.shifted[0][in[0]] | tables.shifted[1][in[1]] | tables.shifted[2][in[2]] | tables.shifted[3][in[3]];
+            invalid |= word;
+            out[0] = static_cast<char>(word >> 16);
+            out[1] = static_cast<char>(word >> 8);
+            out[2] = static_cast<char>(word);
+            in += 4;
+            out += 3;
+        }
+
+        int rest = length % 4;
+        if(rest == 1)
+        {
+            return -1;
+        }
+        if(rest > 1)
+        {
+            quint32 word = tables.shifted[0][in[0]] | tables.shifted[1][in[1]] | (rest == 3 ? tables.shifted[2][in[2]] : 0);
+            invalid |= word;
+            *out ++ = static_cast<char>(word >> 16);
+            if(rest == 3)
+            {
+                *out ++ = static_cast<char>(word >> 8);
+            }
+        }
+        return (invalid & invalid_flag) ? -1 : static_cast<int>(out - output);
+    }
+
+    //Encode the 'size' bytes of 'input' to 'output', which must have room for 'get_encoded_size(size)' characters, returns the number of characters written
+    static int encode(const char* input, int size, char* output)
+    {
+        static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+        int block_size = encode_blocks(input, size, output);
+        const unsigned char* in = reinterpret_cast<const unsigned char*>(input) + block_size;
+        char* out = output + block_size / 3 * 4;
+
+        for(int i = 0; i < (size - block_size) / 3; i ++)
+        {
+            quint32 word = (static_cast<quint32>(in[0]) << 16) | (static_cast<quint32>(in[1]) << 8) | in[2];
+            out[0] = alphabet[word >> 18];
+            out[1] = alphabet[(word >> 12) & 63];
+            out[2] = alphabet[(word >> 6) & 63];
+            out[3] = alphabet[word & 63];
+            in += 3;
+            out += 4;
+        }
+
+        int rest = size % 3;
+        if(rest > 0)
+        {
+            quint32 word = (static_cast<quint32>(in[0]) << 16) | (rest == 2 ? static_cast<quint32>(in[1]) << 8 : 0);
+            *out ++ = alphabet[word >> 18];
+            *out ++ = alphabet[(word >> 12) & 63];
+            if(rest == 2)
+            {
+                *out ++ = alphabet[(word >> 6) & 63];
+            }
+        }
+        return static_cast<int>(out - output);
+    }
+
+private:
+    //Set in the entries of the characters outside the alphabet, above the 24 bits a group decodes to
+    static const quint32 invalid_flag = 0xff000000;
+
+#if defined(BASE64_SSE2)
+    //Without a byte shuffle, classifying and packing 16 characters with SSE2 costs as much as their lookups in the tables, so x86 decodes with the tables only
+    static int decode_blocks(const char*, int, char*, bool& invalid)
+    {
+        invalid = false;
+        return 0;
+    }
+
+    //Encode blocks of 12 bytes to 16 characters, returns the number of bytes encoded
+    //Each block reads 16 bytes, so a block is only encoded when at least four more bytes follow it
+    static int encode_blocks(const char* input, int size, char* output)
+    {
+        int done = 0;
+        for(; size - done >= 16; done += 12)
+        {
+            //Spread the four groups of three bytes to the four 32 bit lanes, the first byte of a group lowest
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + done));
+            bytes = _mm_unpacklo_epi64(bytes, _mm_srli_si128(bytes, 6));
+            __m128i groups = _mm_or_si128(_mm_and_si128(bytes, _mm_set_epi32(0, 0xffffff, 0, 0xffffff)), _mm_and_si128(_mm_slli_epi64(bytes, 8), _mm_set_epi32(0xffffff, 0, 0xffffff, 0)));
+
+            //Cut each group into its four values of six bits, one in each byte of the lane
+            __m128i values = _mm_and_si128(_mm_srli_epi32(groups, 2), _mm_set1_epi32(0x3f));
+            values = _mm_or_si128(values, _mm_and_si128(_mm_slli_epi32(groups, 12), _mm_set1_epi32(0x3000)));
+            values = _mm_or_si128(values, _mm_and_si128(_mm_srli_epi32(groups, 4), _mm_set1_epi32(0x0f00)));
+            values = _mm_or_si128(values, _mm_and_si128(_mm_slli_epi32(groups, 10), _mm_set1_epi32(0x3c0000)));
+            values = _mm_or_si128(values, _mm_and_si128(_mm_srli_epi32(groups, 6), _mm_set1_epi32(0x030000)));
+            values = _mm_or_si128(values, _mm_and_si128(_mm_slli_epi32(groups, 8), _mm_set1_epi32(0x3f000000)));
+
+            //Add to each value the offset of its range of the alphabet
+            __m128i offsets = _mm_set1_epi8('A');
+            offsets = _mm_add_epi8(offsets, _mm_and_si128(_mm_cmpgt_epi8(values, _mm_set1_epi8(25)), _mm_set1_epi8('a' - 26 - 'A')));
+            offsets = _mm_add_epi8(offsets, _mm_and_si128(_mm_cmpgt_epi8(values, _mm_set1_epi8(51)), _mm_set1_epi8('0' - 52 - ('a' - 26))));
+            offsets = _mm_add_epi8(offsets, _mm_and_si128(_mm_cmpgt_epi8(values, _mm_set1_epi8(61)), _mm_set1_epi8('-' - 62 - ('0' - 52))));
+            offsets = _mm_add_epi8(offsets, _mm_and_si128(_mm_cmpgt_epi8(values, _mm_set1_epi8(62)), _mm_set1_epi8('_' - 63 - ('-' - 62))));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + done / 3 * 4), _mm_add_epi8(values, offsets));
+        }
+        return done;
+    }
+#elif defined(BASE64_NEON)
+    //Decode blocks of 64 characters to 48 bytes, returns the number of characters decoded and sets 'invalid' if one was outside the alphabet
+    //The characters are loaded in four planes, one for each position in a group, and the bytes stored from three planes
+    static int decode_blocks(const char* input, int length, char* output, bool& invalid)
+    {
+        uint8x16_t invalid_chars = vdupq_n_u8(0);
+        int done = 0;
+        for(; length - done >= 64; done += 64)
+        {
+            uint8x16x4_t chars = vld4q_u8(reinterpret_cast<const uint8_t*>(input + done));
+            uint8x16_t values[4];
+            for(int p = 0; p < 4; p ++)
+            {
+                uint8x16_t upper = vandq_u8(vcgeq_u8(chars.val[p], vdupq_n_u8('A')), vcleq_u8(chars.val[p], vdupq_n_u8('Z')));
+                uint8x16_t lower = vandq_u8(vcgeq_u8(chars.val[p], vdupq_n_u8('a')), vcleq_u8(chars.val[p], vdupq_n_u8('z')));
+                uint8x16_t digit = vandq_u8(vcgeq_u8(chars.val[p], vdupq_n_u8('0')), vcleq_u8(chars.val[p], vdupq_n_u8('9')));
+                uint8x16_t dash = vceqq_u8(chars.val[p], vdupq_n_u8('-'));
+                uint8x16_t underscore = vceqq_u8(chars.val[p], vdupq_n_u8('_'));
+                uint8x16_t valid = vorrq_u8(vorrq_u8(vorrq_u8(upper, lower), vorrq_u8(digit, dash)), underscore);
+                invalid_chars = vorrq_u8(invalid_chars, vmvnq_u8(valid));
+
+                uint8x16_t offsets = vorrq_u8(vandq_u8(upper, vdupq_n_u8(static_cast<uint8_t>(-'A'))), vandq_u8(lower, vdupq_n_u8(static_cast<uint8_t>(26 - 'a'))));
+                offsets = vorrq_u8(offsets, vandq_u8(digit, vdupq_n_u8(static_cast<uint8_t>(52 - '0'))));
+                offsets = vorrq_u8(offsets, vandq_u8(dash, vdupq_n_u8(static_cast<uint8_t>(62 - '-'))));
+                offsets = vorrq_u8(offsets, vandq_u8(underscore, vdupq_n_u8(static_cast<uint8_t>(63 - '_'))));
+                values[p] = vaddq_u8(chars.val[p], offsets);
+            }
+
+            uint8x16x3_t bytes;
+            bytes.val[0] = vorrq_u8(vshlq_n_u8(values[0], 2), vshrq_n_u8(values[1], 4));
+            bytes.val[1] = vorrq_u8(vshlq_n_u8(values[1], 4), vshrq_n_u8(values[2], 2));
+            bytes.val[2] = vorrq_u8(vshlq_n_u8(values[2], 6), values[3]);
+            vst3q_u8(reinterpret_cast<uint8_t*>(output + done / 4 * 3), bytes);
+        }
+        uint8x8_t folded = vorr_u8(vget_low_u8(invalid_chars), vget_high_u8(invalid_chars));
+        invalid = vget_lane_u64(vreinterpret_u64_u8(folded), 0) != 0;
+        return done;
+    }
+
+    //Encode blocks of 48 bytes to 64 characters, returns the number of bytes encoded
+    static int encode_blocks(const char* input, int size, char* output)
+    {
+        int done = 0;
+        for(; size - done >= 48; done += 48)
+        {
+            uint8x16x3_t bytes = vld3q_u8(reinterpret_cast<const uint8_t*>(input + done));
+            uint8x16x4_t chars;
+            chars.val[0] = vshrq_n_u8(bytes.val[0], 2);
+            chars.val[1] = vorrq_u8(vandq_u8(vshlq_n_u8(bytes.val[0], 4), vdupq_n_u8(0x30)), vshrq_n_u8(bytes.val[1], 4));
+            chars.val[2] = vorrq_u8(vandq_u8(vshlq_n_u8(bytes.val[1], 2), vdupq_n_u8(0x3c)), vshrq_n_u8(bytes.val[2], 6));
+            chars.val[3] = vandq_u8(bytes.val[2], vdupq_n_u8(0x3f));
+            for(int p = 0; p < 4; p ++)
+            {
+                uint8x16_t offsets = vdupq_n_u8('A');
+                offsets = vaddq_u8(offsets, vandq_u8(vcgtq_u8(chars.val[p], vdupq_n_u8(25)), vdupq_n_u8(static_cast<uint8_t>('a' - 26 - 'A'))));
+                offsets = vaddq_u8(offsets, vandq_u8(vcgtq_u8(chars.val[p], vdupq_n_u8(51)), vdupq_n_u8(static_cast<uint8_t>('0' - 52 - ('a' - 26)))));
+                offsets = vaddq_u8(offsets, vandq_u8(vcgtq_u8(chars.val[p], vdupq_n_u8(61)), vdupq_n_u8(static_cast<uint8_t>('-' - 62 - ('0' - 52)))));
+                offsets = vaddq_u8(offsets, vandq_u8(vcgtq_u8(chars.val[p], vdupq_n_u8(62)), vdupq_n_u8(static_cast<uint8_t>('_' - 63 - ('-' - 62)))));
+                chars.val[p] = vaddq_u8(chars.val[p], offsets);
+            }
+            vst4q_u8(reinterpret_cast<uint8_t*>(output + done / 3 * 4), chars);
+        }
+        return done;
+    }
+#else
+    static int decode_blocks(const char*, int, char*, bool& invalid)
+    {
+        invalid = false;
+        return 0;
+    }
+
+    static int encode_blocks(const char*, int, char*)
+    {
+        return 0;
+    }
+#endif
+
+    //The value of each character shifted to its place in a group of four, or 'invalid_flag'
+    struct DecodeTables
+    {
+        quint32 shifted[4][256];
+
+        DecodeTables()
+        {
+            for(int c = 0; c < 256; c ++)
+            {
+                int value = -1;
+                if(c >= 'A' && c <= 'Z')
+                {
+                    value = c - 'A';
+                }
+                else if(c >= 'a' && c <= 'z')
+                {
+                    value = c - 'a' + 26;
+                }
+                else if(c >= '0' && c <= '9')
+                {
+                    value = c - '0' + 52;
+                }
+                else if(c == '-')
+                {
+                    value = 62;
+                }
+                else if(c == '_')
+                {
+                    value = 63;
+                }
+                for(int position = 0; position < 4; position ++)
+                {
+                    shifted[position][c] = value < 0 ? invalid_flag : static_cast<quint32>(value) << (18 - 6 * position);
+                }
+            }
+        }
+    };
+
+    static const DecodeTables& get_decode_tables()
+    {
+        static const DecodeTables tables;
+        return tables;
+    }
+};
@@ -0,0 +1,142 @@
+/*
+    CATALOG LAYERS
+*/
+#pragma once
+
+#include <QColor>
+#include <QString>
+#include <climits>
+#include <cmath>
+#include <vector>
+
+#include "converter.h"
+#include "diagram_projection.h"
+#include "star_dataset.h"
+
+using namespace std;
+
+//Style and data of a catalog drawn over the current list
+struct CatalogLayer
+{
+    //Identifier of the layer, '0' is reserved for the current list
+    int id;
+    QString name;
+    DatasetSnapshot dataset;
+    bool visible;
+    //Colour each star from its temperature instead of using 'colour'
+    bool temperature_colour;
+    QColor colour;
+    bool round_markers;
+    float point_size;
+    //Draw the layer over the current list instead of under it, like the stars recoloured from a selection
+    bool over_list;
+};
+
+//Overlaid catalogs, in drawing order
+extern vector<CatalogLayer> catalog_layers;
+
+//Class containing the functions used to manage the overlaid catalogs
+class LayerFunctions
+{
+public:
+    //Number of floats stored for each star in a layer buffer: temperature, log10 of the luminosity and RGB colour
+    static const int vertex_size = 5;
+
+    //Add a new layer and return its identifier
+    static int add_layer(QString name, DatasetSnapshot dataset)
+    {
+        static int next_id = 1;
+        static const QColor palette[] = { QColor(0, 200, 255), QColor(255, 160, 0), QColor(120, 255, 80), QColor(255, 80, 200), QColor(255, 255, 100) };
+
+        CatalogLayer layer;
+        layer.id = next_id ++;
+        layer.name = name;
+        layer.dataset = dataset;
+        layer.visible = true;
+        layer.temperature_colour = false;
+        layer.colour = palette[catalog_layers.size() % 5];
+        layer.round_markers = true;
+        layer.point_size = 3.0;
+        layer.over_list = false;
+
+        catalog_layers.push_back(layer);
+        return layer.id;
+    }
+
+    //Returns the layer with identifier 'id', or 'nullptr' if it has been removed
+    static CatalogLayer* find_layer(int id)
+    {
+        for(unsigned i = 0; i < catalog_layers.size(); i ++)
+        {
+            if(catalog_layers[i].id == id)
+            {
+                return &catalog_layers[i];
+            }
+        }
+        return nullptr;
+    }
+
+    static void remove_layer(int id)
+    {
+        for(unsigned i = 0; i < catalog_layers.size(); i ++)
+        {
+            if(catalog_layers[i].id == id)
+            {
+                catalog_layers.erase(catalog_layers.begin() + i);
+                return;
+            }
+        }
+    }
+
+    //Fill 'vertices' with the stars of the chunks from 'first_chunk' to 'last_chunk' in the values of the axes of the current projection
+    //The stars below the pivot of the vertical axis come first, their number is returned, since the two sides of a split axis use different scales
+    //The rows before 'first_row' are skipped, so the stars appended to a list can be added to its vertices
+    static int build_vertices(const StarDataset& dataset, vector<float>& vertices, unsigned first_chunk = 0, unsigned last_chunk = UINT_MAX, unsigned first_row = 0)
+    {
+        return build_vertices(ProjectionFunctions::get_view(), dataset, vertices, first_chunk, last_chunk, first_row);
+    }
+
+    //Fill 'vertices' with all the stars of 'dataset' in 'view' instead of the current settings, on any thread
+    static int build_vertices(const DiagramView& view, const StarDataset& dataset, vector<float>& vertices)
+    {
+        return build_vertices(view, dataset, vertices, 0, UINT_MAX, 0);
+    }
+
+private:
+    static int build_vertices(const DiagramView& view, const StarDataset& dataset, vector<float>& vertices, unsigned first_chunk, unsigned last_chunk, unsigned first_row)
+    {
+        const ProjectionKernels& projection = ProjectionFunctions::get_kernels(view.projection);
+        vector<float> bright_vertices;
+        vertices.clear();
+        last_chunk = min(last_chunk, dataset.get_chunk_count());
+        double pivot = projection.get_y_scale(view).pivot;
+        vector<double> x_values(StarDataset::chunk_size);
+        vector<double> y_values(StarDataset::chunk_size);
+
+        //Go chunk by chunk, so an out-of-core list loads each chunk once
+        for(unsigned c = first_chunk; c < last_chunk; c ++)
+        {
+            shared_ptr<const StarChunk> chunk = dataset.get_chunk(c);
+            //Read the values directly, so a packed chunk is never converted back to strings
+            projection.get_values(*chunk, x_values.data(), y_values.data());
+            for(unsigned i = c * StarDataset::chunk_size < first_row ? first_row - c * StarDataset::chunk_size : 0; i < chunk->size(); i ++)
+            {
+                if(!ProjectionFunctions::is_finite(x_values[i], y_values[i]))
+                {
+                    continue;
+                }
+
+                //Assign a colour to the star, the same way 'DiagramPainterFunctions::get_star_colour()' does
+                double col = (1.0 / 13000) * (chunk->get_temperature(i) - 3000);
+                float vertex[vertex_size] = { static_cast<float>(x_values[i]), static_cast<float>(y_values[i]), static_cast<float>(1 - col), static_cast<float>((col / 2) + 0.5), static_cast<float>(col) };
+
+                vector<float>& target = y_values[i] < pivot ? vertices : bright_vertices;
+                target.insert(target.end(), vertex, vertex + vertex_size);
+            }
+        }
+
+        int faint_count = static_cast<int>(vertices.size()) / vertex_size;
+        vertices.insert(vertices.end(), bright_vertices.begin(), bright_vertices.end());
+        return faint_count;
+    }
+};
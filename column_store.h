@@ -0,0 +1,337 @@
+/*
+    COLUMN STORE
+*/
+#pragma once
+
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtEndian>
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "compact_storage.h"
+#include "density_pyramid.h"
+#include "file_manager.h"
+#include "star_dataset.h"
+
+using namespace std;
+
+//Maximum size of the chunks an out-of-core list keeps in memory, in megabytes
+extern int chunk_cache_size;
+
+//Class reading the chunks of a column file, keeping the most recently used ones in memory
+//A column file ('.sgc') stores the packed columns of each chunk one after the other, followed by an index of the chunks:
+//    "SGC1", then for each chunk its temperatures, luminosities, spectral types, name buckets and names
+//    index: offset, number of rows and size of the names of each chunk, then the offset of the index, the number of chunks and "SGCX"
+//Every number is little endian
+class ColumnFileStore : public ChunkSource
+{
+public:
+    ColumnFileStore() : row_count(0), cached_bytes(0)
+    {
+    }
+
+    bool open(QString file_name)
+    {
+        column_file.setFileName(file_name);
+        if(!column_file.open(QIODevice::ReadOnly) || column_file.size() < 20)
+        {
+            return false;
+        }
+
+        //Read the footer and then the index
+        column_file.seek(column_file.size() - 16);
+        QByteArray footer = column_file.read(16);
+        if(footer.mid(12) != "SGCX")
+        {
+            return false;
+        }
+        qint64 index_offset = static_cast<qint64>(qFromLittleEndian<quint64>(reinterpret_cast<const uchar*>(footer.constData())));
+        quint32 chunk_count = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(footer.constData() + 8));
+
+        column_file.seek(index_offset);
+        QByteArray index = column_file.read(static_cast<qint64>(chunk_count) * 16);
+        if(static_cast<qint64>(index.size()) != static_cast<qint64>(chunk_count) * 16)
+        {
+            return false;
+        }
+
+        quint64 rows = 0;
+        for(quint32 i = 0; i < chunk_count; i ++)
+        {
+            const uchar* entry_data = reinterpret_cast<const uchar*>(index.constData() + i * 16);
+            ChunkEntry entry;
+            entry.offset = static_cast<qint64>(qFromLittleEndian<quint64>(entry_data));
+            entry.rows = qFromLittleEndian<quint32>(entry_data + 8);
+            entry.name_bytes = qFromLittleEndian<quint32>(entry_data + 12);
+
+            //Every chunk but the last one must be full, since rows are found by dividing their index by the chunk size
+            if(entry.rows == 0 || entry.rows > StarDataset::chunk_size || (i + 1 < chunk_count && entry.rows != StarDataset::chunk_size) || entry.offset + get_chunk_bytes(entry) > index_offset)
+            {
+                return false;
+            }
+            rows += entry.rows;
+            entries.push_back(entry);
+        }
+
+        row_count = rows;
+        return true;
+    }
+
+    quint64 get_row_count() const
+    {
+        return row_count;
+    }
+
+    //Returns the chunk 'index', mapping it from the file if it is not in the cache
+    //The columns are copied out of the mapping, so the cache size and not the page cache decides how much memory is used
+    shared_ptr<const StarChunk> load_chunk(unsigned index)
+    {
+        lock_guard<mutex> lock(cache_mutex);
+
+        map<unsigned, CachedChunk>::iterator cached = cache.find(index);
+        if(cached != cache.end())
+        {
+            recently_used.splice(recently_used.begin(), recently_used, cached->second.position);
+            return cached->second.chunk;
+        }
+
+        const ChunkEntry& entry = entries[index];
+        qint64 chunk_bytes = get_chunk_bytes(entry);
+        shared_ptr<StarChunk> chunk = make_shared<StarChunk>();
+        chunk->packed = true;
+
+        uchar* data = column_file.map(entry.offset, chunk_bytes);
+        if(data != nullptr)
+        {
+            read_columns(data, entry, chunk->columns);
+            column_file.unmap(data);
+        }
+        else
+        {
+            //Some file systems cannot be mapped
+            column_file.seek(entry.offset);
+            QByteArray chunk_data = column_file.read(chunk_bytes);
+            read_columns(reinterpret_cast<const uchar*>(chunk_data.constData()), entry, chunk->columns);
+        }
+        chunk->count_memory();
+
+        //Forget the least recently used chunks, the ones still held by a reader are released by it
+        recently_used.push_front(index);
+        CachedChunk cached_chunk = { chunk, recently_used.begin(), chunk_bytes };
+        cache[index] = cached_chunk;
+        cached_bytes += chunk_bytes;
+        while(cached_bytes > static_cast<qint64>(chunk_cache_size) * 1024 * 1024 && cache.size() > 1)
+        {
+            map<unsigned, CachedChunk>::iterator oldest = cache.find(recently_used.back());
+            cached_bytes -= oldest->second.bytes;
+            cache.erase(oldest);
+            recently_used.pop_back();
+        }
+
+        return chunk;
+    }
+
+private:
+    struct ChunkEntry
+    {
+        qint64 offset;
+        quint32 rows;
+        quint32 name_bytes;
+    };
+
+    struct CachedChunk
+    {
+        shared_ptr<const StarChunk> chunk;
+        list<unsigned>::iterator position;
+        qint64 bytes;
+    };
+
+    static qint64 get_chunk_bytes(const ChunkEntry& entry)
+    {
+        quint32 bucket_count = (entry.rows + PackingFunctions::name_bucket_size - 1) / PackingFunctions::name_bucket_size;
+        return static_cast<qint64>(entry.rows) * 5 + bucket_count * 4 + entry.name_bytes;
+    }
+
+    static void read_columns(const uchar* data, const ChunkEntry& entry, PackedColumns& columns)
+    {
+        quint32 bucket_count = (entry.rows + PackingFunctions::name_bucket_size - 1) / PackingFunctions::name_bucket_size;
+        columns.temperatures.resize(entry.rows);
+        columns.log_luminosities.resize(entry.rows);
+        columns.name_buckets.resize(bucket_count);
+        for(quint32 i = 0; i < entry.rows; i ++)
+        {
+            columns.temperatures[i] = qFromLittleEndian<quint16>(data + i * 2);
+        }
+        data += entry.rows * 2;
+        for(quint32 i = 0; i < entry.rows; i ++)
+        {
+            columns.log_luminosities[i] = qFromLittleEndian<qint16>(data + i * 2);
+        }
+        data += entry.rows * 2;
+        columns.spectral_types.assign(data, data + entry.rows);
+        data += entry.rows;
+        for(quint32 i = 0; i < bucket_count; i ++)
+        {
+            columns.name_buckets[i] = qFromLittleEndian<quint32>(data + i * 4);
+        }
+        data += bucket_count * 4;
+        columns.names = QByteArray(reinterpret_cast<const char*>(data), static_cast<int>(entry.name_bytes));
+    }
+
+    QFile column_file;
+    vector<ChunkEntry> entries;
+    quint64 row_count;
+
+    mutex cache_mutex;
+    map<unsigned, CachedChunk> cache;
+    //Indexes of the cached chunks, the most recently used first
+    list<unsigned> recently_used;
+    qint64 cached_bytes;
+};
+
+//Progress of a conversion running on another thread, read by the GUI thread which may also cancel it
+struct ConversionProgress
+{
+    ConversionProgress() : read_bytes(0), cancelled(false)
+    {
+    }
+
+    atomic<qint64> read_bytes;
+    atomic<bool> cancelled;
+};
+
+//Class containing the functions used to write column files
+class ColumnFileFunctions
+{
+public:
+    //Returns the path of the column file made from 'file_name'
+    static QString get_column_file_path(QString file_name)
+    {
+        QFileInfo file_info(file_name);
+        return file_info.path() + "/" + file_info.completeBaseName() + ".sgc";
+    }
+
+    //Returns true if the column file 'column_file_name' exists and was written after 'file_name' was last changed, so it can be opened instead of converting the file again
+    static bool is_up_to_date(QString file_name, QString column_file_name)
+    {
+        QFileInfo file_info(file_name);
+        QFileInfo column_file_info(column_file_name);
+        return column_file_info.exists() && column_file_info.lastModified() >= file_info.lastModified();
+    }
+
+    //Convert a csv table, or a '.sgl' list, to a column file one chunk at a time, so the table never has to fit in memory
+    //The file is only replaced once the conversion succeeded; 'progress', if any, receives the bytes read and is checked for cancellation after each chunk
+    static bool convert_csv(QString csv_file_name, QString column_file_name, ConversionProgress* progress = nullptr)
+    {
+        ListReader reader;
+        if(!reader.open(csv_file_name))
+        {
+            return false;
+        }
+        QSaveFile column_out(column_file_name);
+        if(!column_out.open(QIODevice::WriteOnly))
+        {
+            return false;
+        }
+        column_out.write("SGC1", 4);
+
+        QByteArray index;
+        vector<vector<QString>> rows;
+        bool written = true;
+        bool more_rows = true;
+        while(more_rows && written)
+        {
+            more_rows = reader.read_rows(rows, StarDataset::chunk_size);
+            if(!rows.empty())
+            {
+                written = write_chunk(column_out, index, rows);
+                rows.clear();
+            }
+            if(progress != nullptr)
+            {
+                progress->read_bytes = reader.get_read_size();
+                written = written && !progress->cancelled;
+            }
+        }
+
+        written = written && reader.is_supported() && write_index(column_out, index);
+        if(!written)
+        {
+            column_out.cancelWriting();
+            return false;
+        }
+        DensityPyramid::remove(column_file_name);
+        return column_out.commit();
+    }
+
+    //Write a list already in memory to a column file
+    static bool write_column_file(QString column_file_name, const vector<vector<QString>>& list)
+    {
+        QFile column_out(column_file_name);
+        if(!column_out.open(QIODevice::WriteOnly))
+        {
+            return false;
+        }
+        column_out.write("SGC1", 4);
+        DensityPyramid::remove(column_file_name);
+
+        QByteArray index;
+        bool written = true;
+        for(unsigned i = 0; i < list.size() && written; i += StarDataset::chunk_size)
+        {
+            vector<vector<QString>> rows(list.begin() + i, list.begin() + min(static_cast<unsigned>(list.size()), i + StarDataset::chunk_size));
+            written = write_chunk(column_out, index, rows);
+        }
+        written = written && write_index(column_out, index);
+        column_out.close();
+        return written;
+    }
+
+private:
+    static bool write_chunk(QFileDevice& column_out, QByteArray& index, const vector<vector<QString>>& rows)
+    {
+        PackedColumns columns = PackingFunctions::pack(rows.begin(), rows.end());
+        QByteArray chunk_data;
+        for(unsigned i = 0; i < columns.temperatures.size(); i ++)
+        {
+            append_number<quint16>(chunk_data, columns.temperatures[i]);
+        }
+        for(unsigned i = 0; i < columns.log_luminosities.size(); i ++)
+        {
+            append_number<qint16>(chunk_data, columns.log_luminosities[i]);
+        }
+        chunk_data.append(reinterpret_cast<const char*>(columns.spectral_types.data()), static_cast<int>(columns.spectral_types.size()));
+        for(unsigned i = 0; i < columns.name_buckets.size(); i ++)
+        {
+            append_number<quint32>(chunk_data, columns.name_buckets[i]);
+        }
+        chunk_data.append(columns.names);
+
+        append_number<quint64>(index, static_cast<quint64>(column_out.pos()));
+        append_number<quint32>(index, static_cast<quint32>(rows.size()));
+        append_number<quint32>(index, static_cast<quint32>(columns.names.size()));
+        return column_out.write(chunk_data) == chunk_data.size();
+    }
+
+    static bool write_index(QFileDevice& column_out, const QByteArray& index)
+    {
+        QByteArray footer;
+        append_number<quint64>(footer, static_cast<quint64>(column_out.pos()));
+        append_number<quint32>(footer, static_cast<quint32>(index.size() / 16));
+        footer.append("SGCX", 4);
+        return column_out.write(index) == index.size() && column_out.write(footer) == footer.size();
+    }
+
+    template<class T> static void append_number(QByteArray& data, T value)
+    {
+        uchar bytes[sizeof(T)];
+        qToLittleEndian<T>(value, bytes);
+        data.append(reinterpret_cast<const char*>(bytes), sizeof(T));
+    }
+};
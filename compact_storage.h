@@ -0,0 +1,173 @@
+/*
+    COMPACT STORAGE
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "converter.h"
+
+using namespace std;
+
+//Store the lists loaded from now on in the packed form
+extern bool compact_storage;
+
+//Columns of a chunk in the packed form: about five bytes per star, plus the part of each name which differs from the previous one
+//Precision loss: the temperature is rounded to whole Kelvin and limited to 65535 K, the luminosity keeps about 0.06% of relative precision between 1e-16 and 1e16
+struct PackedColumns
+{
+    //Temperature in Kelvin
+    vector<quint16> temperatures;
+
+    //log10 of the luminosity in steps of 1 / 'PackingFunctions::log_luminosity_steps', 'PackingFunctions::no_luminosity' if it is not positive
+    vector<qint16> log_luminosities;
+
+    //Spectral type as returned by 'StarFunctions::get_spectral_type()', for example '52' means 'G2'
+    vector<quint8> spectral_types;
+
+    //Front-coded names: each one is stored as the length of the prefix it shares with the previous name, the length of the rest and the rest in UTF-8
+    //The first name of each bucket is stored whole, so reading a name never decodes more than one bucket
+    QByteArray names;
+    vector<quint32> name_buckets;
+};
+
+//Class containing the functions used to convert rows to and from the packed form
+class PackingFunctions
+{
+public:
+    //Number of names in each front-coding bucket
+    static const unsigned name_bucket_size = 16;
+
+    //Steps per decade of the packed luminosity
+    static const int log_luminosity_steps = 2048;
+
+    static const qint16 no_luminosity = -32768;
+
+    static quint16 pack_temperature(double temperature)
+    {
+        return static_cast<quint16>(qBound(0.0, std::floor(temperature + 0.5), 65535.0));
+    }
+
+    static qint16 pack_luminosity(double luminosity)
+    {
+        if(!(luminosity > 0))
+        {
+            return no_luminosity;
+        }
+        return static_cast<qint16>(qBound(-32767.0, std::floor(MathFunctions::log_base_10(luminosity) * log_luminosity_steps + 0.5), 32767.0));
+    }
+
+    //Returns the log10 of a packed luminosity, minus infinity if the luminosity is not positive
+    static double unpack_log_luminosity(qint16 log_luminosity)
+    {
+        if(log_luminosity == no_luminosity)
+        {
+            return -numeric_limits<double>::infinity();
+        }
+        return static_cast<double>(log_luminosity) / log_luminosity_steps;
+    }
+
+    static double unpack_luminosity(qint16 log_luminosity)
+    {
+        if(log_luminosity == no_luminosity)
+        {
+            return 0;
+        }
+        return MathFunctions::power_of(10, unpack_log_luminosity(log_luminosity));
+    }
+
+    //Pack the name, the temperature and the luminosity of the rows from 'first' to 'last'
+    template<class Iterator> static PackedColumns pack(Iterator first, Iterator last)
+    {
+        PackedColumns columns;
+        QByteArray previous_name;
+        unsigned count = 0;
+        for(Iterator it = first; it != last; ++ it, count ++)
+        {
+            const vector<QString>& row = *it;
+            double temperature = row.size() > 1 ? row[1].toDouble() : 0;
+            double luminosity = row.size() > 2 ? row[2].toDouble() : 0;
+
+            columns.temperatures.push_back(pack_temperature(temperature));
+            columns.log_luminosities.push_back(pack_luminosity(luminosity));
+            columns.spectral_types.push_back(static_cast<quint8>(StarFunctions::get_spectral_type(columns.temperatures.back())));
+
+            QByteArray name = row.empty() ? QByteArray() : row[0].toUtf8();
+            if(count % name_bucket_size == 0)
+            {
+                columns.name_buckets.push_back(static_cast<quint32>(columns.names.size()));
+                previous_name.clear();
+            }
+
+            //The shared prefix is limited to 255 bytes so that its length fits in one byte
+            int prefix = 0;
+            int max_prefix = qMin(255, qMin(name.size(), previous_name.size()));
+            while(prefix < max_prefix && name[prefix] == previous_name[prefix])
+            {
+                prefix ++;
+            }
+            columns.names.append(static_cast<char>(prefix));
+            write_length(columns.names, static_cast<quint32>(name.size() - prefix));
+            columns.names.append(name.constData() + prefix, name.size() - prefix);
+            previous_name = name;
+        }
+        return columns;
+    }
+
+    static QString get_name(const PackedColumns& columns, unsigned i)
+    {
+        int position = static_cast<int>(columns.name_buckets[i / name_bucket_size]);
+        QByteArray name;
+        for(unsigned j = 0; j <= i % name_bucket_size; j ++)
+        {
+            int prefix = static_cast<uchar>(columns.names[position ++]);
+            int suffix = static_cast<int>(read_length(columns.names, position));
+            name.truncate(prefix);
+            name.append(columns.names.constData() + position, suffix);
+            position += suffix;
+        }
+        return QString::fromUtf8(name);
+    }
+
+    //Returns the row at index 'i' in the same form as an unpacked one
+    static vector<QString> get_row(const PackedColumns& columns, unsigned i)
+    {
+        vector<QString> row;
+        row.push_back(get_name(columns, i));
+        row.push_back(QString::number(columns.temperatures[i]));
+        row.push_back(QString::number(unpack_luminosity(columns.log_luminosities[i]), 'g', 5));
+        return row;
+    }
+
+private:
+    //Lengths are written seven bits per byte, the high bit marks that another byte follows
+    static void write_length(QByteArray& data, quint32 length)
+    {
+        while(length >= 0x80)
+        {
+            data.append(static_cast<char>((length & 0x7f) | 0x80));
+            length >>= 7;
+        }
+        data.append(static_cast<char>(length));
+    }
+
+    static quint32 read_length(const QByteArray& data, int& position)
+    {
+        quint32 length = 0;
+        int shift = 0;
+        uchar byte;
+        do
+        {
+            byte = static_cast<uchar>(data[position ++]);
+            length |= static_cast<quint32>(byte & 0x7f) << shift;
+            shift += 7;
+        }
+        while(byte & 0x80);
+        return length;
+    }
+};
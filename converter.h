@@ -93,6 +93,16 @@ public:
         return spectral_type;
     }
 
+    //Returns the spectral class of a star from its temperature: '0' for 'O' to '6' for 'M', or '7' outside the 2600 K to 60000 K the table covers
+    static int get_spectral_class(double temperature)
+    {
+        if(temperature >= 2600 && temperature < 60000)
+        {
+            return get_spectral_type(static_cast<int>(temperature)) / 10 - 1;
+        }
+        return 7;
+    }
+
     //Returns the corresponding absolute magniude for a specific relative luminosity: for example 'get_absolute_magnitude(1.0)' will return '4.83'
     static double get_absolute_magnitude(double relative_luminosity)
     {
@@ -105,4 +115,28 @@ public:
         //NOTE: '2.51188643150958' is more accurate than 'MathFunctions::power_f(100, 1.0 / 5)'
         return MathFunctions::power_of(2.51188643150958, 4.83 - absolute_magnitude);
     }
+
+    //Returns the radius in solar radii from the Stefan-Boltzmann law: for example 'get_radius(5772, 1.0)' will return '1.0'
+    static double get_radius(double temperature, double relative_luminosity)
+    {
+        return std::sqrt(relative_luminosity) * MathFunctions::power_of(5772.0 / temperature, 2);
+    }
+
+    //Returns the mass in solar masses of a main sequence star from the mass-luminosity relation: for example 'get_main_sequence_mass(1.0)' will return '1.0'
+    static double get_main_sequence_mass(double relative_luminosity)
+    {
+        if(relative_luminosity < 0.033)
+        {
+            return MathFunctions::power_of(relative_luminosity / 0.23, 1 / 2.3);
+        }
+        if(relative_luminosity < 16)
+        {
+            return MathFunctions::power_of(relative_luminosity, 1 / 4.0);
+        }
+        if(relative_luminosity < 1760000)
+        {
+            return MathFunctions::power_of(relative_luminosity / 1.4, 1 / 3.5);
+        }
+        return relative_luminosity / 32000;
+    }
 };
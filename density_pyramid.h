@@ -0,0 +1,515 @@
+/*
+    DENSITY PYRAMID
+*/
+#pragma once
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QTemporaryFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "star_dataset.h"
+
+using namespace std;
+
+class DensityPyramid;
+
+//Pyramid drawn instead of the stars of the current list, 'nullptr' if the list has none
+extern shared_ptr<DensityPyramid> density_pyramid;
+
+//Class reading a quadtree of star density tiles in (temperature, log10 luminosity) space from a sidecar file
+//Level 'n' splits the whole space into 2^n by 2^n tiles of 'tile_size' by 'tile_size' bins, each bin counting the stars which fall in it
+//The file starts with "SGP2", followed by the compressed tiles which contain stars, then the index and the footer:
+//    index: maximum count of each level, then level, column, row, offset and size of each tile
+//    footer: offset of the index, number of tiles, then the number of stars, the size and the modification time in milliseconds of the list it was built from, and "SGPX"
+//Every number is little endian; a pyramid whose list has been rewritten since is not opened
+class DensityPyramid
+{
+    friend class PyramidBuilder;
+
+public:
+    static const int tile_bits = 8;
+    static const int tile_size = 1 << tile_bits;
+    //The finest level has 65536 bins along each axis, about 1 K by 0.0005 dex, so its coordinates fit in 16 bits
+    static const int level_count = 9;
+
+    //Space covered by the pyramid, the same range the compact storage can represent
+    static constexpr double temperature_range = 65536;
+    static constexpr double log_luminosity_min = -16;
+    static constexpr double log_luminosity_range = 32;
+
+    DensityPyramid() : dataset_version(0)
+    {
+    }
+
+    //Returns the path of the pyramid which belongs to the list 'list_path'
+    static QString get_pyramid_path(QString list_path)
+    {
+        return list_path + ".pyramid";
+    }
+
+    //Delete the pyramid of the list 'list_path', which is rewritten
+    static void remove(QString list_path)
+    {
+        QFile::remove(get_pyramid_path(list_path));
+    }
+
+    //Open the pyramid of the list 'list_path', only if it was built from the file as it is now, holding 'row_count' stars
+    bool open(QString list_path, quint64 row_count)
+    {
+        pyramid_file.setFileName(get_pyramid_path(list_path));
+        if(!pyramid_file.open(QIODevice::ReadOnly) || pyramid_file.size() < 44 || pyramid_file.read(4) != "SGP2")
+        {
+            return false;
+        }
+
+        pyramid_file.seek(pyramid_file.size() - 40);
+        QByteArray footer = pyramid_file.read(40);
+        const uchar* footer_data = reinterpret_cast<const uchar*>(footer.constData());
+        QFileInfo list_info(list_path);
+        if(footer.mid(36) != "SGPX" || qFromLittleEndian<quint64>(footer_data + 12) != row_count || static_cast<qint64>(qFromLittleEndian<quint64>(footer_data + 20)) != list_info.size() || static_cast<qint64>(qFromLittleEndian<quint64>(footer_data + 28)) != list_info.lastModified().toMSecsSinceEpoch())
+        {
+            return false;
+        }
+        qint64 index_offset = static_cast<qint64>(qFromLittleEndian<quint64>(footer_data));
+        quint32 tile_count = qFromLittleEndian<quint32>(footer_data + 8);
+
+        pyramid_file.seek(index_offset);
+        QByteArray index = pyramid_file.read(level_count * 4 + static_cast<qint64>(tile_count) * 24);
+        if(index.size() != static_cast<int>(level_count * 4 + tile_count * 24))
+        {
+            return false;
+        }
+
+        const uchar* index_data = reinterpret_cast<const uchar*>(index.constData());
+        for(int level = 0; level < level_count; level ++)
+        {
+            max_counts[level] = qFromLittleEndian<quint32>(index_data + level * 4);
+        }
+        index_data += level_count * 4;
+        for(quint32 i = 0; i < tile_count; i ++, index_data += 24)
+        {
+            TileEntry entry;
+            entry.offset = static_cast<qint64>(qFromLittleEndian<quint64>(index_data + 12));
+            entry.size = qFromLittleEndian<quint32>(index_data + 20);
+            tiles.insert(get_tile_key(static_cast<int>(qFromLittleEndian<quint32>(index_data)), static_cast<int>(qFromLittleEndian<quint32>(index_data + 4)), static_cast<int>(qFromLittleEndian<quint32>(index_data + 8))), entry);
+        }
+        return true;
+    }
+
+    //Snapshot the pyramid was built from: once the list is changed the stars are drawn again
+    unsigned get_dataset_version() const
+    {
+        return dataset_version;
+    }
+
+    void set_dataset_version(unsigned version)
+    {
+        dataset_version = version;
+    }
+
+    quint32 get_max_count(int level) const
+    {
+        return max_counts[level];
+    }
+
+    bool has_tile(int level, int column, int row) const
+    {
+        return tiles.contains(get_tile_key(level, column, row));
+    }
+
+    //Read the bins of a tile, row by row from the lowest luminosity; returns an empty vector if the tile has no stars
+    vector<quint32> load_tile(int level, int column, int row)
+    {
+        vector<quint32> counts;
+        QHash<quint64, TileEntry>::const_iterator entry = tiles.constFind(get_tile_key(level, column, row));
+        if(entry == tiles.constEnd())
+        {
+            return counts;
+        }
+
+        pyramid_file.seek(entry.value().offset);
+        QByteArray tile_data = qUncompress(pyramid_file.read(entry.value().size));
+        if(tile_data.size() != tile_size * tile_size * 4)
+        {
+            return counts;
+        }
+        counts.resize(tile_size * tile_size);
+        for(int i = 0; i < tile_size * tile_size; i ++)
+        {
+            counts[static_cast<unsigned>(i)] = qFromLittleEndian<quint32>(reinterpret_cast<const uchar*>(tile_data.constData()) + i * 4);
+        }
+        return counts;
+    }
+
+    //Returns the coarsest level which still has at least one bin per pixel over the window, so the tiles read only depend on the size of the screen
+    static int choose_level(double temp_window, double lum_window, double pixels_x, double pixels_y)
+    {
+        for(int level = 0; level < level_count; level ++)
+        {
+            double bins = tile_size * pow(2.0, level);
+            if(bins * temp_window / temperature_range >= pixels_x && bins * lum_window / log_luminosity_range >= pixels_y)
+            {
+                return level;
+            }
+        }
+        return level_count - 1;
+    }
+
+    static double get_tile_temperature_width(int level)
+    {
+        return temperature_range / pow(2.0, level);
+    }
+
+    static double get_tile_luminosity_height(int level)
+    {
+        return log_luminosity_range / pow(2.0, level);
+    }
+
+private:
+    struct TileEntry
+    {
+        qint64 offset;
+        quint32 size;
+    };
+
+    static quint64 get_tile_key(int level, int column, int row)
+    {
+        return (static_cast<quint64>(level) << 48) | (static_cast<quint64>(column) << 24) | static_cast<quint64>(row);
+    }
+
+    //Spread the 16 low bits of 'value' to the even bits of the result
+    static quint32 interleave(quint32 value)
+    {
+        value &= 0x0000ffff;
+        value = (value | (value << 8)) & 0x00ff00ff;
+        value = (value | (value << 4)) & 0x0f0f0f0f;
+        value = (value | (value << 2)) & 0x33333333;
+        return (value | (value << 1)) & 0x55555555;
+    }
+
+    //Gather the even bits of 'value', the inverse of 'interleave()'
+    static quint32 deinterleave(quint32 value)
+    {
+        value &= 0x55555555;
+        value = (value | (value >> 1)) & 0x33333333;
+        value = (value | (value >> 2)) & 0x0f0f0f0f;
+        value = (value | (value >> 4)) & 0x00ff00ff;
+        return (value | (value >> 8)) & 0x0000ffff;
+    }
+
+    template<class T> static void append_number(QByteArray& data, T value)
+    {
+        uchar bytes[sizeof(T)];
+        qToLittleEndian<T>(value, bytes);
+        data.append(reinterpret_cast<const char*>(bytes), sizeof(T));
+    }
+
+    QFile pyramid_file;
+    QHash<quint64, TileEntry> tiles;
+    quint32 max_counts[level_count];
+    unsigned dataset_version;
+};
+
+//Codes of stars spilled to temporary files, one file for each value of the 8 bits of the code above 'shift'
+//Only a buffer of each file is kept in memory, so the stars of a part of the space can be read back together however many there are
+class CodeSpill
+{
+public:
+    static const int bucket_count = 256;
+    static const int buffer_codes = 16 * 1024;
+
+    explicit CodeSpill(int bucket_shift) : shift(bucket_shift), failed(false), memory(io_memory)
+    {
+    }
+
+    void add(quint32 code)
+    {
+        int bucket = static_cast<int>((code >> shift) & (bucket_count - 1));
+        vector<quint32>& buffer = buffers[bucket];
+        if(buffer.capacity() == 0)
+        {
+            buffer.reserve(buffer_codes);
+            memory.set(memory.get() + buffer_codes * static_cast<qint64>(sizeof(quint32)));
+        }
+        buffer.push_back(code);
+        if(buffer.size() == static_cast<unsigned>(buffer_codes))
+        {
+            flush(bucket);
+        }
+    }
+
+    //Write the codes still buffered and go back to the start of each file, returns false if a file could not be written
+    bool finish()
+    {
+        for(int bucket = 0; bucket < bucket_count; bucket ++)
+        {
+            flush(bucket);
+            vector<quint32>().swap(buffers[bucket]);
+            if(files[bucket])
+            {
+                failed = failed || !files[bucket]->seek(0);
+            }
+        }
+        memory.set(0);
+        return !failed;
+    }
+
+    //Read the next codes of 'bucket', at most 'buffer_codes' at a time; returns false once the bucket has been read whole
+    bool read(int bucket, vector<quint32>& codes)
+    {
+        codes.clear();
+        if(!files[bucket])
+        {
+            return false;
+        }
+        QByteArray data = files[bucket]->read(buffer_codes * static_cast<qint64>(sizeof(quint32)));
+        codes.resize(static_cast<unsigned>(data.size()) / sizeof(quint32));
+        memcpy(codes.data(), data.constData(), codes.size() * sizeof(quint32));
+        return !codes.empty();
+    }
+
+private:
+    void flush(int bucket)
+    {
+        vector<quint32>& buffer = buffers[bucket];
+        if(buffer.empty() || failed)
+        {
+            buffer.clear();
+            return;
+        }
+        if(!files[bucket])
+        {
+            files[bucket].reset(new QTemporaryFile());
+            failed = !files[bucket]->open();
+        }
+        qint64 size = static_cast<qint64>(buffer.size() * sizeof(quint32));
+        failed = failed || files[bucket]->write(reinterpret_cast<const char*>(buffer.data()), size) != size;
+        buffer.clear();
+    }
+
+    int shift;
+    bool failed;
+    vector<quint32> buffers[bucket_count];
+    unique_ptr<QTemporaryFile> files[bucket_count];
+    MemoryCounter memory;
+};
+
+//Class building a density pyramid from stars given one at a time, with a bounded amount of memory whatever the number of stars
+//Each star gets the Z-order code of its bin at the finest level; the codes are spilled to temporary files by their top 8 bits, then each of those files by the next 8 bits, which are the finest tiles
+//The finest tiles are then counted one at a time in Z-order, and each one is added to its parent, so a tile of a coarser level is complete and written as soon as the next tile of the finer level belongs to another parent
+//At most two spills of buffers and one tile for each level are in memory, the codes are read from and written to the temporary files twice
+class PyramidBuilder
+{
+public:
+    PyramidBuilder() : star_count(0), code_spill(2 * (DensityPyramid::level_count - 1 + DensityPyramid::tile_bits) - 8), tile_count(0), written(true), memory(io_memory)
+    {
+        for(int level = 0; level < DensityPyramid::level_count; level ++)
+        {
+            pending[level] = false;
+            max_counts[level] = 0;
+        }
+    }
+
+    //Build the pyramid of the stars of 'dataset' next to 'list_path', reading one chunk at a time
+    //'list_size' and 'list_modified' are read from the list before the build starts, so a list rewritten meanwhile does not match its pyramid
+    static bool build(DatasetSnapshot dataset, QString list_path, qint64 list_size, qint64 list_modified)
+    {
+        PyramidBuilder builder;
+        for(unsigned c = 0; c < dataset->get_chunk_count(); c ++)
+        {
+            shared_ptr<const StarChunk> chunk = dataset->get_chunk(c);
+            for(unsigned i = 0; i < chunk->size(); i ++)
+            {
+                builder.add_star(chunk->get_temperature(i), chunk->get_log_luminosity(i));
+            }
+        }
+        return builder.write(list_path, list_size, list_modified);
+    }
+
+    void add_star(double temperature, double log_luminosity)
+    {
+        int side = DensityPyramid::tile_size << (DensityPyramid::level_count - 1);
+        star_count ++;
+        int column = static_cast<int>(floor(temperature / DensityPyramid::temperature_range * side));
+        int row = static_cast<int>(floor((log_luminosity - DensityPyramid::log_luminosity_min) / DensityPyramid::log_luminosity_range * side));
+        if(std::isinf(log_luminosity) || column < 0 || column >= side || row < 0 || row >= side)
+        {
+            return;
+        }
+        code_spill.add(DensityPyramid::interleave(static_cast<quint32>(column)) | (DensityPyramid::interleave(static_cast<quint32>(row)) << 1));
+    }
+
+    //Write the pyramid of the stars added so far next to 'list_path', with the size and the modification time of the list
+    bool write(QString list_path, qint64 list_size, qint64 list_modified)
+    {
+        QString file_name = DensityPyramid::get_pyramid_path(list_path);
+        if(!code_spill.finish())
+        {
+            return false;
+        }
+        pyramid_out.setFileName(file_name);
+        if(!pyramid_out.open(QIODevice::WriteOnly))
+        {
+            return false;
+        }
+        written = pyramid_out.write("SGP2", 4) == 4;
+
+        int tile_area = DensityPyramid::tile_size * DensityPyramid::tile_size;
+        memory.set(static_cast<qint64>(DensityPyramid::level_count + 1) * tile_area * static_cast<qint64>(sizeof(quint32)));
+        vector<quint32> codes;
+        vector<quint32> counts(static_cast<unsigned>(tile_area));
+        for(int region = 0; region < CodeSpill::bucket_count && written; region ++)
+        {
+            //The codes of the region are split by finest tile, each tile is then read on its own
+            CodeSpill tile_spill(2 * DensityPyramid::tile_bits);
+            while(code_spill.read(region, codes))
+            {
+                for(unsigned i = 0; i < codes.size(); i ++)
+                {
+                    tile_spill.add(codes[i]);
+                }
+            }
+            written = tile_spill.finish();
+
+            for(int tile = 0; tile < CodeSpill::bucket_count && written; tile ++)
+            {
+                bool has_stars = false;
+                fill(counts.begin(), counts.end(), 0);
+                while(tile_spill.read(tile, codes))
+                {
+                    has_stars = true;
+                    for(unsigned i = 0; i < codes.size(); i ++)
+                    {
+                        quint32 bin_code = codes[i] & ((1 << (2 * DensityPyramid::tile_bits)) - 1);
+                        quint32& bin = counts[DensityPyramid::deinterleave(bin_code >> 1) * DensityPyramid::tile_size + DensityPyramid::deinterleave(bin_code)];
+                        if(bin != 0xffffffff)
+                        {
+                            bin ++;
+                        }
+                    }
+                }
+                if(has_stars)
+                {
+                    add_tile(DensityPyramid::level_count - 1, static_cast<quint32>(region * CodeSpill::bucket_count + tile), counts);
+                }
+            }
+        }
+
+        //The last tile of each coarser level is complete once every finest tile has been added
+        for(int level = DensityPyramid::level_count - 2; level >= 0; level --)
+        {
+            if(pending[level])
+            {
+                pending[level] = false;
+                add_tile(level, parent_codes[level], parents[level]);
+            }
+        }
+        memory.set(0);
+
+        QByteArray max_count_data;
+        for(int level = 0; level < DensityPyramid::level_count; level ++)
+        {
+            DensityPyramid::append_number<quint32>(max_count_data, max_counts[level]);
+        }
+        QByteArray footer;
+        DensityPyramid::append_number<quint64>(footer, static_cast<quint64>(pyramid_out.pos()));
+        DensityPyramid::append_number<quint32>(footer, tile_count);
+        DensityPyramid::append_number<quint64>(footer, star_count);
+        DensityPyramid::append_number<quint64>(footer, static_cast<quint64>(list_size));
+        DensityPyramid::append_number<quint64>(footer, static_cast<quint64>(list_modified));
+        footer.append("SGPX", 4);
+        written = written && pyramid_out.write(max_count_data) == max_count_data.size() && pyramid_out.write(index) == index.size() && pyramid_out.write(footer) == footer.size();
+        pyramid_out.close();
+        if(!written)
+        {
+            QFile::remove(file_name);
+        }
+        return written;
+    }
+
+private:
+    //Write the tile 'code' of 'level', whose stars have all been counted, and add its bins to its parent
+    void add_tile(int level, quint32 code, const vector<quint32>& counts)
+    {
+        write_tile(level, code, counts);
+        if(level == 0)
+        {
+            return;
+        }
+
+        //The parent is written once a tile of another parent comes, since the tiles come in Z-order
+        int parent_level = level - 1;
+        if(pending[parent_level] && parent_codes[parent_level] != code >> 2)
+        {
+            pending[parent_level] = false;
+            add_tile(parent_level, parent_codes[parent_level], parents[parent_level]);
+        }
+        if(!pending[parent_level])
+        {
+            pending[parent_level] = true;
+            parent_codes[parent_level] = code >> 2;
+            parents[parent_level].assign(DensityPyramid::tile_size * DensityPyramid::tile_size, 0);
+        }
+
+        //Each bin of the parent covers two by two bins of one of its four children
+        int half = DensityPyramid::tile_size / 2;
+        int offset_x = static_cast<int>(code & 1) * half;
+        int offset_y = static_cast<int>((code >> 1) & 1) * half;
+        vector<quint32>& parent = parents[parent_level];
+        for(int y = 0; y < DensityPyramid::tile_size; y ++)
+        {
+            for(int x = 0; x < DensityPyramid::tile_size; x ++)
+            {
+                quint32& bin = parent[static_cast<unsigned>((offset_y + y / 2) * DensityPyramid::tile_size + offset_x + x / 2)];
+                quint32 count = counts[static_cast<unsigned>(y * DensityPyramid::tile_size + x)];
+                bin = count > 0xffffffff - bin ? 0xffffffff : bin + count;
+            }
+        }
+    }
+
+    void write_tile(int level, quint32 code, const vector<quint32>& counts)
+    {
+        if(!written)
+        {
+            return;
+        }
+        int tile_area = DensityPyramid::tile_size * DensityPyramid::tile_size;
+        QByteArray tile_data(tile_area * 4, '\0');
+        for(int b = 0; b < tile_area; b ++)
+        {
+            max_counts[level] = max(max_counts[level], counts[static_cast<unsigned>(b)]);
+            qToLittleEndian<quint32>(counts[static_cast<unsigned>(b)], reinterpret_cast<uchar*>(tile_data.data()) + b * 4);
+        }
+        QByteArray compressed = qCompress(tile_data);
+        DensityPyramid::append_number<quint32>(index, static_cast<quint32>(level));
+        DensityPyramid::append_number<quint32>(index, DensityPyramid::deinterleave(code));
+        DensityPyramid::append_number<quint32>(index, DensityPyramid::deinterleave(code >> 1));
+        DensityPyramid::append_number<quint64>(index, static_cast<quint64>(pyramid_out.pos()));
+        DensityPyramid::append_number<quint32>(index, static_cast<quint32>(compressed.size()));
+        written = pyramid_out.write(compressed) == compressed.size();
+        tile_count ++;
+    }
+
+    quint64 star_count;
+    CodeSpill code_spill;
+
+    QFile pyramid_out;
+    QByteArray index;
+    quint32 tile_count;
+    quint32 max_counts[DensityPyramid::level_count];
+    bool written;
+
+    //Tile of each coarser level which its children are being added to
+    bool pending[DensityPyramid::level_count];
+    quint32 parent_codes[DensityPyramid::level_count];
+    vector<quint32> parents[DensityPyramid::level_count];
+    MemoryCounter memory;
+};
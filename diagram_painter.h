@@ -0,0 +1,189 @@
+/*
+    DIAGRAM PAINTER
+*/
+#pragma once
+
+#include <QColor>
+#include <QFont>
+#include <QFontDatabase>
+#include <QLine>
+#include <QPainter>
+#include <cmath>
+#include <vector>
+
+#include "diagram_projection.h"
+#include "star_dataset.h"
+
+using namespace std;
+
+//Class containing the parts of the drawing which only need a painter or plain geometry, shared by the OpenGL widget, the exporters and the offscreen renderer
+//Nothing here depends on the widgets or on OpenGL, and nothing reads the current settings: every function is given the view to draw, so it can run on any thread
+class DiagramPainterFunctions
+{
+public:
+    //Returns the four lines which compose the frame of 'view'
+    static vector<QLine> get_frame_lines(const DiagramView& view, int offset)
+    {
+        vector<QLine> lines;
+
+        //Top line
+        lines.push_back(QLine(offset, offset, view.width - offset, offset));
+        //Bottom line
+        lines.push_back(QLine(offset, view.height - offset, view.width - offset, view.height - offset));
+        //Left line
+        lines.push_back(QLine(offset, offset, offset, view.height - offset));
+        //Right line
+        lines.push_back(QLine(view.width - offset, offset, view.width - offset, view.height - offset));
+
+        return lines;
+    }
+
+    //Returns the reference lines, in the coordinates of the inner drawing area
+    static vector<QLine> get_reference_lines(const DiagramView& view, bool vertical, bool horizontal, int h_step,  int v_step)
+    {
+        vector<QLine> lines;
+        const ProjectionKernels& projection = ProjectionFunctions::get_kernels(view.projection);
+
+        //If vertical reference lines are enabled, their position is calculated from the value of 'h_step'
+        if(vertical)
+        {
+            AxisScale x_scale = projection.get_x_scale(view);
+            vector<double> values = projection.get_x_reference_values(h_step);
+            for(unsigned i = 0; i < values.size(); i ++)
+            {
+                int line_x = static_cast<int>(x_scale.get_position(values[i]));
+
+                lines.push_back(QLine(line_x, 0, line_x, view.height));
+            }
+        }
+        //If horizontal reference lines are enabled, their position is calculated from the value of 'v_step', on both sides of a split axis
+        if(horizontal)
+        {
+            AxisScale y_scale = projection.get_y_scale(view);
+            vector<double> values = projection.get_y_reference_values(v_step);
+            for(unsigned i = 0; i < values.size(); i ++)
+            {
+                int line_y = static_cast<int>(y_scale.get_position(values[i]));
+
+                lines.push_back(QLine(0, line_y, view.width, line_y));
+            }
+        }
+
+        return lines;
+    }
+
+    //Draw 'lines' using the pen of 'painter'
+    static void draw_lines(QPainter& painter, const vector<QLine>& lines)
+    {
+        for(unsigned i = 0; i < lines.size(); i ++)
+        {
+            painter.drawLine(lines[i]);
+        }
+    }
+
+    //Returns the colour of a star from its temperature
+    static QColor get_star_colour(double star_temperature)
+    {
+        double col = (1.0 / 13000) * (star_temperature - 3000);
+
+        //The drawing colour is calculated from the value of 'col' using RGB, clamped the same way OpenGL does
+        return QColor::fromRgbF(qBound(0.0, 1 - col, 1.0), qBound(0.0, (col / 2) + 0.5, 1.0), qBound(0.0, col, 1.0));
+    }
+
+    //Draw the scale text of 'view' using 'painter'
+    static void draw_scale_text(QPainter& painter, const DiagramView& view)
+    {
+        //The bundled font is loaded once by the first thread drawing the scale, and the family is looked up by name if it is not there
+        //It is a resource of the core library, which has to be registered explicitly since the library is static
+        static const int font_id = []()
+        {
+            Q_INIT_RESOURCE(fonts);
+            return QFontDatabase::addApplicationFont(":/fonts/XITSMath-Regular.otf");
+        }();
+        Q_UNUSED(font_id);
+
+        //Set the font to use
+        QFont scale_font("XITS Math", 12);
+        painter.setFont(scale_font);
+
+        //Draw the text, the titles and the bounds of the axes depend on the projection
+        const ProjectionKernels& projection = ProjectionFunctions::get_kernels(view.projection);
+        painter.drawText(2, 312, projection.get_y_title());
+        painter.drawText(8, 32, projection.get_y_start_label(view));
+        painter.drawText(8, 608, projection.get_y_end_label(view));
+
+        painter.drawText(288, 632, projection.get_x_title());
+        painter.drawText(8, 632, projection.get_x_start_label(view));
+        painter.drawText(576, 632, projection.get_x_end_label(view));
+    }
+
+    //Draw the names of the stars in 'view' using 'painter', whose viewport matches the inner drawing area
+    static void draw_star_name_labels(QPainter& painter, const DiagramView& view, const StarDataset& list)
+    {
+        //Set the font to use
+        QFont graph_font("Verdana", 10);
+        painter.setFont(graph_font);
+
+        vector<double> xs(StarDataset::chunk_size);
+        vector<double> ys(StarDataset::chunk_size);
+        for(unsigned c = 0; c < list.get_chunk_count(); c++)
+        {
+            shared_ptr<const StarChunk> chunk = list.get_chunk(c);
+            ProjectionFunctions::project_chunk(view, *chunk, xs.data(), ys.data());
+            for(unsigned i = 0; i < chunk->size(); i++)
+            {
+                if(!ProjectionFunctions::is_finite(xs[i], ys[i]))
+                {
+                    continue;
+                }
+
+                //Calculate the position of the label
+                int star_x = static_cast<int>(xs[i]) + 8;
+                int star_y = static_cast<int>(ys[i]) + 8;
+
+                //Draw the text
+                painter.drawText(star_x, star_y, chunk->get_name(i));
+            }
+        }
+    }
+
+    //Draw every star of 'list' in 'view' as a 'point_size' square or circle, using 'painter' whose viewport matches the inner drawing area
+    //Unlike the vector exporter the stars are not merged, a raster image costs the same whatever is drawn on it
+    static void draw_star_points(QPainter& painter, const DiagramView& view, const StarDataset& list, bool temperature_colour, QColor colour, bool round_markers, double point_size)
+    {
+        painter.save();
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(colour);
+        painter.setRenderHint(QPainter::Antialiasing, round_markers);
+
+        vector<double> xs(StarDataset::chunk_size);
+        vector<double> ys(StarDataset::chunk_size);
+        for(unsigned c = 0; c < list.get_chunk_count(); c++)
+        {
+            shared_ptr<const StarChunk> chunk = list.get_chunk(c);
+            ProjectionFunctions::project_chunk(view, *chunk, xs.data(), ys.data());
+            for(unsigned i = 0; i < chunk->size(); i++)
+            {
+                if(!ProjectionFunctions::is_finite(xs[i], ys[i]))
+                {
+                    continue;
+                }
+                if(temperature_colour)
+                {
+                    painter.setBrush(get_star_colour(chunk->get_temperature(i)));
+                }
+
+                QRectF point(xs[i] - point_size / 2, ys[i] - point_size / 2, point_size, point_size);
+                if(round_markers)
+                {
+                    painter.drawEllipse(point);
+                }
+                else
+                {
+                    painter.drawRect(point);
+                }
+            }
+        }
+        painter.restore();
+    }
+};
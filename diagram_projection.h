@@ -0,0 +1,460 @@
+/*
+    DIAGRAM PROJECTION
+*/
+#pragma once
+
+#include <QPointF>
+#include <QString>
+#include <QStringList>
+#include <cmath>
+#include <vector>
+
+#include "converter.h"
+#include "star_dataset.h"
+
+using namespace std;
+
+//Declare the ranges and the size of the diagram
+extern int temp_min, temp_max, lum_min, lum_max, diagram_height, diagram_width;
+
+//Quantities shown on the two axes of the diagram
+enum DiagramProjection
+{
+    //Temperature against luminosity
+    hr_projection,
+    //log10 of the temperature against luminosity
+    log_temperature_projection,
+    //B-V colour index against absolute magnitude
+    colour_magnitude_projection,
+    //log10 of the temperature against log10 of the surface gravity
+    kiel_projection
+};
+
+extern DiagramProjection diagram_projection;
+
+//Ranges of the axes, size and projection of a diagram
+//The threads drawing or projecting stars are given a copy, so they never read the settings while the GUI thread changes them
+struct DiagramView
+{
+    int temperature_min;
+    int temperature_max;
+    int luminosity_min;
+    int luminosity_max;
+    int width;
+    int height;
+    DiagramProjection projection;
+};
+
+//Affine transformation from the value of an axis to a position on the diagram, with a different scale on each side of 'pivot'
+struct AxisScale
+{
+    double origin;
+    double pivot;
+    //Scale below and above the pivot, the same one for the axes which are not split
+    double scales[2];
+
+    //Selecting the scale by index keeps the projection loops free of branches
+    double get_position(double value) const
+    {
+        return origin + scales[value >= pivot] * (value - pivot);
+    }
+};
+
+//Axis policies: each one has the value of a star on the axis, its scale, its reference lines and its labels
+//The horizontal axes run from the highest temperature of the view on the left to the lowest one on the right
+struct TemperatureAxis
+{
+    static double get_value(double temperature, double)
+    {
+        return temperature;
+    }
+
+    static double get_start(const DiagramView& view)
+    {
+        return view.temperature_max;
+    }
+
+    static double get_end(const DiagramView& view)
+    {
+        return view.temperature_min;
+    }
+
+    static vector<double> get_reference_values(int step)
+    {
+        vector<double> values;
+        for(int i = 0; i < 50; i ++)
+        {
+            values.push_back(static_cast<double>(step) * i);
+        }
+        return values;
+    }
+
+    static QString get_title()
+    {
+        return "Temperature";
+    }
+
+    static QString get_label(double value)
+    {
+        return QString::number(value) + " K";
+    }
+};
+
+struct LogTemperatureAxis
+{
+    static double get_value(double temperature, double)
+    {
+        return MathFunctions::log_base_10(temperature);
+    }
+
+    static double get_start(const DiagramView& view)
+    {
+        return MathFunctions::log_base_10(view.temperature_max);
+    }
+
+    static double get_end(const DiagramView& view)
+    {
+        return MathFunctions::log_base_10(view.temperature_min);
+    }
+
+    //Lines at the same temperatures as on the linear axis
+    static vector<double> get_reference_values(int step)
+    {
+        vector<double> values;
+        for(int i = 1; i < 50; i ++)
+        {
+            values.push_back(MathFunctions::log_base_10(static_cast<double>(step) * i));
+        }
+        return values;
+    }
+
+    static QString get_title()
+    {
+        return "log T";
+    }
+
+    static QString get_label(double value)
+    {
+        return QString::number(value, 'f', 2);
+    }
+};
+
+struct ColourIndexAxis
+{
+    //B-V colour index from the temperature, inverting Ballesteros' formula T = 4600 K * (1 / (0.92 (B-V) + 1.7) + 1 / (0.92 (B-V) + 0.62))
+    static double get_value(double temperature, double)
+    {
+        double k = temperature / 4600;
+        return (2 - 2.32 * k + std::sqrt(1.1664 * k * k + 4)) / (2 * k) / 0.92;
+    }
+
+    static double get_start(const DiagramView& view)
+    {
+        return get_value(view.temperature_max, 0);
+    }
+
+    static double get_end(const DiagramView& view)
+    {
+        return get_value(view.temperature_min, 0);
+    }
+
+    static vector<double> get_reference_values(int step)
+    {
+        vector<double> values;
+        for(int i = 1; i < 50; i ++)
+        {
+            values.push_back(get_value(static_cast<double>(step) * i, 0));
+        }
+        return values;
+    }
+
+    static QString get_title()
+    {
+        return "B-V";
+    }
+
+    static QString get_label(double value)
+    {
+        return QString::number(value, 'f', 2);
+    }
+};
+
+//The vertical axes run from their start at the top to their end at the bottom
+//The luminosity axis has the highest luminosity of the view at the top and the lowest one at the bottom, with a different scale above and below a luminosity of 1
+struct LuminosityAxis
+{
+    static double get_value(double, double log_luminosity)
+    {
+        return log_luminosity;
+    }
+
+    static AxisScale get_scale(const DiagramView& view, double length)
+    {
+        AxisScale scale = { view.height / 2.0, 0, { length / view.luminosity_min, -length / view.luminosity_max } };
+        return scale;
+    }
+
+    static vector<double> get_reference_values(int step)
+    {
+        vector<double> values;
+        for(int i = 0; i < 8; i ++)
+        {
+            values.push_back(i * MathFunctions::log_base_10(step));
+            values.push_back(-i * MathFunctions::log_base_10(step));
+        }
+        return values;
+    }
+
+    static QString get_title()
+    {
+        return "logL";
+    }
+
+    static QString get_start_label(const DiagramView& view)
+    {
+        return QString::number(view.luminosity_max);
+    }
+
+    static QString get_end_label(const DiagramView& view)
+    {
+        return QString::number(view.luminosity_min);
+    }
+};
+
+//Absolute magnitude as in 'StarFunctions::get_absolute_magnitude()', covering the same luminosities as the luminosity axis
+struct MagnitudeAxis
+{
+    static double get_value(double, double log_luminosity)
+    {
+        return 4.83 - 2.51188643150958 * log_luminosity;
+    }
+
+    static AxisScale get_scale(const DiagramView& view, double length)
+    {
+        double start = get_value(0, view.luminosity_max);
+        AxisScale scale = { 0, start, { length / (get_value(0, view.luminosity_min) - start), length / (get_value(0, view.luminosity_min) - start) } };
+        return scale;
+    }
+
+    //Lines at the same luminosities as on the luminosity axis
+    static vector<double> get_reference_values(int step)
+    {
+        vector<double> values = LuminosityAxis::get_reference_values(step);
+        for(unsigned i = 0; i < values.size(); i ++)
+        {
+            values[i] = get_value(0, values[i]);
+        }
+        return values;
+    }
+
+    static QString get_title()
+    {
+        return "M";
+    }
+
+    static QString get_start_label(const DiagramView& view)
+    {
+        return QString::number(get_value(0, view.luminosity_max), 'f', 1);
+    }
+
+    static QString get_end_label(const DiagramView& view)
+    {
+        return QString::number(get_value(0, view.luminosity_min), 'f', 1);
+    }
+};
+
+//log10 of the surface gravity in cm/s^2, from the radius and the main sequence mass of the table: log g = 4.438 + log M - 2 log R
+//Giants are at the top, white dwarfs at the bottom
+struct GravityAxis
+{
+    static constexpr double log_gravity_min = -1;
+    static constexpr double log_gravity_max = 9;
+
+    static double get_value(double temperature, double log_luminosity)
+    {
+        double luminosity = MathFunctions::power_of(10, log_luminosity);
+        return 4.438 + MathFunctions::log_base_10(StarFunctions::get_main_sequence_mass(luminosity)) - 2 * MathFunctions::log_base_10(StarFunctions::get_radius(temperature, luminosity));
+    }
+
+    static AxisScale get_scale(const DiagramView&, double length)
+    {
+        AxisScale scale = { 0, log_gravity_min, { length / (log_gravity_max - log_gravity_min), length / (log_gravity_max - log_gravity_min) } };
+        return scale;
+    }
+
+    static vector<double> get_reference_values(int)
+    {
+        vector<double> values;
+        for(int i = static_cast<int>(log_gravity_min); i <= static_cast<int>(log_gravity_max); i ++)
+        {
+            values.push_back(i);
+        }
+        return values;
+    }
+
+    static QString get_title()
+    {
+        return "log g";
+    }
+
+    static QString get_start_label(const DiagramView&)
+    {
+        return QString::number(log_gravity_min);
+    }
+
+    static QString get_end_label(const DiagramView&)
+    {
+        return QString::number(log_gravity_max);
+    }
+};
+
+//Functions of a projection, each one specialized for its pair of axes
+struct ProjectionKernels
+{
+    void (*get_values)(const StarChunk& chunk, double* x_values, double* y_values);
+    void (*project_chunk)(const DiagramView& view, const StarChunk& chunk, double* xs, double* ys);
+    QPointF (*project_star)(const DiagramView& view, double temperature, double log_luminosity);
+    AxisScale (*get_x_scale)(const DiagramView& view);
+    AxisScale (*get_y_scale)(const DiagramView& view);
+    vector<double> (*get_x_reference_values)(int step);
+    vector<double> (*get_y_reference_values)(int step);
+    QString (*get_x_title)();
+    QString (*get_y_title)();
+    QString (*get_x_start_label)(const DiagramView& view);
+    QString (*get_x_end_label)(const DiagramView& view);
+    QString (*get_y_start_label)(const DiagramView& view);
+    QString (*get_y_end_label)(const DiagramView& view);
+};
+
+//Projection of the stars onto the inner drawing area, the same coordinates used by the OpenGL widget, the painters and the selection
+//The horizontal axis spans the width of the view minus 64 and the vertical one its height minus 64, as the temperature and luminosity axes always have
+//Stars without a positive temperature or luminosity have positions which are not finite
+template<class XAxis, class YAxis> class Projection
+{
+public:
+    static void get_values(const StarChunk& chunk, double* x_values, double* y_values)
+    {
+        unsigned count = chunk.size();
+        for(unsigned i = 0; i < count; i ++)
+        {
+            double temperature = chunk.get_temperature(i);
+            double log_luminosity = chunk.get_log_luminosity(i);
+            x_values[i] = XAxis::get_value(temperature, log_luminosity);
+            y_values[i] = YAxis::get_value(temperature, log_luminosity);
+        }
+    }
+
+    static void project_chunk(const DiagramView& view, const StarChunk& chunk, double* xs, double* ys)
+    {
+        get_values(chunk, xs, ys);
+        AxisScale x_scale = get_x_scale(view);
+        AxisScale y_scale = get_y_scale(view);
+        unsigned count = chunk.size();
+        for(unsigned i = 0; i < count; i ++)
+        {
+            xs[i] = x_scale.get_position(xs[i]);
+            ys[i] = y_scale.get_position(ys[i]);
+        }
+    }
+
+    static QPointF project_star(const DiagramView& view, double temperature, double log_luminosity)
+    {
+        return QPointF(get_x_scale(view).get_position(XAxis::get_value(temperature, log_luminosity)), get_y_scale(view).get_position(YAxis::get_value(temperature, log_luminosity)));
+    }
+
+    //The start of the horizontal axis is at '0' and its end at the width of the view minus 64
+    static AxisScale get_x_scale(const DiagramView& view)
+    {
+        double length = view.width - 64;
+        double start = XAxis::get_start(view);
+        double end = XAxis::get_end(view);
+        AxisScale scale = { 0, start, { length / (end - start), length / (end - start) } };
+        return scale;
+    }
+
+    static AxisScale get_y_scale(const DiagramView& view)
+    {
+        return YAxis::get_scale(view, view.height - 64);
+    }
+
+    static QString get_x_start_label(const DiagramView& view)
+    {
+        return XAxis::get_label(XAxis::get_start(view));
+    }
+
+    static QString get_x_end_label(const DiagramView& view)
+    {
+        return XAxis::get_label(XAxis::get_end(view));
+    }
+
+    static ProjectionKernels get_kernels()
+    {
+        ProjectionKernels kernels = { get_values, project_chunk, project_star, get_x_scale, get_y_scale, XAxis::get_reference_values, YAxis::get_reference_values, XAxis::get_title, YAxis::get_title, get_x_start_label, get_x_end_label, YAxis::get_start_label, YAxis::get_end_label };
+        return kernels;
+    }
+};
+
+//Class containing the functions used to project the stars with the current projection
+//The projection is chosen once per call, so the loop over the stars of a chunk is specialized for its axes
+//The functions without a view read the current settings and are only called on the GUI thread, the other threads are given a view
+class ProjectionFunctions
+{
+public:
+    //Returns the current ranges, size and projection of the diagram
+    static DiagramView get_view()
+    {
+        DiagramView view = { temp_min, temp_max, lum_min, lum_max, diagram_width, diagram_height, diagram_projection };
+        return view;
+    }
+
+    static const ProjectionKernels& get_kernels()
+    {
+        return get_kernels(diagram_projection);
+    }
+
+    //Returns the kernels of 'projection'
+    static const ProjectionKernels& get_kernels(DiagramProjection projection)
+    {
+        static const ProjectionKernels kernels[4] =
+        {
+            Projection<TemperatureAxis, LuminosityAxis>::get_kernels(),
+            Projection<LogTemperatureAxis, LuminosityAxis>::get_kernels(),
+            Projection<ColourIndexAxis, MagnitudeAxis>::get_kernels(),
+            Projection<LogTemperatureAxis, GravityAxis>::get_kernels()
+        };
+        return kernels[projection];
+    }
+
+    //Fill 'x_values' and 'y_values' with the values of the stars of 'chunk' on the axes, before they are scaled
+    static void get_values(const StarChunk& chunk, double* x_values, double* y_values)
+    {
+        get_kernels().get_values(chunk, x_values, y_values);
+    }
+
+    //Fill 'xs' and 'ys' with the positions of the stars of 'chunk' in 'view', which must have room for 'chunk.size()' values
+    static void project_chunk(const DiagramView& view, const StarChunk& chunk, double* xs, double* ys)
+    {
+        get_kernels(view.projection).project_chunk(view, chunk, xs, ys);
+    }
+
+    static QPointF project_star(const DiagramView& view, double temperature, double log_luminosity)
+    {
+        return get_kernels(view.projection).project_star(view, temperature, log_luminosity);
+    }
+
+    static QPointF project_star(double temperature, double log_luminosity)
+    {
+        return project_star(get_view(), temperature, log_luminosity);
+    }
+
+    static bool is_finite(double x, double y)
+    {
+        return std::isfinite(x) && std::isfinite(y);
+    }
+
+    //Returns the names of the projections, in the order of 'DiagramProjection'
+    static QStringList get_names()
+    {
+        return QStringList() << "Temperature - luminosity" << "log temperature - luminosity" << "Colour - magnitude (B-V, M)" << "Surface gravity (log T, log g)";
+    }
+};
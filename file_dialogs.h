@@ -0,0 +1,80 @@
+/*
+    FILE DIALOGS
+*/
+#pragma once
+
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QOpenGLWidget>
+#include <vector>
+
+#include "file_manager.h"
+
+using namespace std;
+
+//Class containing the functions which save or load files through dialogs shown to the user
+class FileDialogFunctions
+{
+public:
+    //Import the csv table 'file_name', telling the user if it is not supported
+    static vector<vector<QString>> import_csv(QString file_name)
+    {
+        bool supported;
+        vector<vector<QString>> list = FileIOFunctions::import_csv(file_name, &supported);
+        if(!supported)
+        {
+            show_unsupported_table();
+        }
+        return list;
+    }
+
+    //Load a list from 'file_name', which can be either a '.sgl' list or a csv table
+    static vector<vector<QString>> load_any(QString file_name)
+    {
+        bool supported;
+        vector<vector<QString>> list = FileIOFunctions::load_any(file_name, &supported);
+        if(!supported)
+        {
+            show_unsupported_table();
+        }
+        return list;
+    }
+
+    //Save the diagram displayed on 'gl_widget' as a PNG or JPEG image
+    static void save_image(QOpenGLWidget* gl_widget)
+    {
+        QImage saved_image = gl_widget->grabFramebuffer();
+        QString file_name = QFileDialog::getSaveFileName(nullptr, "Export the diagram as an image", "untitled", "PNG image (*.png);; JPEG image (*.jpg)");
+        //Check if the user selected a path
+        if(!file_name.isEmpty())
+        {
+            saved_image.save(file_name);
+        }
+    }
+
+    //Encode and save the content of 'list' as a '.sgl' file and return its path
+    static QString save_list_as_new(DatasetSnapshot list, int journal_seq)
+    {
+        QString file_name = QFileDialog::getSaveFileName(nullptr, "Save as new list", "untitled", "StarGraph list (*.sgl)");
+        //Checks if the user selected a path
+        if(!file_name.isEmpty())
+        {
+            if(!FileIOFunctions::write_list(file_name, list, journal_seq))
+            {
+                QMessageBox error_msg_box;
+                error_msg_box.setText("The list could not be saved.");
+                error_msg_box.exec();
+                return "";
+            }
+        }
+        return file_name;
+    }
+
+    //Tell the user that a table loaded on another thread is not supported
+    static void show_unsupported_table()
+    {
+        QMessageBox error_msg_box;
+        error_msg_box.setText("The selected table is not supported.");
+        error_msg_box.exec();
+    }
+};
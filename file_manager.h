@@ -3,169 +3,526 @@
 */
 #pragma once
 
-#include <QFileDialog>
 #include <QFile>
-#include <QMessageBox>
-#include <QOpenGLWidget>
-#include <QTextStream>
-#include <QTableWidget>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStringList>
+#include <cstring>
 #include <vector>
 
-#include "mainwindow.h"
+#include "base64_codec.h"
+#include "density_pyramid.h"
+#include "journal_manager.h"
+#include "memory_budget.h"
+#include "parameter_calculation.h"
+#include "star_dataset.h"
 
 using namespace std;
 
-//Class containing all the function used to save or load files
-class FileIOFunctions
+//Flags of the base64 encoding used by '.sgl' lists, only needed for the lists 'Base64UrlFunctions' cannot decode
+static const QByteArray::Base64Options list_encoding = QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals;
+
+//Class reading a '.sgl' list or a csv table a block of rows at a time, so a file of any size is read with bounded memory
+//The encoded line of a list is decoded in blocks of whole base64 quads, straight after the rows not read yet, and split into rows as soon as their separator is decoded
+class ListReader
 {
 public:
-    //Import a csv table
-    static vector<vector<QString>> import_csv()
+    //Encoded characters read at once, a multiple of four so that every block decodes on its own
+    static const int block_size = 64 * 1024;
+
+    ListReader() : csv(false), supported(true), finished(false), encoded_finished(false), version_checked(false), carry_count(0), pending_position(0), data_start(0), discarded_count(0), journal_seq(-1), memory(io_memory)
     {
-        vector<vector<QString>> list;
+    }
+
+    //Open 'file_name', which is read as a csv table if its extension is '.csv'
+    bool open(QString file_name)
+    {
+        csv = file_name.endsWith(".csv", Qt::CaseInsensitive);
+        list_in.setFileName(file_name);
+        if(!list_in.open(QIODevice::ReadOnly))
+        {
+            finished = true;
+            return false;
+        }
+
+        //Skip the two lines of warning which precede the encoded list
+        if(!csv && (list_in.readLine().isEmpty() || list_in.readLine().isEmpty()))
+        {
+            finished = true;
+        }
+        data_start = list_in.pos();
+        return true;
+    }
+
+    //Append up to 'max_rows' rows to 'rows'; returns false once the whole file has been read
+    bool read_rows(vector<vector<QString>>& rows, unsigned max_rows)
+    {
+        for(unsigned i = 0; i < max_rows && !finished; )
+        {
+            if(csv ? read_csv_row(rows) : read_list_row(rows))
+            {
+                i ++;
+            }
+        }
+        return !finished;
+    }
+
+    //False if the file is a table with rows that do not have five columns, or a list encoded by an unknown version
+    bool is_supported() const
+    {
+        return supported;
+    }
 
-        QString file_name = QFileDialog::getOpenFileName(nullptr, "Import list", "", "CSV table (*.csv)");
+    //Sequence number of the last journal record included in the list, '-1' if it is not a journal snapshot; known once every row has been read
+    int get_journal_seq() const
+    {
+        return journal_seq;
+    }
 
-        //Check if the user selected a path
-        if(!file_name.isEmpty())
+    //Returns about how many bytes of the file the rows read so far took
+    qint64 get_read_size() const
+    {
+        if(csv)
         {
-            QFile table_in(file_name);
-            table_in.open(QIODevice::ReadWrite);
+            return list_in.pos();
+        }
+        return data_start + (discarded_count + pending_position) * 4 / 3;
+    }
 
-            //Write the content of the file to the 'input' stream
-            QTextStream input(&table_in);
-            QString file_content = input.readAll();
+private:
+    //Read one line of the table, returns true if it was a row
+    bool read_csv_row(vector<vector<QString>>& rows)
+    {
+        QByteArray line = list_in.readLine();
+        if(line.isEmpty())
+        {
+            finished = true;
+            return false;
+        }
+        line.chop(line.endsWith("\r\n") ? 2 : (line.endsWith('\n') ? 1 : 0));
+        if(line.isEmpty())
+        {
+            return false;
+        }
 
-            //Parse the 'list_content' string and store the values in the 'list' table after emptying it
-            list.clear();
+        QStringList columns = QString::fromUtf8(line).split(",");
+        if(columns.length() != 5)
+        {
+            supported = false;
+            finished = true;
+            return false;
+        }
+
+        //The spectral class and the absolute magnitude are calculated from the other columns when needed
+        vector<QString> entry;
+        for(int j = 0; j < stored_column_count; j ++)
+        {
+            entry.push_back(columns[j]);
+        }
+        rows.push_back(entry);
+        return true;
+    }
 
-            QStringList rows = file_content.split("\n", QString::SkipEmptyParts);
-            for(int i = 0; i < rows.length(); i ++)
+    //Split the next row off the decoded part of the list, decoding another block if no row separator has been decoded yet
+    bool read_list_row(vector<vector<QString>>& rows)
+    {
+        int separator = pending.indexOf("_rs_", pending_position);
+        while(separator < 0)
+        {
+            //Only the new bytes need to be searched, along with the end of a separator cut by the block boundary
+            int searched = max(pending_position, pending.size() - 3);
+            if(!decode_block())
             {
-                QStringList columns = rows[i].split(",");
-                if(columns.length() == 5)
-                {
-                    vector<QString> entry;
-                    for(int j = 0; j < columns.length(); j++)
-                    {
-                        entry.push_back(columns[j]);
-                    }
-                    list.push_back(entry);
-                }
-                else
-                {
-                    QMessageBox error_msg_box;
-                    error_msg_box.setText("The selected table is not supported.");
-                    error_msg_box.exec();
-                    break;
-                }
+                break;
             }
+            separator = pending.indexOf("_rs_", searched);
+        }
+        if(!version_checked)
+        {
+            //Check the version of stargraph in which the file was encoded
+            version_checked = true;
+            if(!pending.startsWith("10"))
+            {
+                supported = false;
+                finished = true;
+                return false;
+            }
+            pending_position = 2;
+            separator = pending.indexOf("_rs_", pending_position);
+        }
 
-            //Close the file
-            table_in.close();
+        //The columns are decoded from UTF-8 straight out of the buffer
+        int row_end = separator < 0 ? pending.size() : separator;
+        vector<QString> entry;
+        for(int column_start = pending_position; ; )
+        {
+            int column_end = pending.indexOf("_cs_", column_start);
+            if(column_end < 0 || column_end + 4 > row_end)
+            {
+                column_end = row_end;
+            }
+            entry.push_back(QString::fromUtf8(pending.constData() + column_start, column_end - column_start));
+            if(column_end == row_end)
+            {
+                break;
+            }
+            column_start = column_end + 4;
         }
-        return list;
+
+        if(separator < 0)
+        {
+            //The last row has no separator after it
+            finished = true;
+        }
+        else
+        {
+            pending_position = separator + 4;
+        }
+
+        //Drop the rows already read once they take most of the buffer
+        if(pending_position > block_size && pending_position > pending.size() / 2)
+        {
+            pending.remove(0, pending_position);
+            discarded_count += pending_position;
+            pending_position = 0;
+        }
+
+        if(entry.size() < 3)
+        {
+            return false;
+        }
+        rows.push_back(entry);
+        return true;
     }
 
-    //Save the diagram displayed on 'gl_widget' as a PNG or JPEG image
-    static void save_image(QOpenGLWidget* gl_widget)
+    //Decode the next block of the encoded line, returns false if the whole line has been decoded
+    bool decode_block()
     {
-        QImage saved_image = gl_widget->grabFramebuffer();
-        QString file_name = QFileDialog::getSaveFileName(nullptr, "Export the diagram as an image", "untitled", "PNG image (*.png);; JPEG image (*.jpg)");
-        //Check if the user selected a path
-        if(!file_name.isEmpty())
+        if(encoded_finished)
+        {
+            return false;
+        }
+
+        //The characters of an incomplete quad are kept at the start of the buffer, the block is read after them
+        encoded.resize(carry_count + block_size);
+        qint64 read_count = list_in.read(encoded.data() + carry_count, block_size);
+        int size = carry_count + static_cast<int>(max<qint64>(read_count, 0));
+        const char* line_end = static_cast<const char*>(memchr(encoded.constData() + carry_count, '\n', static_cast<size_t>(size - carry_count)));
+        if(line_end != nullptr)
+        {
+            int line_size = static_cast<int>(line_end - encoded.constData());
+            read_journal_seq(QByteArray(line_end + 1, size - line_size - 1) + list_in.readAll());
+            size = line_size;
+            encoded_finished = true;
+        }
+        else if(read_count < block_size)
+        {
+            encoded_finished = true;
+        }
+        if(encoded_finished)
+        {
+            //Lists written on Windows or by other encoders can end with a carriage return or padding
+            while(size > 0 && (encoded[size - 1] == '\r' || encoded[size - 1] == '='))
+            {
+                size --;
+            }
+        }
+
+        int usable = encoded_finished ? size : size / 4 * 4;
+        int decoded_start = pending.size();
+        pending.resize(decoded_start + Base64UrlFunctions::get_decoded_size(usable));
+        if(Base64UrlFunctions::decode(encoded.constData(), usable, pending.data() + decoded_start) < 0)
         {
-            saved_image.save(file_name);
+            //Characters outside the alphabet are skipped by Qt's decoder, as they always have been
+            pending.resize(decoded_start);
+            pending.append(QByteArray::fromBase64(QByteArray(encoded.constData(), usable), list_encoding));
         }
+        carry_count = size - usable;
+        memmove(encoded.data(), encoded.constData() + usable, static_cast<size_t>(carry_count));
+        memory.set(encoded.capacity() + pending.capacity());
+        return true;
     }
 
-    //Encode and save the content of 'list' as a '.sgl' file
-    static void save_list_as_new(vector<vector<QString>> list)
+    //Snapshots written by the journal store the last record they include on the fourth line
+    void read_journal_seq(QByteArray rest)
     {
-        QString file_name = QFileDialog::getSaveFileName(nullptr, "Save as new list", "untitled", "StarGraph list (*.sgl)");
-        //Checks if the user selected a path
-        if(!file_name.isEmpty())
+        if(rest.startsWith("journal "))
         {
-            QFile entry_table_out(file_name);
-            entry_table_out.open(QIODevice::WriteOnly);
+            journal_seq = rest.mid(8).trimmed().toInt();
+        }
+    }
 
-            //Write the warning message in the 'output' stream, which is connected to the newly created file.
-            QTextStream output(&entry_table_out);
-            QString content;
-            QString encoding_version = "10";
-            output << "[IMPORTANT]\nFile generated by Stargraph. Open it using Stargraph v1.0.3 to view it properly.\n";
+    QFile list_in;
+    bool csv;
+    bool supported;
+    bool finished;
+
+    bool encoded_finished;
+    bool version_checked;
+    //Encoded characters, the first 'carry_count' ones are an incomplete quad left from the previous block
+    QByteArray encoded;
+    int carry_count;
+    //Decoded bytes, the rows before 'pending_position' have already been read
+    QByteArray pending;
+    int pending_position;
+    //Position of the encoded line in the file, and decoded bytes dropped from the start of 'pending'
+    qint64 data_start;
+    qint64 discarded_count;
+    int journal_seq;
+    MemoryCounter memory;
+};
+
+//Class writing a '.sgl' list or a csv table a row at a time, replacing the file only once it has been written completely
+//The rows of a list are encoded whenever a block of whole base64 triplets is ready, which gives the same text as encoding the list at once
+//The characters are written from a buffer which is reused for every block
+class ListWriter
+{
+public:
+    //Bytes encoded at once, a multiple of three so that no padding is written in the middle of the list
+    static const int block_size = 48 * 1024;
 
-            //Encode the content using column and row separators
-            for(unsigned i = 0; i < list.size(); i ++)
+    explicit ListWriter(QString file_name) : list_out(file_name), csv(file_name.endsWith(".csv", Qt::CaseInsensitive)), first_row(true), written(true), memory(io_memory)
+    {
+    }
+
+    bool open()
+    {
+        written = list_out.open(QIODevice::WriteOnly);
+        if(written && !csv)
+        {
+            //Write the warning message
+            write("[IMPORTANT]\nFile generated by Stargraph. Open it using Stargraph v1.0.3 to view it properly.\n");
+            pending = "10";
+        }
+        return written;
+    }
+
+    //Write the name, the temperature and the luminosity of 'row'; a table also gets the spectral class and the absolute magnitude
+    bool write_row(const vector<QString>& row)
+    {
+        if(csv)
+        {
+            QString line = row[0] + "," + row[1] + "," + row[2] + "," + ParameterCalculation::get_spectral_class_str(row[1]) + "," + ParameterCalculation::get_absolute_magnitude_str(row[2]) + "\n";
+            return write(line.toUtf8());
+        }
+
+        //Encode the content using column and row separators
+        if(!first_row)
+        {
+            pending.append("_rs_");
+        }
+        first_row = false;
+        for(unsigned j = 0; j < 3; j ++)
+        {
+            pending.append(row[j].toUtf8());
+            if(j < 2)
             {
-                for(unsigned j = 0; j < 3; j ++)
-                {
-                    content.append(list[i][j]);
-                    if(j < 2)
-                    {
-                        content.append("_cs_");
-                    }
-                }
-                if(i < list.size() - 1)
-                {
-                    content.append("_rs_");
-                }
+                pending.append("_cs_");
             }
+        }
 
-            //Obfuscate the information via base64 encoding and then write it to the 'output' stream
-            output << (encoding_version + content).toUtf8().toBase64(QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals);
+        if(pending.size() >= block_size)
+        {
+            int usable = pending.size() / 3 * 3;
+            write_encoded(usable);
+            pending.remove(0, usable);
+        }
+        return written;
+    }
 
-            //Close the file
-            entry_table_out.close();
+    //Write the rest of the list and rename the temporary file over the old one
+    //If the list is a journal snapshot, 'journal_seq' is the sequence number of the last journal record it includes
+    bool commit(int journal_seq = -1)
+    {
+        if(!csv)
+        {
+            write_encoded(pending.size());
+            pending.clear();
+            if(journal_seq >= 0)
+            {
+                write("\njournal " + QByteArray::number(journal_seq));
+            }
         }
+        if(!written || !list_out.commit())
+        {
+            return false;
+        }
+
+        //The density pyramid of the previous content of the file does not match it anymore
+        DensityPyramid::remove(list_out.fileName());
+        return true;
     }
 
-    //Decode and load the content of a '.sgl' file to the 'list' table
-    static vector<vector<QString>> open_list()
+private:
+    bool write(const QByteArray& data)
     {
-        vector<vector<QString>> list;
+        written = written && list_out.write(data) == data.size();
+        return written;
+    }
+
+    //Encode and write the first 'size' bytes of 'pending'
+    void write_encoded(int size)
+    {
+        encoded.resize(Base64UrlFunctions::get_encoded_size(size));
+        Base64UrlFunctions::encode(pending.constData(), size, encoded.data());
+        write(encoded);
+        memory.set(pending.capacity() + encoded.capacity());
+    }
+
+    QSaveFile list_out;
+    bool csv;
+    bool first_row;
+    bool written;
+    //Bytes not encoded yet, fewer than 'block_size'
+    QByteArray pending;
+    QByteArray encoded;
+    MemoryCounter memory;
+};
+
+//Memory a list needs once it is loaded, estimated from its first rows
+struct ListEstimate
+{
+    quint64 row_count;
+    //Loaded as strings, counting the rows read and the snapshot made from them, or in the packed form, a block of rows at a time
+    qint64 string_bytes;
+    qint64 packed_bytes;
+    bool supported;
+};
+
+//Class containing all the function used to save or load files, the ones which ask the user something are in 'FileDialogFunctions'
+class FileIOFunctions
+{
+public:
+    //Rows read at once while a whole file is loaded
+    static const unsigned read_block_rows = 64 * 1024;
+
+    //Rows read to estimate the memory a list needs
+    static const unsigned estimate_rows = 4096;
 
-        QString file_name = QFileDialog::getOpenFileName(nullptr, "Open list", "", "StarGraph list (*.sgl)");
-        //Check if the user selected a path
-        if(!file_name.isEmpty())
+    //Import the csv table 'file_name', setting 'supported' to false if a row does not have five columns
+    static vector<vector<QString>> import_csv(QString file_name, bool* supported)
+    {
+        ListReader reader;
+        reader.open(file_name);
+        vector<vector<QString>> list = read_all(reader);
+        *supported = reader.is_supported();
+        return list;
+    }
+
+    //Load a list from 'file_name', which can be either a '.sgl' list or a csv table
+    //The unsaved changes in the journal of a '.sgl' list are replayed, so the list is the one its window shows, while its journal is left to the window which owns it
+    static vector<vector<QString>> load_any(QString file_name, bool* supported)
+    {
+        if(file_name.endsWith(".csv", Qt::CaseInsensitive))
         {
-            QFile entry_table_in(file_name);
-            entry_table_in.open(QIODevice::ReadWrite);
+            return import_csv(file_name, supported);
+        }
+        *supported = true;
+        int journal_seq;
+        vector<vector<QString>> list = open_list(file_name, &journal_seq);
+        int last_seq = journal_seq;
+        JournalFunctions::replay(file_name, list, journal_seq, &last_seq);
+        return list;
+    }
 
-            //Write the content of the file to the 'input' stream
-            QTextStream input(&entry_table_in);
-            QString file_content = input.readAll();
+    //Encode the content of 'list' and write it to 'file_name', replacing the file only once it has been written completely
+    static bool write_list(QString file_name, DatasetSnapshot list, int journal_seq)
+    {
+        ListWriter writer(file_name);
+        if(!writer.open())
+        {
+            return false;
+        }
 
-            //Split the 'file_content' string into three lines, decode the third one and store its value in the 'list_content' array
-            QByteArray list_content = QByteArray::fromBase64(file_content.split("\n")[2].toUtf8(), QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals);
+        bool written = true;
+        for(unsigned c = 0; c < list->get_chunk_count() && written; c ++)
+        {
+            shared_ptr<const StarChunk> chunk = list->get_chunk(c);
+            for(unsigned i = 0; i < chunk->size() && written; i ++)
+            {
+                written = writer.write_row(chunk->get_row(i));
+            }
+        }
+        return written && writer.commit(journal_seq);
+    }
 
-            //Check the version of stargraph in which the file was encoded
-            if(list_content.toStdString()[0] == '1' && list_content.toStdString()[1] == '0')
+    //Decode and load the content of the '.sgl' file 'file_name' to the 'list' table
+    static vector<vector<QString>> open_list(QString file_name, int* journal_seq)
+    {
+        ListReader reader;
+        reader.open(file_name);
+        vector<vector<QString>> list = read_all(reader);
+        *journal_seq = reader.get_journal_seq();
+        return list;
+    }
+
+    //Estimate the memory the list or table 'file_name' needs from its first rows and the size of the file
+    static ListEstimate estimate_list(QString file_name)
+    {
+        ListEstimate estimate = { 0, 0, 0, true };
+        ListReader reader;
+        if(!reader.open(file_name))
+        {
+            return estimate;
+        }
+        vector<vector<QString>> rows;
+        bool more_rows = reader.read_rows(rows, estimate_rows);
+        estimate.supported = reader.is_supported();
+        if(rows.empty())
+        {
+            return estimate;
+        }
+
+        //The chunks count their own memory, so the sample is measured the same way the loaded list will be
+        StarChunk string_chunk(rows.begin(), rows.end(), false);
+        StarChunk packed_chunk(rows.begin(), rows.end(), true);
+        double string_row_bytes = static_cast<double>(string_chunk.memory.get() + MemoryFunctions::get_rows_size(rows)) / rows.size();
+        double packed_row_bytes = static_cast<double>(packed_chunk.memory.get()) / rows.size();
+
+        estimate.row_count = rows.size();
+        if(more_rows)
+        {
+            estimate.row_count = static_cast<quint64>(static_cast<double>(QFileInfo(file_name).size()) * rows.size() / max<qint64>(1, reader.get_read_size()));
+        }
+        estimate.string_bytes = static_cast<qint64>(string_row_bytes * estimate.row_count);
+        estimate.packed_bytes = static_cast<qint64>(packed_row_bytes * estimate.row_count);
+        return estimate;
+    }
+
+    //Load the list or table 'file_name' in the packed form a block of rows at a time, so its rows are never all held as strings
+    static DatasetSnapshot load_packed(QString file_name, bool* supported)
+    {
+        ListReader reader;
+        reader.open(file_name);
+        DatasetSnapshot list = StarDataset::from_rows(vector<vector<QString>>(), true);
+        vector<vector<QString>> block;
+        bool more_rows = true;
+        while(more_rows)
+        {
+            more_rows = reader.read_rows(block, read_block_rows);
+            if(!block.empty())
             {
-                list_content = list_content.remove(0, 2);
-
-                //Parse the 'list_content' string and store the values in the 'list' table after emptying it
-                list.clear();
-
-                QStringList rows = QString::fromUtf8(list_content).split("_rs_");
-                for(int i = 0; i < rows.length(); i ++)
-                {
-                    QStringList columns = rows[i].split("_cs_");
-                    vector<QString> entry;
-                    for(int j = 0; j < columns.length(); j++)
-                    {
-                        entry.push_back(columns[j]);
-                    }
-                    entry.push_back(ParameterCalculation::get_spectral_class_str(columns[1]));
-                    entry.push_back(ParameterCalculation::get_absolute_magnitude_str(columns[2]));
-
-                    list.push_back(entry);
-                }
-
-                //Close the file
-                entry_table_in.close();
+                list = list->empty() ? StarDataset::from_rows(block, true) : list->with_changes(vector<pair<unsigned, vector<QString>>>(), block);
+                block.clear();
             }
         }
+        *supported = reader.is_supported();
+        return list;
+    }
+
+private:
+    //Read the rest of a file, the rows are counted in 'io_memory' until they are returned
+    static vector<vector<QString>> read_all(ListReader& reader)
+    {
+        vector<vector<QString>> list;
+        MemoryCounter memory(io_memory);
+        bool more_rows = true;
+        while(more_rows)
+        {
+            size_t counted = list.size();
+            more_rows = reader.read_rows(list, read_block_rows);
+            memory.set(memory.get() + MemoryFunctions::get_rows_size(list, counted));
+        }
         return list;
     }
 };
@@ -4,16 +4,14 @@
 
 #include "gl_diagram.h"
 #include "mainwindow.h"
+#include "star_selection.h"
+#include "startup_trace.h"
 
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLPaintDevice>
 #include <qdebug.h>
 
-//Assign the default values to the extern variables
-int temp_min = 3000;
-int temp_max = 15000;
-int lum_min = -8;
-int lum_max = 8;
-int diagram_width = 640;
-int diagram_height = 640;
+//Assign the default values to the extern variables, the ranges and the projection of the diagram are defined by the core library
 int graph_line_h_step = 2500;
 int graph_line_v_step = 10;
 int graph_lines_opacity = 25;
@@ -26,9 +24,395 @@ bool graph_show_h_lines = false;
 bool graph_show_v_lines = true;
 bool graph_highlight_selected_star = false;
 
+vector<CatalogLayer> catalog_layers;
+
+RenderTile render_tile = { false, 1.0, QRect() };
+
+shared_ptr<DensityPyramid> density_pyramid;
+
+StarSelection star_selection = { vector<quint64>(), 0, 0, 0 };
+
 //Initialize the widget's promotion to 'GL_Diagram'
 GL_Diagram::GL_Diagram(QWidget *parent) : QOpenGLWidget(parent)
 {
+    connect(&flash_timer, &QTimer::timeout, this, [this]()
+    {
+        if(-- flash_ticks <= 0)
+        {
+            flash_timer.stop();
+        }
+        update();
+    });
+}
+
+void GL_Diagram::flash_selected_star()
+{
+    flash_ticks = 6;
+    flash_timer.start(flash_interval);
+    update();
+}
+
+//Release the layer buffers while their context is still available
+GL_Diagram::~GL_Diagram()
+{
+    makeCurrent();
+    for(map<int, LayerBuffer>::iterator it = layer_buffers.begin(); it != layer_buffers.end(); ++ it)
+    {
+        it->second.buffer.destroy();
+    }
+    stream_buffer.destroy();
+    spare_buffer.destroy();
+    selection_buffer.buffer.destroy();
+    clear_tile_textures();
+    doneCurrent();
+}
+
+void GL_Diagram::set_prepared_vertices(unsigned version, DiagramProjection projection, shared_ptr<const vector<float>> vertices, int faint_count)
+{
+    prepared_version = version;
+    prepared_projection = projection;
+    prepared_vertices = vertices;
+    prepared_faint_count = faint_count;
+}
+
+//Returns the buffer of the layer 'layer_id', uploading 'dataset' only if it is not the version already stored
+GL_Diagram::LayerBuffer& GL_Diagram::get_layer_buffer(int layer_id, const StarDataset& dataset)
+{
+    LayerBuffer& layer_buffer = layer_buffers[layer_id];
+    if(!layer_buffer.buffer.isCreated())
+    {
+        layer_buffer.buffer = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+        layer_buffer.buffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+        layer_buffer.buffer.create();
+        layer_buffer.version = dataset.get_version() + 1;
+        layer_buffer.append_origin = dataset.get_append_origin() + 1;
+        layer_buffer.projection = diagram_projection;
+    }
+
+    //When stars have only been appended since the snapshot in the buffer, for example by the live ingestion, only the rows past the ones already uploaded are, however many snapshots were published in between
+    int capacity = -1;
+    if(layer_buffer.version != dataset.get_version() && layer_buffer.append_origin == dataset.get_append_origin() && layer_buffer.row_count <= dataset.size() && layer_buffer.projection == diagram_projection)
+    {
+        vector<float> vertices;
+        int faint_count = LayerFunctions::build_vertices(dataset, vertices, layer_buffer.row_count / StarDataset::chunk_size, UINT_MAX, layer_buffer.row_count);
+        int count = static_cast<int>(vertices.size()) / LayerFunctions::vertex_size;
+        if(layer_buffer.count + count <= layer_buffer.capacity)
+        {
+            int stride = LayerFunctions::vertex_size * sizeof(float);
+            int bright_first = layer_buffer.capacity - (layer_buffer.count - layer_buffer.faint_count) - (count - faint_count);
+            layer_buffer.buffer.bind();
+            layer_buffer.buffer.write(layer_buffer.faint_count * stride, vertices.data(), faint_count * stride);
+            layer_buffer.buffer.write(bright_first * stride, vertices.data() + faint_count * LayerFunctions::vertex_size, (count - faint_count) * stride);
+            layer_buffer.buffer.release();
+
+            layer_buffer.faint_count += faint_count;
+            layer_buffer.count += count;
+            layer_buffer.version = dataset.get_version();
+            layer_buffer.row_count = dataset.size();
+            layer_buffer.append_origin = dataset.get_append_origin();
+            return layer_buffer;
+        }
+
+        //The buffer is full: upload the layer again with room for as many stars, so growing the list costs linear time in total
+        capacity = (layer_buffer.count + count) * 2;
+    }
+
+    //The vertices hold the values of the axes, which only change with the projection, so changing the ranges does not upload them again
+    if(layer_id == 0 && prepared_vertices && prepared_version == dataset.get_version() && prepared_projection == diagram_projection && (layer_buffer.version != dataset.get_version() || layer_buffer.projection != diagram_projection))
+    {
+        if(!spare_buffer.isCreated())
+        {
+            spare_buffer = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+            spare_buffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+            spare_buffer.create();
+        }
+        swap(layer_buffer.buffer, spare_buffer);
+        upload_vertices(layer_buffer, *prepared_vertices, prepared_faint_count, static_cast<int>(prepared_vertices->size()) / LayerFunctions::vertex_size);
+        layer_buffer.version = dataset.get_version();
+        layer_buffer.projection = diagram_projection;
+        layer_buffer.row_count = dataset.size();
+        layer_buffer.append_origin = dataset.get_append_origin();
+        prepared_vertices.reset();
+    }
+    else if(layer_buffer.version != dataset.get_version() || layer_buffer.projection != diagram_projection)
+    {
+        vector<float> vertices;
+        int faint_count = LayerFunctions::build_vertices(dataset, vertices);
+        upload_vertices(layer_buffer, vertices, faint_count, max(capacity, static_cast<int>(vertices.size()) / LayerFunctions::vertex_size));
+        layer_buffer.version = dataset.get_version();
+        layer_buffer.projection = diagram_projection;
+        layer_buffer.row_count = dataset.size();
+        layer_buffer.append_origin = dataset.get_append_origin();
+    }
+
+    return layer_buffer;
+}
+
+//Fill the buffer of a layer with 'vertices', the ones after 'faint_count' at the end of a buffer of 'capacity' vertices
+void GL_Diagram::upload_vertices(LayerBuffer& layer_buffer, const vector<float>& vertices, int faint_count, int capacity)
+{
+    int stride = LayerFunctions::vertex_size * sizeof(float);
+    int count = static_cast<int>(vertices.size()) / LayerFunctions::vertex_size;
+    layer_buffer.buffer.bind();
+    layer_buffer.buffer.allocate(capacity * stride);
+    layer_buffer.buffer.write(0, vertices.data(), faint_count * stride);
+    layer_buffer.buffer.write((capacity - (count - faint_count)) * stride, vertices.data() + faint_count * LayerFunctions::vertex_size, (count - faint_count) * stride);
+    layer_buffer.buffer.release();
+
+    layer_buffer.faint_count = faint_count;
+    layer_buffer.count = count;
+    layer_buffer.capacity = capacity;
+}
+
+//Draw the stars of a layer from its buffer
+//An out-of-core layer does not fit in a buffer, so it is streamed through 'stream_buffer' a few chunks at a time
+void GL_Diagram::draw_layer(int layer_id, const StarDataset& dataset, bool temperature_colour, QColor colour, bool round_markers, float point_size)
+{
+    if(dataset.is_out_of_core())
+    {
+        if(!stream_buffer.isCreated())
+        {
+            stream_buffer = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+            stream_buffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+            stream_buffer.create();
+        }
+
+        vector<float> vertices;
+        for(unsigned c = 0; c < dataset.get_chunk_count(); c += stream_chunks)
+        {
+            int faint_count = LayerFunctions::build_vertices(dataset, vertices, c, c + stream_chunks);
+            stream_buffer.bind();
+            stream_buffer.allocate(vertices.data(), static_cast<int>(vertices.size() * sizeof(float)));
+            stream_buffer.release();
+            DrawingFunctions::draw_star_buffer(stream_buffer, faint_count, faint_count, static_cast<int>(vertices.size()) / LayerFunctions::vertex_size - faint_count, temperature_colour, colour, round_markers, point_size);
+        }
+        return;
+    }
+
+    LayerBuffer& layer_buffer = get_layer_buffer(layer_id, dataset);
+    int bright_count = layer_buffer.count - layer_buffer.faint_count;
+    DrawingFunctions::draw_star_buffer(layer_buffer.buffer, layer_buffer.faint_count, layer_buffer.capacity - bright_count, bright_count, temperature_colour, colour, round_markers, point_size);
+}
+
+//Draw the density tiles of 'pyramid' which intersect the window of the diagram, at the level matching the size of the screen
+void GL_Diagram::draw_density(shared_ptr<DensityPyramid> pyramid)
+{
+    if(textures_pyramid != pyramid)
+    {
+        clear_tile_textures();
+        textures_pyramid = pyramid;
+    }
+
+    double pixels_x = (diagram_width - 64) * render_tile.scale;
+    double pixels_y = (diagram_height - 64) * render_tile.scale;
+    int level = DensityPyramid::choose_level(temp_max - temp_min, lum_max - lum_min, pixels_x, pixels_y);
+    double tile_width = DensityPyramid::get_tile_temperature_width(level);
+    double tile_height = DensityPyramid::get_tile_luminosity_height(level);
+    int tiles_per_side = 1 << level;
+
+    int first_column = qBound(0, static_cast<int>(floor(temp_min / tile_width)), tiles_per_side - 1);
+    int last_column = qBound(0, static_cast<int>(floor(temp_max / tile_width)), tiles_per_side - 1);
+    int first_row = qBound(0, static_cast<int>(floor((lum_min - DensityPyramid::log_luminosity_min) / tile_height)), tiles_per_side - 1);
+    int last_row = qBound(0, static_cast<int>(floor((lum_max - DensityPyramid::log_luminosity_min) / tile_height)), tiles_per_side - 1);
+
+    for(int row = first_row; row <= last_row; row ++)
+    {
+        for(int column = first_column; column <= last_column; column ++)
+        {
+            QOpenGLTexture* texture = get_tile_texture(*pyramid, level, column, row);
+            if(texture != nullptr)
+            {
+                double log_lum_low = DensityPyramid::log_luminosity_min + row * tile_height;
+                DrawingFunctions::draw_density_tile(*texture, column * tile_width, (column + 1) * tile_width, log_lum_low, log_lum_low + tile_height);
+            }
+        }
+    }
+}
+
+//Returns the texture of a density tile, reading the tile only if it is not among the ones drawn recently
+//Each bin is coloured from its temperature, with an opacity growing with the logarithm of the number of stars in it
+QOpenGLTexture* GL_Diagram::get_tile_texture(DensityPyramid& pyramid, int level, int column, int row)
+{
+    if(!pyramid.has_tile(level, column, row))
+    {
+        return nullptr;
+    }
+
+    quint64 key = (static_cast<quint64>(level) << 48) | (static_cast<quint64>(column) << 24) | static_cast<quint64>(row);
+    map<quint64, QOpenGLTexture*>::iterator cached = tile_textures.find(key);
+    if(cached != tile_textures.end())
+    {
+        tile_order.remove(key);
+        tile_order.push_front(key);
+        return cached->second;
+    }
+
+    vector<quint32> counts = pyramid.load_tile(level, column, row);
+    if(counts.empty())
+    {
+        return nullptr;
+    }
+
+    int tile_size = DensityPyramid::tile_size;
+    double max_density = log(1.0 + pyramid.get_max_count(level));
+    vector<uchar> pixels(static_cast<size_t>(tile_size) * tile_size * 4);
+    for(int x = 0; x < tile_size; x ++)
+    {
+        double temperature = (column * tile_size + x + 0.5) * DensityPyramid::get_tile_temperature_width(level) / tile_size;
+        QColor colour = DiagramPainterFunctions::get_star_colour(temperature);
+        for(int y = 0; y < tile_size; y ++)
+        {
+            size_t bin = static_cast<size_t>(y) * tile_size + x;
+            uchar* pixel = &pixels[bin * 4];
+            pixel[0] = static_cast<uchar>(colour.red());
+            pixel[1] = static_cast<uchar>(colour.green());
+            pixel[2] = static_cast<uchar>(colour.blue());
+            pixel[3] = counts[bin] == 0 ? 0 : static_cast<uchar>(qBound(64.0, 64 + 191 * log(1.0 + counts[bin]) / max_density, 255.0));
+        }
+    }
+
+    QOpenGLTexture* texture = new QOpenGLTexture(QOpenGLTexture::Target2D);
+    texture->setSize(tile_size, tile_size);
+    texture->setFormat(QOpenGLTexture::RGBA8_UNorm);
+    texture->setMinMagFilters(QOpenGLTexture::Linear, QOpenGLTexture::Nearest);
+    texture->setWrapMode(QOpenGLTexture::ClampToEdge);
+    texture->allocateStorage();
+    texture->setData(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, pixels.data());
+
+    tile_textures[key] = texture;
+    tile_order.push_front(key);
+    while(tile_order.size() > max_tile_textures)
+    {
+        delete tile_textures[tile_order.back()];
+        tile_textures.erase(tile_order.back());
+        tile_order.pop_back();
+    }
+    return texture;
+}
+
+void GL_Diagram::clear_tile_textures()
+{
+    for(map<quint64, QOpenGLTexture*>::iterator it = tile_textures.begin(); it != tile_textures.end(); ++ it)
+    {
+        delete it->second;
+    }
+    tile_textures.clear();
+    tile_order.clear();
+    textures_pyramid.reset();
+}
+
+//Count the memory of the vertex buffers and the tile textures, which the driver keeps on the graphics card or in its own memory
+//The vertices prepared by a playback are counted as well, until they are uploaded
+void GL_Diagram::count_render_memory()
+{
+    qint64 stride = LayerFunctions::vertex_size * sizeof(float);
+    qint64 bytes = 0;
+    for(map<int, LayerBuffer>::iterator it = layer_buffers.begin(); it != layer_buffers.end(); ++ it)
+    {
+        bytes += it->second.capacity * stride;
+    }
+    if(selection_buffer.buffer.isCreated())
+    {
+        bytes += selection_buffer.count * stride;
+    }
+    if(stream_buffer.isCreated())
+    {
+        bytes += static_cast<qint64>(stream_chunks) * StarDataset::chunk_size * stride;
+    }
+    if(prepared_vertices)
+    {
+        bytes += static_cast<qint64>(prepared_vertices->capacity() * sizeof(float));
+    }
+    bytes += static_cast<qint64>(tile_textures.size()) * DensityPyramid::tile_size * DensityPyramid::tile_size * 4;
+    memory.set(bytes);
+}
+
+//Draw the selected stars over the list, with one draw call for each side of the vertical axis
+void GL_Diagram::draw_selection(const StarDataset& dataset)
+{
+    if(!selection_buffer.buffer.isCreated())
+    {
+        selection_buffer.buffer = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+        selection_buffer.buffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+        selection_buffer.buffer.create();
+        selection_buffer.version = star_selection.version + 1;
+    }
+
+    if(selection_buffer.version != star_selection.version || selection_buffer.projection != diagram_projection)
+    {
+        vector<float> vertices;
+        selection_buffer.faint_count = SelectionFunctions::build_vertices(dataset, vertices);
+        selection_buffer.count = static_cast<int>(vertices.size()) / LayerFunctions::vertex_size;
+        selection_buffer.version = star_selection.version;
+        selection_buffer.projection = diagram_projection;
+
+        selection_buffer.buffer.bind();
+        selection_buffer.buffer.allocate(vertices.data(), static_cast<int>(vertices.size() * sizeof(float)));
+        selection_buffer.buffer.release();
+    }
+
+    DrawingFunctions::draw_star_buffer(selection_buffer.buffer, selection_buffer.faint_count, selection_buffer.faint_count, selection_buffer.count - selection_buffer.faint_count, false, QColor(255, 0, 255), true, graph_point_size + 3);
+}
+
+//Start dragging a lasso, or a box if Shift is held
+void GL_Diagram::mousePressEvent(QMouseEvent* event)
+{
+    if(event->button() != Qt::LeftButton)
+    {
+        return;
+    }
+    selecting_box = event->modifiers() & Qt::ShiftModifier;
+    selection_start = event->localPos();
+    selection_outline.clear();
+    selection_outline.append(selection_start);
+}
+
+void GL_Diagram::mouseMoveEvent(QMouseEvent* event)
+{
+    if(!(event->buttons() & Qt::LeftButton) || selection_outline.isEmpty())
+    {
+        return;
+    }
+
+    if(selecting_box)
+    {
+        selection_outline = QPolygonF(QRectF(selection_start, event->localPos()));
+    }
+    else if(QLineF(selection_outline.last(), event->localPos()).length() >= 2)
+    {
+        selection_outline.append(event->localPos());
+    }
+    update();
+}
+
+//Select the stars inside the outline, or clear the selection after a simple click
+void GL_Diagram::mouseReleaseEvent(QMouseEvent* event)
+{
+    if(event->button() != Qt::LeftButton || selection_outline.isEmpty())
+    {
+        return;
+    }
+
+    //The outline is drawn on the widget, the stars are projected into the inner drawing area squeezed inside the frame
+    QPolygonF polygon;
+    for(int i = 0; i < selection_outline.size(); i ++)
+    {
+        polygon.append(QPointF((selection_outline[i].x() - 32) * diagram_width / (diagram_width - 64), (selection_outline[i].y() - 32) * diagram_height / (diagram_height - 64)));
+    }
+    QRectF bounds = selection_outline.boundingRect();
+    selection_outline.clear();
+
+    if(polygon.size() < 3 || bounds.width() < 3 || bounds.height() < 3)
+    {
+        SelectionFunctions::clear();
+    }
+    else
+    {
+        SelectionFunctions::select_polygon(*DatasetFunctions::current(), polygon);
+    }
+
+    emit selection_changed();
+    update();
 }
 
 //Initialize the OpenGL widget
@@ -45,32 +429,157 @@ void GL_Diagram::initializeGL()
 
 //Draw to the OpenGL widget
 void GL_Diagram::paintGL()
+{
+    paint_diagram(this);
+
+    //Draw the outline being dragged
+    if(selection_outline.size() > 1)
+    {
+        QPainter painter(this);
+        painter.setPen(QPen(QColor(255, 0, 255), 1, Qt::DashLine));
+        painter.drawPolygon(selection_outline);
+        painter.end();
+    }
+
+    count_render_memory();
+
+    //The startup ends when the diagram is first painted
+    if(!first_paint_done)
+    {
+        first_paint_done = true;
+        StartupTraceFunctions::finish();
+    }
+}
+
+//Render the part 'tile' of the diagram magnified by 'scale' into an offscreen framebuffer
+QImage GL_Diagram::render_tile_image(double scale, QRect tile)
+{
+    makeCurrent();
+
+    //A point is dropped as a whole when its centre is outside of the framebuffer, so the tile is rendered with a guard band at least as wide as the largest point radius and cropped afterwards
+    int guard = static_cast<int>(ceil(get_max_point_size() * scale / 2)) + 1;
+    QRect guarded_tile = tile.adjusted(-guard, -guard, guard, guard);
+
+    QOpenGLFramebufferObject framebuffer(guarded_tile.size(), QOpenGLFramebufferObject::CombinedDepthStencil);
+    framebuffer.bind();
+
+    render_tile.enabled = true;
+    render_tile.scale = scale;
+    render_tile.rect = guarded_tile;
+
+    //The text is painted on the framebuffer as well
+    QOpenGLPaintDevice paint_device(guarded_tile.size());
+    paint_diagram(&paint_device);
+
+    render_tile.enabled = false;
+    render_tile.scale = 1.0;
+
+    //Restore the state used by the widget
+    glDisable(GL_SCISSOR_TEST);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(0, diagram_width, diagram_height, 0, 0, 1);
+    glMatrixMode(GL_MODELVIEW);
+
+    framebuffer.release();
+    QImage tile_image = framebuffer.toImage().copy(guard, guard, tile.width(), tile.height());
+
+    doneCurrent();
+    return tile_image;
+}
+
+//Get the largest size of the points drawn on the diagram, the selected stars are drawn larger than the list
+float GL_Diagram::get_max_point_size()
+{
+    float max_size = graph_point_size + 3;
+    for(unsigned i = 0; i < catalog_layers.size(); i ++)
+    {
+        if(catalog_layers[i].visible)
+        {
+            max_size = max(max_size, catalog_layers[i].point_size);
+        }
+    }
+    return max_size;
+}
+
+//Draw the diagram, the text is painted on 'device'
+void GL_Diagram::paint_diagram(QPaintDevice* device)
 {
     //Clear the buffer before drawing
+    glDisable(GL_SCISSOR_TEST);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     //If enabled, draw the reference lines
-    DrawingFunctions::draw_reference_lines(graph_show_v_lines, graph_show_h_lines, graph_line_h_step, graph_line_v_step, temp_max - temp_min, static_cast<float>(static_cast<double>(graph_lines_opacity) / 100.0));
+    DrawingFunctions::draw_reference_lines(graph_show_v_lines, graph_show_h_lines, graph_line_h_step, graph_line_v_step, static_cast<float>(static_cast<double>(graph_lines_opacity) / 100.0));
+
+    //Take the current snapshot, which stays the same for the whole frame
+    DatasetSnapshot list = DatasetFunctions::current();
+
+    //Release the buffers of the removed layers and of the layers which are now streamed
+    for(map<int, LayerBuffer>::iterator it = layer_buffers.begin(); it != layer_buffers.end();)
+    {
+        CatalogLayer* layer = LayerFunctions::find_layer(it->first);
+        bool out_of_core = it->first == 0 ? list->is_out_of_core() : layer != nullptr && layer->dataset->is_out_of_core();
+        if((it->first != 0 && layer == nullptr) || out_of_core)
+        {
+            it->second.buffer.destroy();
+            it = layer_buffers.erase(it);
+        }
+        else
+        {
+            ++ it;
+        }
+    }
+
+    //Draw the visible overlaid catalogs, changing their style does not upload them again
+    for(unsigned i = 0; i < catalog_layers.size(); i ++)
+    {
+        if(catalog_layers[i].visible && !catalog_layers[i].over_list)
+        {
+            draw_layer(catalog_layers[i].id, *catalog_layers[i].dataset, catalog_layers[i].temperature_colour, catalog_layers[i].colour, catalog_layers[i].round_markers, catalog_layers[i].point_size);
+        }
+    }
+
+    //Draw a star for each row in the 'entry_table' table on top of the other layers
+    //A list with an up to date density pyramid is drawn from the tiles in the window instead, so drawing does not depend on its size
+    //The tiles are binned by temperature and luminosity, so they can only be drawn in that projection
+    shared_ptr<DensityPyramid> pyramid = density_pyramid;
+    if(pyramid && pyramid->get_dataset_version() == list->get_version() && diagram_projection == hr_projection)
+    {
+        draw_density(pyramid);
+    }
+    else
+    {
+        draw_layer(0, *list, true, QColor(), false, graph_point_size);
+    }
+    for(unsigned i = 0; i < catalog_layers.size(); i ++)
+    {
+        if(catalog_layers[i].visible && catalog_layers[i].over_list)
+        {
+            draw_layer(catalog_layers[i].id, *catalog_layers[i].dataset, catalog_layers[i].temperature_colour, catalog_layers[i].colour, catalog_layers[i].round_markers, catalog_layers[i].point_size);
+        }
+    }
 
-    //Draw a star for each row in the 'entry_table' table
-    for(unsigned i = 0; i < entry_list.size(); i++)
+    //Highlight the selected stars
+    if(SelectionFunctions::get_count(*list) > 0)
     {
-        DrawingFunctions::draw_star(entry_list[i][1].toInt(), entry_list[i][2].toDouble(), diagram_height/ 2);
+        draw_selection(*list);
     }
 
     //Draw the white frame around the diagram
     DrawingFunctions::draw_frame(32);
 
     //Draw the scale information
-    DrawingFunctions::draw_scale_info(this);
+    DrawingFunctions::draw_scale_info(device);
 
     //If enabled, draw the names of the stars
-    DrawingFunctions::draw_star_names(this, entry_list);
+    DrawingFunctions::draw_star_names(device, *list);
 
     //Draw a square around the selected star on the diagram
-    if(selected_star != -1 && graph_highlight_selected_star)
+    int star = selected_star;
+    if(star != -1 && star < static_cast<int>(list->size()) && (graph_highlight_selected_star || flash_ticks > 0) && flash_ticks % 2 == 0)
     {
-        DrawingFunctions::draw_star_pos_square(entry_list[static_cast<unsigned>(selected_star)], this);
+        DrawingFunctions::draw_star_pos_square((*list)[static_cast<unsigned>(star)], device);
     }
 }
 
@@ -5,79 +5,212 @@
 #pragma once
 
 #include <QFileDialog>
+#include <QOpenGLBuffer>
+#include <QOpenGLTexture>
 #include <QOpenGLWidget>
 #include <QTableWidget>
 #include <QPainter>
 #include <QMouseEvent>
+#include <QPolygonF>
+#include <QRect>
+#include <QTimer>
+#include <cmath>
+#include <QLine>
 
 //Include the converter
+#include "catalog_layers.h"
 #include "converter.h"
+#include "density_pyramid.h"
+#include "diagram_painter.h"
+#include "diagram_projection.h"
+#include "memory_budget.h"
+#include "star_dataset.h"
+#include <list>
+#include <map>
 
 using namespace std;
 
 //Declare the parameters used for drawing
-extern int temp_min, temp_max, lum_min, lum_max, diagram_height, diagram_width, graph_line_h_step, graph_line_v_step, graph_lines_opacity, graph_pos_square_size;
+extern int graph_line_h_step, graph_line_v_step, graph_lines_opacity, graph_pos_square_size;
 extern float graph_point_size;
 extern bool graph_show_names, graph_show_h_lines, graph_show_v_lines, graph_highlight_selected_star;
 
+//Part of the diagram rendered offscreen: when 'enabled', the diagram is magnified by 'scale' and only the pixels inside 'rect' are drawn
+struct RenderTile
+{
+    bool enabled;
+    double scale;
+    QRect rect;
+};
+extern RenderTile render_tile;
+
 //Initialize the OpenGL widget class
 class GL_Diagram : public QOpenGLWidget
 {
     Q_OBJECT
 public:
     explicit GL_Diagram(QWidget *parent = nullptr);
+    ~GL_Diagram();
 
     void initializeGL();
     void paintGL();
     void resizeGL(int w, int h);
-};
 
+    //Render the part 'tile' of the diagram magnified by 'scale' into an offscreen framebuffer
+    QImage render_tile_image(double scale, QRect tile);
 
-//Class containing the functions used to find the coordinates of a star on the diagram
-class CoordsFunctions
-{
-public:
-    //Calculates the x coordinates of a star from its temperature
-    static int diagram_get_x(int temp_offset, int width, int range, int star_temp)
-    {
-        return static_cast<int>(static_cast<double>(width) /  static_cast<double>(range) * (range - (star_temp - temp_offset)));
-    }
+    //Blink the square around the selected star a few times, even if the selected star is not highlighted
+    void flash_selected_star();
+
+    //Use 'vertices', built in 'projection' by 'LayerFunctions::build_vertices()', when the snapshot 'version' of the list is drawn, instead of building them again
+    void set_prepared_vertices(unsigned version, DiagramProjection projection, shared_ptr<const vector<float>> vertices, int faint_count);
+
+signals:
+    //Emitted when stars have been selected, or the selection cleared, on the diagram
+    void selection_changed();
 
-    //Calculates the y coordinates of a star from its luminosity
-    static int  diagram_get_y(int y_offset, int height, int range, double star_lum)
+protected:
+    void mousePressEvent(QMouseEvent* event);
+    void mouseMoveEvent(QMouseEvent* event);
+    void mouseReleaseEvent(QMouseEvent* event);
+
+private:
+    //Vertex buffer holding the stars of a layer, uploaded again only when the layer's dataset or the projection changes
+    //The stars below the vertical pivot are at the start of the buffer and the others at its end, so the stars appended to a list are added to both sides in place
+    struct LayerBuffer
     {
-        return static_cast<int>(y_offset - (static_cast<double>(height) / static_cast<double>(range) * MathFunctions::log_base_10(star_lum)));
-    }
+        QOpenGLBuffer buffer;
+        unsigned version;
+        DiagramProjection projection;
+        int faint_count;
+        int count;
+        //Vertices the buffer has room for, and rows of the dataset it holds
+        int capacity;
+        unsigned row_count;
+        //Chain of appends the dataset in the buffer belongs to, see 'StarDataset::get_append_origin()'
+        unsigned append_origin;
+    };
+
+    //Buffers of the layers, by layer identifier
+    map<int, LayerBuffer> layer_buffers;
+
+    //Buffer the out-of-core layers are streamed through, 'stream_chunks' chunks at a time
+    static const unsigned stream_chunks = 64;
+    QOpenGLBuffer stream_buffer;
+
+    //Textures of the density tiles drawn recently, at most 'max_tile_textures' of them, the most recently used first in 'tile_order'
+    static const unsigned max_tile_textures = 64;
+    map<quint64, QOpenGLTexture*> tile_textures;
+    list<quint64> tile_order;
+    shared_ptr<DensityPyramid> textures_pyramid;
+
+    //Outline being dragged on the widget: a lasso, or a box while Shift is held
+    QPolygonF selection_outline;
+    QPointF selection_start;
+    bool selecting_box = false;
+
+    //Buffer holding the selected stars, its version is the one of 'star_selection'
+    LayerBuffer selection_buffer;
+
+    //Vertices of a list decoded in the background, for example a frame of a snapshot playback
+    //They are uploaded to 'spare_buffer', which is then swapped with the buffer of the list, so the upload does not wait for the frame still drawn from it
+    unsigned prepared_version = 0;
+    DiagramProjection prepared_projection = hr_projection;
+    shared_ptr<const vector<float>> prepared_vertices;
+    int prepared_faint_count = 0;
+    QOpenGLBuffer spare_buffer;
+
+    //Remaining blinks of the selected star, the square is hidden while the number is odd
+    static const int flash_interval = 150;
+    QTimer flash_timer;
+    int flash_ticks = 0;
+
+    bool first_paint_done = false;
+
+    //Memory of the buffers and textures, counted again after each paint
+    MemoryCounter memory = MemoryCounter(render_memory);
+
+    void paint_diagram(QPaintDevice* device);
+    float get_max_point_size();
+    LayerBuffer& get_layer_buffer(int layer_id, const StarDataset& dataset);
+    void upload_vertices(LayerBuffer& layer_buffer, const vector<float>& vertices, int faint_count, int capacity);
+    void draw_layer(int layer_id, const StarDataset& dataset, bool temperature_colour, QColor colour, bool round_markers, float point_size);
+    void draw_density(shared_ptr<DensityPyramid> pyramid);
+    QOpenGLTexture* get_tile_texture(DensityPyramid& pyramid, int level, int column, int row);
+    void clear_tile_textures();
+    void draw_selection(const StarDataset& dataset);
+    void count_render_memory();
 };
 
+
 //Class containing the functions used to draw the diagram
 class DrawingFunctions
 {
 public:   
+    //Set the OpenGL viewport to a rectangle of the diagram
+    //When a tile is rendered, the viewport covers the whole tile and the rectangle is applied through the projection instead, so it can be larger than the framebuffer
+    static void set_viewport(int x, int y, int width, int height)
+    {
+        if(!render_tile.enabled)
+        {
+            glViewport(x, y, width, height);
+            return;
+        }
+
+        //Position of the magnified rectangle inside the tile, with the origin in the bottom left corner like OpenGL
+        double tile_width = render_tile.rect.width();
+        double tile_height = render_tile.rect.height();
+        double view_x = x * render_tile.scale - render_tile.rect.x();
+        double view_y = tile_height - ((diagram_height - y) * render_tile.scale - render_tile.rect.y());
+        double view_width = width * render_tile.scale;
+        double view_height = height * render_tile.scale;
+
+        glViewport(0, 0, render_tile.rect.width(), render_tile.rect.height());
+        glMatrixMode(GL_PROJECTION);
+        glLoadIdentity();
+        glTranslated((2 * view_x + view_width) / tile_width - 1, (2 * view_y + view_height) / tile_height - 1, 0);
+        glScaled(view_width / tile_width, view_height / tile_height, 1);
+        glOrtho(0, diagram_width, diagram_height, 0, 0, 1);
+        glMatrixMode(GL_MODELVIEW);
+
+        //The viewport used to clip what was drawn outside of it, now the scissor test does
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(static_cast<int>(floor(view_x)), static_cast<int>(floor(view_y)), static_cast<int>(ceil(view_width)), static_cast<int>(ceil(view_height)));
+    }
+
+    //Set the viewport of 'painter' to a rectangle of the diagram, with the origin in the top left corner
+    static void set_painter_viewport(QPainter& painter, int x, int y, int width, int height)
+    {
+        painter.setWindow(0, 0, diagram_width, diagram_height);
+        if(!render_tile.enabled)
+        {
+            painter.setViewport(x, y, width, height);
+            return;
+        }
+        painter.setViewport(qRound(x * render_tile.scale) - render_tile.rect.x(), qRound(y * render_tile.scale) - render_tile.rect.y(), qRound(width * render_tile.scale), qRound(height * render_tile.scale));
+    }
+
     //Draw the white frame around the diagram
     static void draw_frame(int offset)
     {
         //Set the viewport to match the OpenGL widget
-        glViewport(0, 0, diagram_width, diagram_height);
+        DrawingFunctions::set_viewport(0, 0, diagram_width, diagram_height);
 
         //Draw the four lines which compose the frame
-        glLineWidth(2.0);
+        glLineWidth(static_cast<float>(2.0 * render_tile.scale));
         glColor3f(1.0, 1.0, 1.0);
-        glBegin(GL_LINES);
-
-        //Top line
-        glVertex2i(offset, offset);
-        glVertex2i(diagram_width - offset, offset);
-        //Bottom line
-        glVertex2i(offset, diagram_height - offset);
-        glVertex2i(diagram_width - offset, diagram_height - offset);
-        //Left line
-        glVertex2i(offset, offset);
-        glVertex2i(offset, diagram_height - offset);
-        //Right line
-        glVertex2i(diagram_width - offset, offset);
-        glVertex2i(diagram_width - offset, diagram_height - offset);
+        draw_lines(DiagramPainterFunctions::get_frame_lines(ProjectionFunctions::get_view(), offset));
+    }
 
+    //Draw 'lines' using the current colour and width
+    static void draw_lines(const vector<QLine>& lines)
+    {
+        glBegin(GL_LINES);
+        for(unsigned i = 0; i < lines.size(); i ++)
+        {
+            glVertex2i(lines[i].x1(), lines[i].y1());
+            glVertex2i(lines[i].x2(), lines[i].y2());
+        }
         glEnd();
     }
 
@@ -85,132 +218,153 @@ public:
     static void draw_scale_info(QPaintDevice *device)
     {
         //Set the viewport to match the OpenGL widget
-        glViewport(0, 0, diagram_width, diagram_height);
+        DrawingFunctions::set_viewport(0, 0, diagram_width, diagram_height);
 
         //Create the painter and set the viewport
         QPainter painter(device);
-        painter.setViewport(0, 0, diagram_width, diagram_height);
+        DrawingFunctions::set_painter_viewport(painter, 0, 0, diagram_width, diagram_height);
 
-        //Set the font to use
-        QFont scale_font("XITS Math", 12);
-        painter.setFont(scale_font);
-
-        //Draw the text
-        painter.drawText(2, 312, "logL");
-        painter.drawText(8, 32, QString::number(lum_max));
-        painter.drawText(8, 608, QString::number(lum_min));
-
-        painter.drawText(288, 632, "Temperature");
-        painter.drawText(8, 632, QString::number(temp_max) + " K");
-        painter.drawText(576, 632, QString::number(temp_min) + " K");
+        DiagramPainterFunctions::draw_scale_text(painter, ProjectionFunctions::get_view());
 
         //Terminate the painter
         painter.end();
     }
+
     //Draw the reference lines
-    static void draw_reference_lines(bool vertical, bool horizontal, int h_step,  int v_step, int temp_range, float brightness)
+    static void draw_reference_lines(bool vertical, bool horizontal, int h_step,  int v_step, float brightness)
     {
         //Set the viewport to match the inner drawing area
-        glViewport(32, 32, diagram_width - 64, diagram_height - 64);
+        DrawingFunctions::set_viewport(32, 32, diagram_width - 64, diagram_height - 64);
 
         //Draws the reference lines
-        glLineWidth(1.0);
+        glLineWidth(static_cast<float>(1.0 * render_tile.scale));
         glColor3f(brightness, brightness, brightness);
-        glBegin(GL_LINES);
+        draw_lines(DiagramPainterFunctions::get_reference_lines(ProjectionFunctions::get_view(), vertical, horizontal, h_step, v_step));
+    }
 
-        //If vertical reference lines are enabled, their position is calculated from the value of 'h_step'
-        if(vertical)
-        {
-            for(int i = 0; i < 50; i += 1)
-            {
-                int line_x = CoordsFunctions::diagram_get_x(temp_min, diagram_width - 64, temp_range, h_step * i);
+    //Draw the stars stored in a layer buffer, the first 'faint_count' ones using the scale below the pivot of the vertical axis, the 'bright_count' ones from 'bright_first' using the scale above it
+    static void draw_star_buffer(QOpenGLBuffer& buffer, int faint_count, int bright_first, int bright_count, bool temperature_colour, QColor colour, bool round_markers, float point_size)
+    {
+        //Set the viewport to match the OpenGL widget
+        DrawingFunctions::set_viewport(32, 32, diagram_width - 64, diagram_height - 64);
 
-                glVertex2i(line_x, 0);
-                glVertex2i(line_x, diagram_height);
-            }
+        buffer.bind();
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(2, GL_FLOAT, LayerFunctions::vertex_size * sizeof(float), nullptr);
+        if(temperature_colour)
+        {
+            glEnableClientState(GL_COLOR_ARRAY);
+            glColorPointer(3, GL_FLOAT, LayerFunctions::vertex_size * sizeof(float), reinterpret_cast<void*>(2 * sizeof(float)));
         }
-        //If horizontal reference lines are enabled, their position is calculated two times (using opposite ranges) from the value of 'v_step'
-        if(horizontal)
+        else
         {
-            for(int i = 0; i < 8; i ++)
-            {
-                int line_y_positive = CoordsFunctions::diagram_get_y(diagram_height / 2, diagram_height - 64, lum_max, static_cast<double>(MathFunctions::power_of(v_step, i)));
-                int line_y_negative = CoordsFunctions::diagram_get_y(diagram_height / 2, diagram_height - 64, lum_min , static_cast<double>(MathFunctions::power_of(v_step, i)));
+            glColor3f(static_cast<float>(colour.redF()), static_cast<float>(colour.greenF()), static_cast<float>(colour.blueF()));
+        }
 
-                glVertex2i(0, line_y_positive);
-                glVertex2i(diagram_width, line_y_positive);
+        if(round_markers)
+        {
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            glEnable(GL_POINT_SMOOTH);
+        }
+        glPointSize(static_cast<float>(point_size * render_tile.scale));
+
+        //The vertices hold the values of the axes, the scales of the projection are applied by the matrix, one for each side of the vertical pivot
+        int firsts[2] = { 0, bright_first };
+        int counts[2] = { faint_count, bright_count };
 
-                glVertex2i(0, line_y_negative);
-                glVertex2i(diagram_width, line_y_negative);
+        glMatrixMode(GL_MODELVIEW);
+        for(int i = 0; i < 2; i ++)
+        {
+            if(counts[i] <= 0)
+            {
+                continue;
             }
+            glPushMatrix();
+            load_axis_transform(i);
+            glDrawArrays(GL_POINTS, firsts[i], counts[i]);
+            glPopMatrix();
         }
 
-        glEnd();
+        if(round_markers)
+        {
+            glDisable(GL_POINT_SMOOTH);
+            glDisable(GL_BLEND);
+        }
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        buffer.release();
     }
 
-    //Draw a single star on the diagram
-    static void draw_star(int star_temperature, double star_luminosity, int luminosity_offset)
+    //Multiply the current matrix by the scales of the current projection, using the side 'side' of the vertical axis
+    static void load_axis_transform(int side)
     {
-        //Set the viewport to match the OpenGL widget
-        glViewport(32, 32, diagram_width - 64, diagram_height - 64);
+        DiagramView view = ProjectionFunctions::get_view();
+        const ProjectionKernels& projection = ProjectionFunctions::get_kernels(view.projection);
+        AxisScale x_scale = projection.get_x_scale(view);
+        AxisScale y_scale = projection.get_y_scale(view);
+        glTranslated(x_scale.origin - x_scale.scales[0] * x_scale.pivot, y_scale.origin - y_scale.scales[side] * y_scale.pivot, 0);
+        glScaled(x_scale.scales[0], y_scale.scales[side], 1);
+    }
 
-        //Calculate the coordinates of the star
-        int star_x = CoordsFunctions::diagram_get_x(temp_min, diagram_width - 64, temp_max - temp_min, star_temperature);
-        int star_y;
-        if(star_luminosity < 1)
-        {
-            star_y = CoordsFunctions::diagram_get_y(luminosity_offset, diagram_height - 64, -lum_min, star_luminosity);
-        }
-        else
-        {
-            star_y = CoordsFunctions::diagram_get_y(luminosity_offset, diagram_height - 64, lum_max, star_luminosity);
-        }
+    //Draw a density tile covering the temperatures from 'temp_low' to 'temp_high' and the log10 luminosities from 'log_lum_low' to 'log_lum_high'
+    //The tiles are only drawn in the temperature - luminosity projection, the part of the tile on each side of a luminosity of 1 is drawn with the scale of that side
+    static void draw_density_tile(QOpenGLTexture& texture, double temp_low, double temp_high, double log_lum_low, double log_lum_high)
+    {
+        DrawingFunctions::set_viewport(32, 32, diagram_width - 64, diagram_height - 64);
 
-        //Assign a colour to the star
-        double col = (1.0 / 13000) * (star_temperature - 3000);
+        glEnable(GL_TEXTURE_2D);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glColor4f(1.0, 1.0, 1.0, 1.0);
+        texture.bind();
 
-        //The drawing colour is calculated from the value of 'col' using RGB
-        glColor3f(static_cast<float>(1 - col), static_cast<float>((col / 2) + 0.5), static_cast<float>(col));
+        double lows[2] = { log_lum_low, max(log_lum_low, 0.0) };
+        double highs[2] = { min(log_lum_high, 0.0), log_lum_high };
 
-        //Draw the star to the diagram
-        glPointSize(graph_point_size);
-        glBegin(GL_POINTS);
-        glVertex2i(star_x, star_y);
-        glEnd();
+        glMatrixMode(GL_MODELVIEW);
+        for(int i = 0; i < 2; i ++)
+        {
+            if(highs[i] <= lows[i])
+            {
+                continue;
+            }
+            double t_low = (lows[i] - log_lum_low) / (log_lum_high - log_lum_low);
+            double t_high = (highs[i] - log_lum_low) / (log_lum_high - log_lum_low);
+
+            glPushMatrix();
+            load_axis_transform(i);
+            glBegin(GL_QUADS);
+            glTexCoord2d(0, t_low);
+            glVertex2d(temp_low, lows[i]);
+            glTexCoord2d(1, t_low);
+            glVertex2d(temp_high, lows[i]);
+            glTexCoord2d(1, t_high);
+            glVertex2d(temp_high, highs[i]);
+            glTexCoord2d(0, t_high);
+            glVertex2d(temp_low, highs[i]);
+            glEnd();
+            glPopMatrix();
+        }
+
+        texture.release();
+        glDisable(GL_BLEND);
+        glDisable(GL_TEXTURE_2D);
     }
 
     //Draw the names of the stars
-    static void draw_star_names(QPaintDevice *device, vector<vector<QString>> list)
+    static void draw_star_names(QPaintDevice *device, const StarDataset& list)
     {
         //Set the viewport to match the OpenGL widget
-        glViewport(32, 32, diagram_width - 64, diagram_height - 64);
+        DrawingFunctions::set_viewport(32, 32, diagram_width - 64, diagram_height - 64);
 
         //Create the painter and sets the viewport
         QPainter painter(device);       
-        painter.setViewport(32, 32, diagram_width - 64, diagram_height - 64);
+        DrawingFunctions::set_painter_viewport(painter, 32, 32, diagram_width - 64, diagram_height - 64);
 
         if(graph_show_names)
         {
-            for(unsigned i = 0; i < list.size(); i++)
-            {
-                //Calculate the position of the label
-                int star_x = static_cast<int>(CoordsFunctions::diagram_get_x(temp_min, diagram_width - 64, temp_max - temp_min, list[i][1].toInt())) + 8;
-                int star_y;
-                if(list[i][2].toDouble() < 1)
-                {
-                    star_y = static_cast<int>(CoordsFunctions::diagram_get_y(diagram_height / 2, diagram_height - 64, -lum_min, list[i][2].toDouble())) + 8;
-                }
-                else
-                {
-                    star_y = static_cast<int>(CoordsFunctions::diagram_get_y(diagram_height / 2, diagram_height - 64, lum_max, list[i][2].toDouble())) + 8;
-                }
-                //Set the font to use
-                QFont graph_font("Verdana", 10);
-                painter.setFont(graph_font);
-
-                //Draw the text
-                painter.drawText(star_x, star_y, list[i][0]);
-            }
+            DiagramPainterFunctions::draw_star_name_labels(painter, ProjectionFunctions::get_view(), list);
         }
 
         //Terminate the painter
@@ -218,23 +372,20 @@ public:
     }
 
     //Draw a square indicating the area in which the selected star is located
-    static void draw_star_pos_square(vector<QString> star_params, QPaintDevice *device)
+    static void draw_star_pos_square(const vector<QString>& star_params, QPaintDevice *device)
     {
-        int center_x = static_cast<int>(CoordsFunctions::diagram_get_x(temp_min, diagram_width - 64, temp_max - temp_min, star_params[1].toInt()));
-        int center_y;
-
-        if(star_params[2].toDouble() < 1)
-        {
-            center_y = static_cast<int>(CoordsFunctions::diagram_get_y(diagram_height / 2, diagram_height - 64, -lum_min, star_params[2].toDouble()));
-        }
-        else
+        QPointF center = ProjectionFunctions::project_star(star_params[1].toDouble(), MathFunctions::log_base_10(star_params[2].toDouble()));
+        if(!ProjectionFunctions::is_finite(center.x(), center.y()))
         {
-            center_y = static_cast<int>(CoordsFunctions::diagram_get_y(diagram_height / 2, diagram_height - 64, lum_max, star_params[2].toDouble()));
+            return;
         }
+        int center_x = static_cast<int>(center.x());
+        int center_y = static_cast<int>(center.y());
 
         //Set the viewport to match the OpenGL widget
-        glViewport(32, 32, diagram_width - 64, diagram_height - 64);
+        DrawingFunctions::set_viewport(32, 32, diagram_width - 64, diagram_height - 64);
 
+        glLineWidth(static_cast<float>(1.0 * render_tile.scale));
         glColor3f(1.0, 0.0, 1.0);
         glBegin(GL_LINES);
 
@@ -253,7 +404,7 @@ public:
         glEnd();
 
         QPainter painter(device);
-        painter.setViewport(32, 32, diagram_width - 64, diagram_height - 64);
+        DrawingFunctions::set_painter_viewport(painter, 32, 32, diagram_width - 64, diagram_height - 64);
 
         //Set the font to use
         QFont graph_font("Verdana", 10);
@@ -0,0 +1,273 @@
+/*
+    JOURNAL MANAGER
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QSaveFile>
+#include <QString>
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+//Path of the '.sgl' file the current list is saved to, empty if the list has never been saved
+extern QString current_list_path;
+
+//Enable appending the changes to a journal instead of rewriting the whole list
+extern bool journaled_saving;
+
+//Sequence number assigned to the next journal record and number of records written since the last snapshot
+extern int journal_next_seq, journal_records_since_snapshot;
+
+//Records which have not been appended to the journal file yet
+extern QByteArray journal_pending;
+
+//Class containing the functions used to record the changes made to a list in an append-only journal
+//Each record is a line like 'A<tab>seq<tab>row<tab>name<tab>temperature<tab>luminosity', where 'A' means 'added', 'E' means 'edited' and 'D' means 'deleted'
+class JournalFunctions
+{
+public:
+    //Returns the path of the journal which belongs to the list 'list_path'
+    static QString get_journal_path(QString list_path)
+    {
+        return list_path + ".journal";
+    }
+
+    //Queue a record for a star appended to the list
+    static void record_add(const vector<QString>& entry)
+    {
+        queue_record('A', -1, entry);
+    }
+
+    //Queue a record for a star whose values have been changed
+    static void record_edit(int row, const vector<QString>& entry)
+    {
+        queue_record('E', row, entry);
+    }
+
+    //Queue a record for a star removed from the list, the values of a deleted star are left empty
+    static void record_delete(int row)
+    {
+        queue_record('D', row, vector<QString>(3));
+    }
+
+    //Forget the journal of the previous list
+    static void reset(int next_seq)
+    {
+        journal_pending.clear();
+        journal_next_seq = next_seq;
+        journal_records_since_snapshot = 0;
+    }
+
+    //Append the queued records to the journal: the cost only depends on the size of the changes
+    static bool flush()
+    {
+        if(current_list_path.isEmpty() || journal_pending.isEmpty())
+        {
+            return true;
+        }
+
+        QFile journal_out(get_journal_path(current_list_path));
+        if(!journal_out.open(QIODevice::WriteOnly | QIODevice::Append))
+        {
+            return false;
+        }
+
+        bool written = journal_out.write(journal_pending) == journal_pending.size() && journal_out.flush();
+        journal_out.close();
+
+        //The records only count as flushed once they are all in the file
+        if(written)
+        {
+            journal_records_since_snapshot += journal_pending.count('\n');
+            journal_pending.clear();
+        }
+        return written;
+    }
+
+    //Apply the journal records which are newer than 'snapshot_seq' to 'list' and return how many were applied
+    //The journal of the current list continues after the last record applied
+    static int recover(QString list_path, vector<vector<QString>>& list, int snapshot_seq)
+    {
+        reset(snapshot_seq + 1);
+        int last_seq = snapshot_seq;
+        int recovered = replay(list_path, list, snapshot_seq, &last_seq);
+        journal_next_seq = last_seq + 1;
+        journal_records_since_snapshot = recovered;
+        return recovered;
+    }
+
+    //Apply the journal records which are newer than 'snapshot_seq' to 'list' without changing the journal of the current list, so any list can be read as it was last edited
+    //'last_seq' is set to the highest sequence number applied, it is left unchanged if none was
+    static int replay(QString list_path, vector<vector<QString>>& list, int snapshot_seq, int* last_seq)
+    {
+        int recovered = 0;
+        QFile journal_in(get_journal_path(list_path));
+        if(!journal_in.open(QIODevice::ReadOnly))
+        {
+            return recovered;
+        }
+
+        QByteArray journal_content = journal_in.readAll();
+        journal_in.close();
+
+        //Consecutive deletions recorded from the last row to the first, like the ones of a bulk delete, are marked and the list is compacted once for all of them
+        vector<char> deleted;
+        int lowest_deleted = -1;
+
+        //A record without its trailing newline was interrupted by a crash and is discarded
+        int start = 0;
+        int end = journal_content.indexOf('\n', start);
+        while(end != -1)
+        {
+            QList<QByteArray> fields = journal_content.mid(start, end - start).split('\t');
+            start = end + 1;
+            end = journal_content.indexOf('\n', start);
+
+            if(fields.length() != 6)
+            {
+                continue;
+            }
+
+            int seq = fields[1].toInt();
+            if(seq <= snapshot_seq)
+            {
+                continue;
+            }
+
+            vector<QString> entry;
+            entry.push_back(decode_field(fields[3]));
+            entry.push_back(decode_field(fields[4]));
+            entry.push_back(decode_field(fields[5]));
+
+            int row = fields[2].toInt();
+            if(fields[0] != "D" || (lowest_deleted != -1 && row >= lowest_deleted))
+            {
+                apply_deletions(list, deleted);
+                lowest_deleted = -1;
+            }
+            if(fields[0] == "A")
+            {
+                list.push_back(entry);
+            }
+            else if(fields[0] == "E" && row >= 0 && row < static_cast<int>(list.size()))
+            {
+                list[static_cast<unsigned>(row)] = entry;
+            }
+            else if(fields[0] == "D" && row >= 0 && row < static_cast<int>(list.size()))
+            {
+                deleted.resize(list.size(), 0);
+                deleted[static_cast<unsigned>(row)] = 1;
+                lowest_deleted = row;
+            }
+            else
+            {
+                continue;
+            }
+
+            *last_seq = max(*last_seq, seq);
+            recovered ++;
+        }
+        apply_deletions(list, deleted);
+        return recovered;
+    }
+
+    //Remove the records already included in the snapshot 'snapshot_seq' from the journal
+    static bool compact(QString list_path, int snapshot_seq)
+    {
+        QFile journal_in(get_journal_path(list_path));
+        if(!journal_in.open(QIODevice::ReadOnly))
+        {
+            return !journal_in.exists();
+        }
+        QByteArray journal_content = journal_in.readAll();
+        journal_in.close();
+
+        QByteArray remaining;
+        int remaining_records = 0;
+        int start = 0;
+        int end = journal_content.indexOf('\n', start);
+        while(end != -1)
+        {
+            QByteArray record = journal_content.mid(start, end - start + 1);
+            QList<QByteArray> fields = record.split('\t');
+            if(fields.length() > 1 && fields[1].toInt() > snapshot_seq)
+            {
+                remaining.append(record);
+                remaining_records ++;
+            }
+            start = end + 1;
+            end = journal_content.indexOf('\n', start);
+        }
+
+        //Replace the journal only once the remaining records have been written completely
+        QSaveFile journal_out(get_journal_path(list_path));
+        if(!journal_out.open(QIODevice::WriteOnly))
+        {
+            return false;
+        }
+        journal_out.write(remaining);
+        if(!journal_out.commit())
+        {
+            return false;
+        }
+
+        journal_records_since_snapshot = remaining_records;
+        return true;
+    }
+
+    //Delete the journal of the list 'list_path'
+    static void remove(QString list_path)
+    {
+        QFile::remove(get_journal_path(list_path));
+    }
+
+private:
+    //A list without a journal keeps no records: they would never be flushed
+    static void queue_record(char operation, int row, const vector<QString>& entry)
+    {
+        if(current_list_path.isEmpty())
+        {
+            return;
+        }
+
+        journal_pending.append(operation);
+        journal_pending.append('\t');
+        journal_pending.append(QByteArray::number(journal_next_seq ++));
+        journal_pending.append('\t');
+        journal_pending.append(QByteArray::number(row));
+        for(unsigned i = 0; i < 3; i ++)
+        {
+            journal_pending.append('\t');
+            journal_pending.append(entry[i].toUtf8().toPercentEncoding());
+        }
+        journal_pending.append('\n');
+    }
+
+    //Remove the rows marked in 'deleted' in a single pass
+    static void apply_deletions(vector<vector<QString>>& list, vector<char>& deleted)
+    {
+        if(deleted.empty())
+        {
+            return;
+        }
+        unsigned kept = 0;
+        for(unsigned i = 0; i < list.size(); i ++)
+        {
+            if(!deleted[i])
+            {
+                list[kept ++].swap(list[i]);
+            }
+        }
+        list.resize(kept);
+        deleted.clear();
+    }
+
+    static QString decode_field(QByteArray field)
+    {
+        return QString::fromUtf8(QByteArray::fromPercentEncoding(field));
+    }
+};
@@ -0,0 +1,236 @@
+/*
+    LIST MERGE
+*/
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QtConcurrent>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "file_manager.h"
+#include "star_dataset.h"
+
+using namespace std;
+
+//What happens to a star of the list when the merged list has a star with the same name
+enum MergeMode
+{
+    //Keep the star of the list and drop the other one
+    keep_existing_stars,
+    //Replace the temperature and the luminosity with the ones of the merged list
+    update_existing_stars
+};
+
+//A star found in both lists with a different temperature or luminosity
+struct MergeConflict
+{
+    unsigned row;
+    vector<QString> existing;
+    vector<QString> incoming;
+};
+
+struct MergeResult
+{
+    DatasetSnapshot dataset;
+    unsigned matched_count;
+    unsigned updated_count;
+    unsigned appended_count;
+    //Stars of the merged list with the same name as an earlier one, which are ignored
+    unsigned duplicate_count;
+    vector<MergeConflict> conflicts;
+    //False if the merged file is a table with rows that do not have five columns
+    bool supported;
+};
+
+//Class containing the functions used to merge a list into another one, matching the stars by name with a hash join
+//The merged list is indexed in shards built in parallel, then the chunks of the list are probed in parallel, so the time grows linearly with both lists
+class MergeFunctions
+{
+public:
+    //Number of independent hash tables the merged list is split into
+    static const unsigned shard_count = 64;
+
+    //Relative difference above which two values of the same star are reported as a conflict, larger than the rounding of the compact storage
+    static constexpr double conflict_tolerance = 1e-3;
+
+    //Returns the key two names are matched by: the name itself, or with 'normalized' its letters and digits in lower case, so that "HD 48915" matches "hd48915"
+    static QString get_match_key(const QString& name, bool normalized)
+    {
+        if(!normalized)
+        {
+            return name;
+        }
+        QString key;
+        key.reserve(name.size());
+        for(int i = 0; i < name.size(); i ++)
+        {
+            if(name[i].isLetterOrNumber())
+            {
+                key.append(name[i].toLower());
+            }
+        }
+        return key;
+    }
+
+    //Load the list or table 'file_name' and merge it into 'list', both on the calling thread, so the GUI thread never holds the incoming rows
+    static MergeResult merge_file(DatasetSnapshot list, QString file_name, MergeMode mode, bool normalized)
+    {
+        bool supported;
+        DatasetSnapshot incoming = StarDataset::from_rows(FileIOFunctions::load_any(file_name, &supported), list->is_packed());
+        MergeResult result = merge(list, incoming, mode, normalized);
+        result.supported = supported;
+        return result;
+    }
+
+    //Merge 'incoming' into 'list': the matching stars are kept or updated according to 'mode', the others are appended in their order
+    static MergeResult merge(DatasetSnapshot list, DatasetSnapshot incoming, MergeMode mode, bool normalized)
+    {
+        MergeResult result = { list, 0, 0, 0, 0, vector<MergeConflict>(), true };
+
+        //Hash the names of the merged list chunk by chunk, stars without a name never match
+        vector<QString> keys(incoming->size());
+        vector<uint> hashes(incoming->size());
+        vector<unsigned> incoming_chunks = get_chunk_indexes(*incoming);
+        QtConcurrent::blockingMap(incoming_chunks, [&](unsigned& c)
+        {
+            shared_ptr<const StarChunk> chunk = incoming->get_chunk(c);
+            for(unsigned i = 0; i < chunk->size(); i ++)
+            {
+                unsigned row = c * StarDataset::chunk_size + i;
+                keys[row] = get_match_key(chunk->get_name(i), normalized);
+                hashes[row] = qHash(keys[row]);
+            }
+        });
+
+        //Split the rows by shard, then build every shard on its own thread
+        vector<vector<unsigned>> shard_rows(shard_count);
+        for(unsigned row = 0; row < keys.size(); row ++)
+        {
+            if(!keys[row].isEmpty())
+            {
+                shard_rows[hashes[row] % shard_count].push_back(row);
+            }
+        }
+        vector<QHash<QString, unsigned>> shards(shard_count);
+        vector<unsigned> duplicate_counts(shard_count, 0);
+        vector<unsigned> shard_indexes(shard_count);
+        for(unsigned s = 0; s < shard_count; s ++)
+        {
+            shard_indexes[s] = s;
+        }
+        QtConcurrent::blockingMap(shard_indexes, [&](unsigned& s)
+        {
+            shards[s].reserve(static_cast<int>(shard_rows[s].size()));
+            for(unsigned i = 0; i < shard_rows[s].size(); i ++)
+            {
+                unsigned row = shard_rows[s][i];
+                if(shards[s].contains(keys[row]))
+                {
+                    duplicate_counts[s] ++;
+                }
+                else
+                {
+                    shards[s].insert(keys[row], row);
+                }
+            }
+        });
+
+        //Probe the index with every star of the list, each chunk collecting its own matches
+        vector<unsigned> list_chunks = get_chunk_indexes(*list);
+        vector<vector<pair<unsigned, unsigned>>> chunk_matches(list_chunks.size());
+        QtConcurrent::blockingMap(list_chunks, [&](unsigned& c)
+        {
+            shared_ptr<const StarChunk> chunk = list->get_chunk(c);
+            for(unsigned i = 0; i < chunk->size(); i ++)
+            {
+                QString key = get_match_key(chunk->get_name(i), normalized);
+                if(key.isEmpty())
+                {
+                    continue;
+                }
+                const QHash<QString, unsigned>& shard = shards[qHash(key) % shard_count];
+                QHash<QString, unsigned>::const_iterator match = shard.constFind(key);
+                if(match != shard.constEnd())
+                {
+                    chunk_matches[c].push_back(make_pair(c * StarDataset::chunk_size + i, match.value()));
+                }
+            }
+        });
+
+        //Gather the matches in the order of the list
+        vector<char> matched(incoming->size(), 0);
+        vector<pair<unsigned, vector<QString>>> replaced;
+        for(unsigned c = 0; c < chunk_matches.size(); c ++)
+        {
+            for(unsigned m = 0; m < chunk_matches[c].size(); m ++)
+            {
+                unsigned row = chunk_matches[c][m].first;
+                unsigned incoming_row = chunk_matches[c][m].second;
+                matched[incoming_row] = 1;
+                result.matched_count ++;
+
+                vector<QString> existing = (*list)[row];
+                vector<QString> update = (*incoming)[incoming_row];
+                if(differs(existing[1], update[1]) || differs(existing[2], update[2]))
+                {
+                    MergeConflict conflict = { row, existing, update };
+                    result.conflicts.push_back(conflict);
+                    if(mode == update_existing_stars)
+                    {
+                        //Keep the name of the list, which may be written differently when the names are normalized
+                        update[0] = existing[0];
+                        replaced.push_back(make_pair(row, update));
+                    }
+                }
+            }
+        }
+        result.updated_count = static_cast<unsigned>(replaced.size());
+
+        //Append the stars which are not in the list, skipping the repeated ones
+        vector<vector<QString>> appended;
+        for(unsigned s = 0; s < shard_count; s ++)
+        {
+            result.duplicate_count += duplicate_counts[s];
+        }
+        for(unsigned c = 0; c < incoming->get_chunk_count(); c ++)
+        {
+            shared_ptr<const StarChunk> chunk = incoming->get_chunk(c);
+            for(unsigned i = 0; i < chunk->size(); i ++)
+            {
+                unsigned row = c * StarDataset::chunk_size + i;
+                if(keys[row].isEmpty() || (!matched[row] && shards[hashes[row] % shard_count].value(keys[row]) == row))
+                {
+                    appended.push_back(chunk->get_row(i));
+                }
+            }
+        }
+        result.appended_count = static_cast<unsigned>(appended.size());
+
+        if(!replaced.empty() || !appended.empty())
+        {
+            result.dataset = list->with_changes(replaced, appended);
+        }
+        return result;
+    }
+
+private:
+    static vector<unsigned> get_chunk_indexes(const StarDataset& dataset)
+    {
+        vector<unsigned> indexes(dataset.get_chunk_count());
+        for(unsigned c = 0; c < indexes.size(); c ++)
+        {
+            indexes[c] = c;
+        }
+        return indexes;
+    }
+
+    static bool differs(const QString& first, const QString& second)
+    {
+        double first_value = first.toDouble();
+        double second_value = second.toDouble();
+        return std::fabs(first_value - second_value) > conflict_tolerance * max(std::fabs(first_value), std::fabs(second_value));
+    }
+};
@@ -0,0 +1,73 @@
+/*
+    LIST PREVIEW
+*/
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <memory>
+#include <vector>
+
+#include "column_store.h"
+#include "file_manager.h"
+#include "journal_manager.h"
+#include "memory_budget.h"
+#include "star_dataset.h"
+
+using namespace std;
+
+//Whole list loaded in the background to replace its preview
+struct FullListLoad
+{
+    DatasetSnapshot dataset;
+    //Rows of a list whose journal is replayed on the GUI thread before they become a snapshot, 'dataset' is then 'nullptr'
+    vector<vector<QString>> rows;
+    int journal_seq;
+    bool supported;
+    //Column file of a list opened on disk
+    QString column_file_path;
+};
+
+//Class containing the functions used to replace a preview with its whole list
+class PreviewFunctions
+{
+public:
+    //Load the whole list 'file_name' as 'mode' says, on any thread
+    //Replaying a journal changes the state of the journal, so a '.sgl' list which has one is returned as rows
+    static FullListLoad load_full(QString file_name, LoadMode mode)
+    {
+        FullListLoad load;
+        load.journal_seq = -1;
+        load.supported = true;
+        if(mode == disk_load)
+        {
+            //A column file written after the list was last changed is opened as it is
+            load.column_file_path = ColumnFileFunctions::get_column_file_path(file_name);
+            shared_ptr<ColumnFileStore> store = make_shared<ColumnFileStore>();
+            bool converted = ColumnFileFunctions::is_up_to_date(file_name, load.column_file_path) || ColumnFileFunctions::convert_csv(file_name, load.column_file_path);
+            if(converted && store->open(load.column_file_path))
+            {
+                load.dataset = StarDataset::from_source(store);
+            }
+            load.supported = load.dataset != nullptr;
+        }
+        else if(mode == packed_load)
+        {
+            load.dataset = FileIOFunctions::load_packed(file_name, &load.supported);
+        }
+        else if(file_name.endsWith(".csv", Qt::CaseInsensitive))
+        {
+            load.dataset = StarDataset::from_rows(FileIOFunctions::import_csv(file_name, &load.supported));
+        }
+        else
+        {
+            load.rows = FileIOFunctions::open_list(file_name, &load.journal_seq);
+            if(!QFile::exists(JournalFunctions::get_journal_path(file_name)))
+            {
+                load.dataset = StarDataset::from_rows(load.rows);
+                load.rows.clear();
+            }
+        }
+        return load;
+    }
+};
@@ -0,0 +1,238 @@
+/*
+    LIST SAMPLING
+*/
+#pragma once
+
+#include <QString>
+#include <QtConcurrent>
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "converter.h"
+#include "file_manager.h"
+
+using namespace std;
+
+//Ways of choosing the stars of a sample
+enum SampleMode
+{
+    //Every star has the same chance of being chosen
+    uniform_sample,
+    //Each spectral class gets its share of the sample, and the rare classes a few stars more than their share
+    spectral_class_sample
+};
+
+//Sample of a list read in a single pass, its rows are in the order of the file
+struct ListSample
+{
+    vector<vector<QString>> rows;
+    //Rows of the whole file
+    quint64 row_count;
+    bool supported;
+};
+
+//Class containing the functions used to sample a list while it is read, in memory bounded by the size of the sample
+//Each row gets a pseudo-random key from its index in the file, and a sample of 'k' rows is made of the 'k' rows with the smallest keys, like a reservoir
+//The keys do not depend on the order the rows are seen in, so each block of rows is sampled on its own, while the next block is read, and the samples of the blocks are merged
+//A stratified sample keeps such a sample for each spectral class, and takes a part of each one once the number of stars of each class is known
+class SampleFunctions
+{
+public:
+    //Strata of a stratified sample: the spectral classes of 'StarFunctions::get_spectral_class()', as in the statistics
+    static const unsigned stratum_count = 8;
+
+    //Each class keeps at least '1 / minimum_share' of the sample, or all of its stars if it has fewer
+    static const unsigned minimum_share = 32;
+
+    //Read 'file_name' once and return a sample of at most 'sample_size' rows; the same file always gives the same sample
+    static ListSample read_sample(QString file_name, unsigned sample_size, SampleMode mode)
+    {
+        ListSample sample;
+        sample.row_count = 0;
+        ListReader reader;
+        if(!reader.open(file_name))
+        {
+            sample.supported = false;
+            return sample;
+        }
+
+        unsigned strata_count = mode == spectral_class_sample ? stratum_count : 1;
+        vector<Stratum> strata(strata_count);
+        QFuture<vector<Stratum>> block_sample;
+        bool sampling = false;
+        bool more_rows = true;
+        while(more_rows)
+        {
+            shared_ptr<vector<vector<QString>>> block = make_shared<vector<vector<QString>>>();
+            more_rows = reader.read_rows(*block, FileIOFunctions::read_block_rows);
+
+            //The previous block has been sampled while this one was read
+            if(sampling)
+            {
+                merge(strata, block_sample.result(), sample_size);
+            }
+            block_sample = QtConcurrent::run(sample_block, block, sample.row_count, sample_size, strata_count);
+            sampling = true;
+            sample.row_count += block->size();
+        }
+        merge(strata, block_sample.result(), sample_size);
+        sample.supported = reader.is_supported();
+
+        //Take the rows with the smallest keys of each stratum, then put them back in the order of the file
+        vector<quint64> counts = allocate(strata, sample_size);
+        vector<SampledRow> chosen;
+        for(unsigned s = 0; s < strata_count; s ++)
+        {
+            keep_smallest(strata[s].rows, counts[s]);
+            for(unsigned i = 0; i < strata[s].rows.size(); i ++)
+            {
+                chosen.push_back(SampledRow());
+                swap(chosen.back(), strata[s].rows[i]);
+            }
+        }
+        sort(chosen.begin(), chosen.end(), [](const SampledRow& first, const SampledRow& second)
+        {
+            return first.index < second.index;
+        });
+        sample.rows.reserve(chosen.size());
+        for(unsigned i = 0; i < chosen.size(); i ++)
+        {
+            sample.rows.push_back(vector<QString>());
+            sample.rows.back().swap(chosen[i].row);
+        }
+        return sample;
+    }
+
+private:
+    struct SampledRow
+    {
+        quint64 key;
+        //Index of the row in the file
+        quint64 index;
+        vector<QString> row;
+    };
+
+    //Rows of a stratum seen so far, and the ones with the smallest keys among them
+    struct Stratum
+    {
+        Stratum() : row_count(0)
+        {
+        }
+
+        quint64 row_count;
+        vector<SampledRow> rows;
+    };
+
+    //Pseudo-random key of the row 'index', from the 'splitmix64' generator
+    static quint64 get_key(quint64 index)
+    {
+        quint64 key = index + 0x9e3779b97f4a7c15ULL;
+        key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+        return key ^ (key >> 31);
+    }
+
+    //Keep the 'count' rows with the smallest keys
+    static void keep_smallest(vector<SampledRow>& rows, quint64 count)
+    {
+        if(rows.size() <= count)
+        {
+            return;
+        }
+        nth_element(rows.begin(), rows.begin() + static_cast<ptrdiff_t>(count), rows.end(), [](const SampledRow& first, const SampledRow& second)
+        {
+            return first.key < second.key;
+        });
+        rows.resize(static_cast<size_t>(count));
+    }
+
+    //Sample the rows of a block, whose first row is the row 'first_row' of the file
+    //Only the keys are sorted, the rows chosen are moved out of the block
+    static vector<Stratum> sample_block(shared_ptr<vector<vector<QString>>> block, quint64 first_row, unsigned sample_size, unsigned strata_count)
+    {
+        vector<Stratum> strata(strata_count);
+        vector<vector<pair<quint64, unsigned>>> keys(strata_count);
+        for(unsigned i = 0; i < block->size(); i ++)
+        {
+            unsigned s = strata_count == 1 || (*block)[i].size() < 2 ? 0 : static_cast<unsigned>(StarFunctions::get_spectral_class((*block)[i][1].toDouble()));
+            keys[s].push_back(make_pair(get_key(first_row + i), i));
+            strata[s].row_count ++;
+        }
+        for(unsigned s = 0; s < strata_count; s ++)
+        {
+            if(keys[s].size() > sample_size)
+            {
+                nth_element(keys[s].begin(), keys[s].begin() + sample_size, keys[s].end());
+                keys[s].resize(sample_size);
+            }
+            strata[s].rows.resize(keys[s].size());
+            for(unsigned j = 0; j < keys[s].size(); j ++)
+            {
+                strata[s].rows[j].key = keys[s][j].first;
+                strata[s].rows[j].index = first_row + keys[s][j].second;
+                strata[s].rows[j].row.swap((*block)[keys[s][j].second]);
+            }
+        }
+        return strata;
+    }
+
+    static void merge(vector<Stratum>& strata, vector<Stratum> block_strata, unsigned sample_size)
+    {
+        for(unsigned s = 0; s < strata.size(); s ++)
+        {
+            strata[s].row_count += block_strata[s].row_count;
+            for(unsigned i = 0; i < block_strata[s].rows.size(); i ++)
+            {
+                strata[s].rows.push_back(SampledRow());
+                swap(strata[s].rows.back(), block_strata[s].rows[i]);
+            }
+            keep_smallest(strata[s].rows, sample_size);
+        }
+    }
+
+    //Returns the number of rows each stratum gives to the sample: first its minimum, then the rest of the sample in proportion to the rows left in each stratum
+    //With a single stratum this is simply the whole sample
+    static vector<quint64> allocate(const vector<Stratum>& strata, unsigned sample_size)
+    {
+        vector<quint64> counts(strata.size());
+        quint64 total = 0;
+        for(unsigned s = 0; s < strata.size(); s ++)
+        {
+            counts[s] = strata[s].row_count;
+            total += strata[s].row_count;
+        }
+        if(total <= sample_size)
+        {
+            return counts;
+        }
+
+        quint64 assigned = 0;
+        for(unsigned s = 0; s < strata.size(); s ++)
+        {
+            counts[s] = min<quint64>(strata[s].row_count, sample_size / minimum_share);
+            assigned += counts[s];
+        }
+
+        //The rows left after the whole parts of the shares go to the largest remainders
+        quint64 remaining = sample_size - assigned;
+        quint64 remaining_rows = total - assigned;
+        quint64 distributed = 0;
+        vector<pair<double, unsigned>> remainders;
+        for(unsigned s = 0; s < strata.size(); s ++)
+        {
+            double share = static_cast<double>(remaining) * (strata[s].row_count - counts[s]) / remaining_rows;
+            quint64 whole = static_cast<quint64>(share);
+            counts[s] += whole;
+            distributed += whole;
+            remainders.push_back(make_pair(share - whole, s));
+        }
+        sort(remainders.rbegin(), remainders.rend());
+        for(quint64 i = 0; i < remaining - distributed && i < remainders.size(); i ++)
+        {
+            counts[remainders[static_cast<size_t>(i)].second] ++;
+        }
+        return counts;
+    }
+};
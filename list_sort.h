@@ -0,0 +1,368 @@
+/*
+    LIST SORT
+*/
+#pragma once
+
+#include <QString>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "memory_budget.h"
+#include "star_dataset.h"
+
+using namespace std;
+
+//Order in which the table shows the rows of the list; the list itself, the selection and 'selected_star' keep using the rows of the list
+struct TableOrder
+{
+    //Column the table is sorted by, '-1' if it shows the list in its own order
+    int column;
+    bool descending;
+
+    //Row of the list shown at each position of the table, and position of each row of the list in the table
+    shared_ptr<const vector<unsigned>> rows;
+    shared_ptr<const vector<unsigned>> positions;
+
+    //Snapshot the permutations were computed for
+    unsigned dataset_version;
+};
+
+extern TableOrder table_order;
+
+//Class containing the functions used to sort the table by a column without moving the rows of the list
+class SortFunctions
+{
+public:
+    //Returns the row of the list shown at the position 'position' of the table
+    static unsigned get_table_row(unsigned position)
+    {
+        return table_order.rows && position < table_order.rows->size() ? (*table_order.rows)[position] : position;
+    }
+
+    //Returns the position of the table the row 'row' of the list is shown at
+    static unsigned get_table_position(unsigned row)
+    {
+        return table_order.positions && row < table_order.positions->size() ? (*table_order.positions)[row] : row;
+    }
+
+    //Returns false for a list read from a column file: its keys would have to be read from every chunk, which is what keeping it on disk avoids
+    static bool can_sort(const DatasetSnapshot& dataset)
+    {
+        return !dataset->is_out_of_core();
+    }
+
+    //Sort the table by 'column' of 'dataset', or show it in the order of the list if 'column' is '-1'
+    //Returns false if the permutation has to be computed first: the table shows the list in its own order until 'sort_list()' has run in the background and 'apply()' has been called
+    static bool sort_table(const DatasetSnapshot& dataset, int column, bool descending)
+    {
+        table_order.column = column;
+        table_order.descending = descending;
+        table_order.dataset_version = dataset->get_version();
+        table_order.rows.reset();
+        table_order.positions.reset();
+        if(column < 0)
+        {
+            return true;
+        }
+
+        map<pair<int, bool>, PermutationPair>& cache = get_cache(dataset->get_version());
+        map<pair<int, bool>, PermutationPair>::iterator cached = cache.find(make_pair(column, descending));
+        if(cached == cache.end())
+        {
+            return false;
+        }
+        table_order.rows = cached->second.first;
+        table_order.positions = cached->second.second;
+        return true;
+    }
+
+    //Sort the table again once the table shows another snapshot, even one of the same size, since its rows may be other stars
+    //Returns false if the list has to be sorted again in the background, see 'sort_table()'
+    static bool refresh(const DatasetSnapshot& dataset)
+    {
+        if(table_order.column >= 0 && !can_sort(dataset))
+        {
+            return sort_table(dataset, -1, false);
+        }
+        if(table_order.column >= 0 && table_order.dataset_version != dataset->get_version())
+        {
+            return sort_table(dataset, table_order.column, table_order.descending);
+        }
+        return true;
+    }
+
+    //Returns the permutation of the rows of 'dataset' sorted by 'column', on any thread
+    static TableOrder sort_list(DatasetSnapshot dataset, int column, bool descending)
+    {
+        PermutationPair permutation = get_permutation(dataset, column, descending);
+        TableOrder order = { column, descending, permutation.first, permutation.second, dataset->get_version() };
+        return order;
+    }
+
+    //Show the permutation computed by 'sort_list()' and keep it in the cache, unless the table has been sorted otherwise or shows another snapshot in the meantime
+    static bool apply(const TableOrder& order)
+    {
+        if(table_order.dataset_version != order.dataset_version)
+        {
+            return false;
+        }
+        get_cache(order.dataset_version)[make_pair(order.column, order.descending)] = PermutationPair(order.rows, order.positions);
+        get_memory().set(get_memory().get() + static_cast<qint64>((order.rows->capacity() + order.positions->capacity()) * sizeof(unsigned)));
+        if(table_order.column != order.column || table_order.descending != order.descending || table_order.dataset_version != order.dataset_version)
+        {
+            return false;
+        }
+        table_order = order;
+        return true;
+    }
+
+    //Update the order of the snapshot 'old_version' to 'dataset', which has one row appended
+    //The row is inserted at the position found by binary search, instead of sorting the whole list again
+    static void record_add(unsigned old_version, const DatasetSnapshot& dataset)
+    {
+        if(!is_current(old_version) || table_order.rows->size() + 1 != dataset->size())
+        {
+            return;
+        }
+        shared_ptr<vector<unsigned>> rows = make_shared<vector<unsigned>>(*table_order.rows);
+        shared_ptr<vector<unsigned>> positions = make_shared<vector<unsigned>>(*table_order.positions);
+        unsigned row = dataset->size() - 1;
+        positions->push_back(0);
+        unsigned position = insert_row(*dataset, *rows, row);
+        update_positions(*rows, *positions, position, static_cast<unsigned>(rows->size()) - 1);
+        set_order(dataset->get_version(), rows, positions);
+    }
+
+    //Update the order of the snapshot 'old_version' to 'dataset', where the row 'row' has been changed
+    //The row is removed from its position and inserted again at the one found by binary search
+    static void record_edit(unsigned old_version, const DatasetSnapshot& dataset, unsigned row)
+    {
+        if(!is_current(old_version) || table_order.rows->size() != dataset->size() || row >= dataset->size())
+        {
+            return;
+        }
+        shared_ptr<vector<unsigned>> rows = make_shared<vector<unsigned>>(*table_order.rows);
+        shared_ptr<vector<unsigned>> positions = make_shared<vector<unsigned>>(*table_order.positions);
+        unsigned old_position = (*positions)[row];
+        rows->erase(rows->begin() + old_position);
+        unsigned position = insert_row(*dataset, *rows, row);
+        update_positions(*rows, *positions, min(old_position, position), max(old_position, position));
+        set_order(dataset->get_version(), rows, positions);
+    }
+
+private:
+    typedef pair<shared_ptr<const vector<unsigned>>, shared_ptr<const vector<unsigned>>> PermutationPair;
+
+    //Permutations of the snapshot 'version' by column and direction, so sorting again by a previous column does not sort the list again
+    //Only used on the GUI thread
+    static map<pair<int, bool>, PermutationPair>& get_cache(unsigned version)
+    {
+        static unsigned cached_version = 0;
+        static map<pair<int, bool>, PermutationPair> cache;
+        if(cached_version != version)
+        {
+            cache.clear();
+            get_memory().set(0);
+            cached_version = version;
+        }
+        return cache;
+    }
+
+    static MemoryCounter& get_memory()
+    {
+        static MemoryCounter memory(index_memory);
+        return memory;
+    }
+
+    //Returns true if the table is sorted and shows the snapshot 'version'
+    static bool is_current(unsigned version)
+    {
+        return table_order.column >= 0 && table_order.dataset_version == version && table_order.rows && table_order.positions;
+    }
+
+    //Show the permutation 'rows' of the snapshot 'version' and make it the only one cached
+    static void set_order(unsigned version, shared_ptr<vector<unsigned>> rows, shared_ptr<vector<unsigned>> positions)
+    {
+        table_order.rows = rows;
+        table_order.positions = positions;
+        table_order.dataset_version = version;
+        get_cache(version)[make_pair(table_order.column, table_order.descending)] = PermutationPair(rows, positions);
+        get_memory().set(static_cast<qint64>((rows->capacity() + positions->capacity()) * sizeof(unsigned)));
+    }
+
+    //Insert 'row' in 'rows', sorted by the column of the table, and returns its position
+    //Rows with equal keys stay in the order of the list in both directions, like a full sort
+    static unsigned insert_row(const StarDataset& dataset, vector<unsigned>& rows, unsigned row)
+    {
+        int column = table_order.column;
+        bool descending = table_order.descending;
+        vector<unsigned>::iterator position = lower_bound(rows.begin(), rows.end(), row, [&dataset, column, descending](unsigned first, unsigned second)
+        {
+            int result = compare_keys(dataset, column, first, second);
+            if(descending)
+            {
+                result = -result;
+            }
+            return result != 0 ? result < 0 : first < second;
+        });
+        return static_cast<unsigned>(rows.insert(position, row) - rows.begin());
+    }
+
+    //Set the positions of the rows shown from 'first' to 'last'
+    static void update_positions(const vector<unsigned>& rows, vector<unsigned>& positions, unsigned first, unsigned last)
+    {
+        for(unsigned i = first; i <= last; i ++)
+        {
+            positions[rows[i]] = i;
+        }
+    }
+
+    //Compares the keys of two rows with the same order as the full sort: names ignoring case, values which are not numbers first
+    static int compare_keys(const StarDataset& dataset, int column, unsigned first, unsigned second)
+    {
+        if(column == 0)
+        {
+            return QString::compare(dataset.get_name(first), dataset.get_name(second), Qt::CaseInsensitive);
+        }
+        double first_value = get_value(dataset, column, first);
+        double second_value = get_value(dataset, column, second);
+        if(std::isnan(first_value) || std::isnan(second_value))
+        {
+            return std::isnan(second_value) - std::isnan(first_value);
+        }
+        return first_value < second_value ? -1 : (second_value < first_value ? 1 : 0);
+    }
+
+    static double get_value(const StarDataset& dataset, int column, unsigned row)
+    {
+        if(column == 1)
+        {
+            return dataset.get_temperature(row);
+        }
+        if(column == 2)
+        {
+            return dataset.get_luminosity(row);
+        }
+        return dataset.get_derived(static_cast<DerivedColumn>(column), row);
+    }
+
+    //Returns the permutation of the rows of 'dataset' sorted by 'column' and its inverse
+    static PermutationPair get_permutation(const DatasetSnapshot& dataset, int column, bool descending)
+    {
+        shared_ptr<vector<unsigned>> rows;
+        if(column == 0)
+        {
+            vector<QString> names = get_keys<QString>(*dataset, [](const StarChunk& chunk, unsigned i, unsigned)
+            {
+                return chunk.get_name(i);
+            });
+            rows = sort_keys(names, descending, [](const QString& first, const QString& second)
+            {
+                return QString::compare(first, second, Qt::CaseInsensitive) < 0;
+            });
+        }
+        else
+        {
+            const StarDataset& list = *dataset;
+            vector<double> values = get_keys<double>(list, [column, &list](const StarChunk& chunk, unsigned i, unsigned row)
+            {
+                if(column == 1)
+                {
+                    return chunk.get_temperature(i);
+                }
+                if(column == 2)
+                {
+                    return chunk.get_luminosity(i);
+                }
+                return list.get_derived(static_cast<DerivedColumn>(column), row);
+            });
+            //Values which are not numbers come first, so the order stays strict
+            rows = sort_keys(values, descending, [](double first, double second)
+            {
+                return std::isnan(first) ? !std::isnan(second) : first < second;
+            });
+        }
+
+        shared_ptr<vector<unsigned>> positions = make_shared<vector<unsigned>>(rows->size());
+        for(unsigned i = 0; i < rows->size(); i ++)
+        {
+            (*positions)[(*rows)[i]] = i;
+        }
+        return PermutationPair(rows, positions);
+    }
+
+    //Read the key of every row, one chunk per task
+    template<class T, class Reader> static vector<T> get_keys(const StarDataset& dataset, Reader read_key)
+    {
+        vector<T> keys(dataset.size());
+        vector<unsigned> chunk_indexes(dataset.get_chunk_count());
+        for(unsigned c = 0; c < chunk_indexes.size(); c ++)
+        {
+            chunk_indexes[c] = c;
+        }
+        QtConcurrent::blockingMap(chunk_indexes, [&](unsigned& c)
+        {
+            shared_ptr<const StarChunk> chunk = dataset.get_chunk(c);
+            for(unsigned i = 0; i < chunk->size(); i ++)
+            {
+                unsigned row = c * StarDataset::chunk_size + i;
+                keys[row] = read_key(*chunk, i, row);
+            }
+        });
+        return keys;
+    }
+
+    //Stable sort of the rows by 'keys': equal parts are sorted on their own threads, then merged in pairs, in parallel, until one is left
+    template<class T, class Less> static shared_ptr<vector<unsigned>> sort_keys(const vector<T>& keys, bool descending, Less less)
+    {
+        shared_ptr<vector<unsigned>> rows = make_shared<vector<unsigned>>(keys.size());
+        for(unsigned i = 0; i < keys.size(); i ++)
+        {
+            (*rows)[i] = i;
+        }
+        //Rows with equal keys stay in the order of the list in both directions
+        auto compare = [&keys, descending, &less](unsigned first, unsigned second)
+        {
+            return descending ? less(keys[second], keys[first]) : less(keys[first], keys[second]);
+        };
+
+        unsigned part_count = static_cast<unsigned>(max(1, QThreadPool::globalInstance()->maxThreadCount()));
+        vector<size_t> bounds;
+        for(unsigned p = 0; p <= part_count; p ++)
+        {
+            bounds.push_back(keys.size() * p / part_count);
+        }
+
+        vector<unsigned> parts(part_count);
+        for(unsigned p = 0; p < part_count; p ++)
+        {
+            parts[p] = p;
+        }
+        QtConcurrent::blockingMap(parts, [&](unsigned& p)
+        {
+            stable_sort(rows->begin() + static_cast<ptrdiff_t>(bounds[p]), rows->begin() + static_cast<ptrdiff_t>(bounds[p + 1]), compare);
+        });
+
+        for(unsigned width = 1; width < part_count; width *= 2)
+        {
+            vector<unsigned> merges;
+            for(unsigned p = 0; p + width < part_count; p += width * 2)
+            {
+                merges.push_back(p);
+            }
+            QtConcurrent::blockingMap(merges, [&](unsigned& p)
+            {
+                vector<unsigned>::iterator first = rows->begin() + static_cast<ptrdiff_t>(bounds[p]);
+                vector<unsigned>::iterator middle = rows->begin() + static_cast<ptrdiff_t>(bounds[p + width]);
+                vector<unsigned>::iterator last = rows->begin() + static_cast<ptrdiff_t>(bounds[min(p + width * 2, part_count)]);
+                inplace_merge(first, middle, last, compare);
+            });
+        }
+        return rows;
+    }
+};
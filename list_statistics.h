@@ -0,0 +1,273 @@
+/*
+    LIST STATISTICS
+*/
+#pragma once
+
+#include <QString>
+#include <QtConcurrent>
+#include <cmath>
+#include <vector>
+
+#include "compact_storage.h"
+#include "converter.h"
+#include "star_dataset.h"
+
+using namespace std;
+
+//Distribution of one value of the stars, which can be updated when a star is added, removed or changed
+//The values are counted in 65536 bins, the same steps the compact storage rounds to, so percentiles are read from the counts without sorting
+//The mean and the variance are running moments, updated with Welford's method
+struct ValueSketch
+{
+    quint64 count;
+    double mean;
+    double m2;
+    vector<quint32> bins;
+};
+
+//Summary of a snapshot, 'dataset_version' is the snapshot it describes and 'append_origin' the chain of appends it belongs to
+struct ListStatistics
+{
+    unsigned dataset_version;
+    unsigned append_origin;
+    quint64 star_count;
+
+    //Temperature in steps of one Kelvin, log10 of the luminosity in the steps of 'PackingFunctions'
+    ValueSketch temperature;
+    ValueSketch log_luminosity;
+
+    //Stars of each spectral class from O to M, then the ones outside the table
+    quint64 class_counts[8];
+    quint64 main_sequence_count;
+};
+
+extern ListStatistics list_statistics;
+
+//Class containing the functions used to calculate the statistics of a list
+class StatisticsFunctions
+{
+public:
+    static const int bin_count = 65536;
+
+    //Distance in dex from the main sequence, L = (T / 5772)^7, within which a star is counted as a main sequence star
+    static constexpr double main_sequence_width = 1.0;
+
+    static ListStatistics create(unsigned dataset_version)
+    {
+        ListStatistics statistics;
+        statistics.dataset_version = dataset_version;
+        statistics.append_origin = dataset_version;
+        statistics.star_count = 0;
+        init_sketch(statistics.temperature);
+        init_sketch(statistics.log_luminosity);
+        for(int i = 0; i < 8; i ++)
+        {
+            statistics.class_counts[i] = 0;
+        }
+        statistics.main_sequence_count = 0;
+        return statistics;
+    }
+
+    //Calculate the statistics of 'dataset', one part of the chunks on each thread, then add the parts up
+    static ListStatistics build(DatasetSnapshot dataset)
+    {
+        unsigned part_count = min(dataset->get_chunk_count(), static_cast<unsigned>(max(1, QThreadPool::globalInstance()->maxThreadCount())));
+        vector<ListStatistics> parts(part_count, create(dataset->get_version()));
+        vector<unsigned> part_indexes(part_count);
+        for(unsigned p = 0; p < part_count; p ++)
+        {
+            part_indexes[p] = p;
+        }
+        QtConcurrent::blockingMap(part_indexes, [&](unsigned& p)
+        {
+            for(unsigned c = dataset->get_chunk_count() * p / part_count; c < dataset->get_chunk_count() * (p + 1) / part_count; c ++)
+            {
+                shared_ptr<const StarChunk> chunk = dataset->get_chunk(c);
+                for(unsigned i = 0; i < chunk->size(); i ++)
+                {
+                    update_star(parts[p], chunk->get_temperature(i), chunk->get_luminosity(i), 1);
+                }
+            }
+        });
+
+        ListStatistics statistics = create(dataset->get_version());
+        statistics.append_origin = dataset->get_append_origin();
+        for(unsigned p = 0; p < part_count; p ++)
+        {
+            merge(statistics, parts[p]);
+        }
+        return statistics;
+    }
+
+    //Bring 'statistics' up to 'dataset' when it was made from their snapshot by appending stars, adding only the stars past the ones already counted
+    //Returns false if 'dataset' was made in another way, the statistics then have to be calculated again as a whole
+    static bool record_appended(ListStatistics& statistics, const DatasetSnapshot& dataset)
+    {
+        if(statistics.append_origin != dataset->get_append_origin() || statistics.star_count > dataset->size())
+        {
+            return false;
+        }
+        for(unsigned row = static_cast<unsigned>(statistics.star_count); row < dataset->size(); row ++)
+        {
+            update_star(statistics, dataset->get_temperature(row), dataset->get_luminosity(row), 1);
+        }
+        statistics.dataset_version = dataset->get_version();
+        return true;
+    }
+
+    //Update the statistics of the snapshot 'old_version' to the snapshot 'new_version', which has 'entry' appended
+    //Statistics of another snapshot are left alone, they are calculated again as a whole
+    static void record_add(unsigned old_version, unsigned new_version, const vector<QString>& entry)
+    {
+        if(list_statistics.dataset_version == old_version)
+        {
+            update_star(list_statistics, entry[1].toDouble(), entry[2].toDouble(), 1);
+            list_statistics.dataset_version = new_version;
+        }
+    }
+
+    //Update the statistics of the snapshot 'old_version' to the snapshot 'new_version', where the star 'old_entry' has become 'new_entry'
+    static void record_edit(unsigned old_version, unsigned new_version, const vector<QString>& old_entry, const vector<QString>& new_entry)
+    {
+        if(list_statistics.dataset_version == old_version)
+        {
+            update_star(list_statistics, old_entry[1].toDouble(), old_entry[2].toDouble(), -1);
+            update_star(list_statistics, new_entry[1].toDouble(), new_entry[2].toDouble(), 1);
+            list_statistics.dataset_version = new_version;
+            //A changed row starts a new chain of appends
+            list_statistics.append_origin = new_version;
+        }
+    }
+
+    //Returns the value below which 'fraction' of the values lie, to the precision of a bin
+    static double get_percentile(const ValueSketch& sketch, double fraction, bool log_luminosity)
+    {
+        if(sketch.count == 0)
+        {
+            return 0;
+        }
+        quint64 target = static_cast<quint64>(std::ceil(fraction * sketch.count));
+        quint64 cumulative = 0;
+        int bin = 0;
+        for(; bin < bin_count - 1; bin ++)
+        {
+            cumulative += sketch.bins[static_cast<unsigned>(bin)];
+            if(cumulative >= max<quint64>(target, 1))
+            {
+                break;
+            }
+        }
+        return get_bin_value(bin, log_luminosity);
+    }
+
+    static double get_standard_deviation(const ValueSketch& sketch)
+    {
+        return sketch.count > 1 ? std::sqrt(sketch.m2 / (sketch.count - 1)) : 0;
+    }
+
+    //Returns the number of values between 'low' and 'high', counting whole bins
+    static quint64 count_range(const ValueSketch& sketch, double low, double high, bool log_luminosity)
+    {
+        quint64 count = 0;
+        for(int bin = get_bin(low, log_luminosity); bin < get_bin(high, log_luminosity); bin ++)
+        {
+            count += sketch.bins[static_cast<unsigned>(bin)];
+        }
+        return count;
+    }
+
+private:
+    static void init_sketch(ValueSketch& sketch)
+    {
+        sketch.count = 0;
+        sketch.mean = 0;
+        sketch.m2 = 0;
+        sketch.bins.assign(bin_count, 0);
+    }
+
+    static int get_bin(double value, bool log_luminosity)
+    {
+        return log_luminosity ? PackingFunctions::pack_luminosity(MathFunctions::power_of(10, value)) + 32768 : PackingFunctions::pack_temperature(value);
+    }
+
+    static double get_bin_value(int bin, bool log_luminosity)
+    {
+        return log_luminosity ? PackingFunctions::unpack_log_luminosity(static_cast<qint16>(bin - 32768)) : bin;
+    }
+
+    //Add ('weight' = 1) or remove ('weight' = -1) a star
+    static void update_star(ListStatistics& statistics, double temperature, double luminosity, int weight)
+    {
+        statistics.star_count += weight;
+        update_value(statistics.temperature, temperature, PackingFunctions::pack_temperature(temperature), weight);
+
+        statistics.class_counts[StarFunctions::get_spectral_class(temperature)] += weight;
+
+        //Stars without a positive luminosity have no place on the diagram
+        if(luminosity > 0)
+        {
+            double log_value = MathFunctions::log_base_10(luminosity);
+            update_value(statistics.log_luminosity, log_value, PackingFunctions::pack_luminosity(luminosity) + 32768, weight);
+            if(temperature > 0 && std::fabs(log_value - 7 * MathFunctions::log_base_10(temperature / 5772)) <= main_sequence_width)
+            {
+                statistics.main_sequence_count += weight;
+            }
+        }
+    }
+
+    static void update_value(ValueSketch& sketch, double value, int bin, int weight)
+    {
+        sketch.bins[static_cast<unsigned>(bin)] += weight;
+        if(weight > 0)
+        {
+            sketch.count ++;
+            double delta = value - sketch.mean;
+            sketch.mean += delta / sketch.count;
+            sketch.m2 += delta * (value - sketch.mean);
+        }
+        else if(sketch.count <= 1)
+        {
+            sketch.count = 0;
+            sketch.mean = 0;
+            sketch.m2 = 0;
+        }
+        else
+        {
+            double delta = value - sketch.mean;
+            sketch.count --;
+            sketch.mean -= delta / sketch.count;
+            sketch.m2 -= delta * (value - sketch.mean);
+            sketch.m2 = max(sketch.m2, 0.0);
+        }
+    }
+
+    //Add the statistics of 'part' to 'statistics', combining the moments with Chan's formula
+    static void merge(ListStatistics& statistics, const ListStatistics& part)
+    {
+        statistics.star_count += part.star_count;
+        merge_sketch(statistics.temperature, part.temperature);
+        merge_sketch(statistics.log_luminosity, part.log_luminosity);
+        for(int i = 0; i < 8; i ++)
+        {
+            statistics.class_counts[i] += part.class_counts[i];
+        }
+        statistics.main_sequence_count += part.main_sequence_count;
+    }
+
+    static void merge_sketch(ValueSketch& sketch, const ValueSketch& part)
+    {
+        if(part.count == 0)
+        {
+            return;
+        }
+        quint64 count = sketch.count + part.count;
+        double delta = part.mean - sketch.mean;
+        sketch.m2 += part.m2 + delta * delta * sketch.count * part.count / count;
+        sketch.mean += delta * part.count / count;
+        sketch.count = count;
+        for(int i = 0; i < bin_count; i ++)
+        {
+            sketch.bins[static_cast<unsigned>(i)] += part.bins[static_cast<unsigned>(i)];
+        }
+    }
+};
@@ -0,0 +1,275 @@
+/*
+    LIVE INGESTION
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QString>
+#include <QThread>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+//Ring buffer passing the received stars from the listener thread to the GUI thread without locks
+//There is a single producer and a single consumer: each one only writes its own index, and the slots between the two indexes belong to the producer
+class LiveRingBuffer
+{
+public:
+    //'capacity' must be a power of two
+    explicit LiveRingBuffer(unsigned capacity) : slots(capacity), mask(capacity - 1), head(0), tail(0)
+    {
+    }
+
+    //Add a star, returns false if the buffer is full
+    bool push(vector<QString>& entry)
+    {
+        quint64 position = head.load(memory_order_relaxed);
+        if(position - tail.load(memory_order_acquire) > mask)
+        {
+            return false;
+        }
+        slots[position & mask].swap(entry);
+        head.store(position + 1, memory_order_release);
+        return true;
+    }
+
+    //Move at most 'max_rows' stars to the end of 'rows', returns their number
+    unsigned pop(vector<vector<QString>>& rows, unsigned max_rows)
+    {
+        quint64 position = tail.load(memory_order_relaxed);
+        quint64 available = head.load(memory_order_acquire) - position;
+        unsigned count = static_cast<unsigned>(min<quint64>(available, max_rows));
+        for(unsigned i = 0; i < count; i ++)
+        {
+            rows.push_back(vector<QString>());
+            rows.back().swap(slots[(position + i) & mask]);
+        }
+        tail.store(position + count, memory_order_release);
+        return count;
+    }
+
+private:
+    vector<vector<QString>> slots;
+    quint64 mask;
+    //Written by the producer and by the consumer only, kept on separate cache lines
+    atomic<quint64> head;
+    char padding[64];
+    atomic<quint64> tail;
+};
+
+//Listener accepting stars on a local socket, a Unix domain socket or a named pipe on Windows, from a simulation or a reduction pipeline
+//The protocol is one star per line, "name,temperature,luminosity", and the columns after the third one are ignored like in a csv table
+//The clients are served one at a time; when the GUI falls behind and the buffer is full, the socket is not read, so the client is slowed down instead of losing stars
+class LiveListener
+{
+public:
+    //Number of stars the ring buffer holds
+    static const unsigned buffer_capacity = 1 << 20;
+
+    //Time in milliseconds the listener waits for a client or for data before checking whether it has been stopped
+    static const int poll_interval = 100;
+
+    LiveListener() : ring(buffer_capacity), stopping(false), received_count(0), rejected_count(0)
+    {
+    }
+
+    ~LiveListener()
+    {
+        stop();
+    }
+
+    //Start listening on 'server_name', returns an empty string or the reason the socket could not be opened
+    QString start(QString server_name)
+    {
+        stop();
+        stopping = false;
+        promise<QString> listening;
+        future<QString> listen_result = listening.get_future();
+        thread.reset(new ListenerThread(this, server_name, &listening));
+        thread->start();
+
+        QString error = listen_result.get();
+        if(!error.isEmpty())
+        {
+            thread->wait();
+            thread.reset();
+        }
+        return error;
+    }
+
+    void stop()
+    {
+        if(thread)
+        {
+            stopping = true;
+            thread->wait();
+            thread.reset();
+        }
+    }
+
+    bool is_running() const
+    {
+        return thread != nullptr;
+    }
+
+    //Move at most 'max_rows' received stars to the end of 'rows', returns their number
+    unsigned take(vector<vector<QString>>& rows, unsigned max_rows)
+    {
+        return ring.pop(rows, max_rows);
+    }
+
+    quint64 get_received_count() const
+    {
+        return received_count;
+    }
+
+    //Lines which are not a star: less than three columns, or a temperature or a luminosity which is not a number
+    quint64 get_rejected_count() const
+    {
+        return rejected_count;
+    }
+
+private:
+    //Thread owning the server, which waits on it without an event loop
+    class ListenerThread : public QThread
+    {
+    public:
+        ListenerThread(LiveListener* listener, QString name, promise<QString>* result) : owner(listener), server_name(name), listening(result)
+        {
+        }
+
+    protected:
+        void run()
+        {
+            QLocalServer server;
+            QLocalServer::removeServer(server_name);
+            bool listening_ok = server.listen(server_name);
+            //'listening' belongs to 'start()', which returns once it has the result
+            listening->set_value(listening_ok ? QString() : server.errorString());
+            if(listening_ok)
+            {
+                owner->serve(server);
+            }
+        }
+
+    private:
+        LiveListener* owner;
+        QString server_name;
+        promise<QString>* listening;
+    };
+
+    void serve(QLocalServer& server)
+    {
+        while(!stopping)
+        {
+            if(!server.waitForNewConnection(poll_interval))
+            {
+                continue;
+            }
+            QLocalSocket* socket = server.nextPendingConnection();
+            QByteArray pending;
+            while(!stopping)
+            {
+                if(socket->bytesAvailable() == 0 && !socket->waitForReadyRead(poll_interval))
+                {
+                    if(socket->state() != QLocalSocket::ConnectedState)
+                    {
+                        break;
+                    }
+                    continue;
+                }
+                pending.append(socket->readAll());
+                int consumed = read_lines(pending);
+                pending.remove(0, consumed);
+            }
+
+            //A last line without a line break is complete once the client has disconnected
+            if(!stopping && !pending.isEmpty())
+            {
+                pending.append('\n');
+                read_lines(pending);
+            }
+            delete socket;
+        }
+    }
+
+    //Parse the complete lines of 'data' and push the stars, returns the number of bytes consumed
+    int read_lines(const QByteArray& data)
+    {
+        int start = 0;
+        vector<QString> entry;
+        for(int end = data.indexOf('\n'); end != -1 && !stopping; end = data.indexOf('\n', start))
+        {
+            int size = end - start;
+            if(size > 0 && data[end - 1] == '\r')
+            {
+                size --;
+            }
+            if(size > 0)
+            {
+                if(parse_line(data.constData() + start, size, entry))
+                {
+                    //Wait for the GUI thread to make room
+                    while(!ring.push(entry) && !stopping)
+                    {
+                        QThread::msleep(1);
+                    }
+                    received_count ++;
+                }
+                else
+                {
+                    rejected_count ++;
+                }
+            }
+            start = end + 1;
+        }
+        return start;
+    }
+
+    static bool parse_line(const char* line, int size, vector<QString>& entry)
+    {
+        int separators[3];
+        int found = 0;
+        for(int i = 0; i < size && found < 3; i ++)
+        {
+            if(line[i] == ',')
+            {
+                separators[found ++] = i;
+            }
+        }
+        if(found < 2)
+        {
+            return false;
+        }
+        int temperature_end = separators[1];
+        int luminosity_end = found == 3 ? separators[2] : size;
+
+        bool temperature_ok;
+        bool luminosity_ok;
+        QString temperature = QString::fromLatin1(line + separators[0] + 1, temperature_end - separators[0] - 1).trimmed();
+        QString luminosity = QString::fromLatin1(line + temperature_end + 1, luminosity_end - temperature_end - 1).trimmed();
+        temperature.toDouble(&temperature_ok);
+        luminosity.toDouble(&luminosity_ok);
+        if(!temperature_ok || !luminosity_ok)
+        {
+            return false;
+        }
+
+        entry.resize(3);
+        entry[0] = QString::fromUtf8(line, separators[0]).trimmed();
+        entry[1] = temperature;
+        entry[2] = luminosity;
+        return true;
+    }
+
+    LiveRingBuffer ring;
+    unique_ptr<ListenerThread> thread;
+    atomic<bool> stopping;
+    atomic<quint64> received_count;
+    atomic<quint64> rejected_count;
+};
@@ -3,13 +3,20 @@
 */
 
 #include "mainwindow.h"
+#include "startup_trace.h"
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
+    //'--startup-trace' prints the time taken by each phase until the diagram is first painted
+    StartupTraceFunctions::start(argc, argv);
+
     QApplication a(argc, argv);
+    StartupTraceFunctions::mark("application created");
     MainWindow w;
+    StartupTraceFunctions::mark("main window created");
     w.show();
+    StartupTraceFunctions::mark("main window shown");
 
     return a.exec();
 }
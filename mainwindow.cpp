@@ -1,34 +1,149 @@
 /*
     MAIN WINDOW
 */
-#include "file_manager.h"
+#include "column_store.h"
+#include "file_dialogs.h"
+#include "journal_manager.h"
+#include "list_merge.h"
+#include "list_preview.h"
+#include "list_sampling.h"
+#include "list_sort.h"
+#include "list_statistics.h"
+#include "live_ingest.h"
+#include "memory_panel.h"
+#include "name_index.h"
 #include "mainwindow.h"
+#include "playback_panel.h"
+#include "star_selection.h"
+#include "startup_trace.h"
+#include "statistics_panel.h"
+#include "style_loader.h"
 #include "ui_mainwindow.h"
 #include "gl_diagram.h"
+#include "tiled_export.h"
+#include "vector_export.h"
 
-using namespace std;
+#include <QActionGroup>
+#include <QApplication>
+#include <QAbstractProxyModel>
+#include <QColorDialog>
+#include <QCompleter>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QHeaderView>
+#include <QInputDialog>
+#include <QProgressDialog>
+#include <QPushButton>
+#include <QScrollBar>
+#include <QStringListModel>
+#include <QTimer>
+#include <QtConcurrent>
 
-//Version
-QString stargraph_version = "1.0.3";
+using namespace std;
 
 //Assign the values to the extern variables
 QTableWidget* entry_table = nullptr;
 
-vector<vector<QString>> entry_list;
+TableOrder table_order = { -1, false, nullptr, nullptr, 0 };
+ListStatistics list_statistics = StatisticsFunctions::create(static_cast<unsigned>(-1));
+int chunk_cache_size = 1024;
+int memory_budget = 0;
 
 static QIntValidator* temp_validator;
 static QDoubleValidator* lum_validator;
 static QDoubleValidator* mag_validator;
 static QString error_message = "";
 
-int selected_star = -1;
+atomic<int> selected_star(-1);
 
 bool manual_input = true;
 
+QString current_list_path = "";
+bool journaled_saving = true;
+int journal_next_seq = 0;
+int journal_records_since_snapshot = 0;
+QByteArray journal_pending;
+
+//The journal is flushed every 'autosave_interval' milliseconds, a snapshot is taken every 'snapshot_interval' ticks or after 'snapshot_records' records
+static const int autosave_interval = 30000;
+static const int snapshot_interval = 10;
+static const int snapshot_records = 256;
+static int autosave_ticks = 0;
+static int snapshot_seq = -1;
+static QString snapshot_path = "";
+static QTimer* autosave_timer;
+static QFutureWatcher<bool>* snapshot_watcher;
+
+//Path of the file the current list was opened from or saved to, which its density pyramid is stored next to
+static QString list_file_path = "";
+static QFutureWatcher<bool>* pyramid_watcher;
+static DatasetSnapshot pyramid_dataset;
+
+//Merge running in the background and the snapshot it started from
+static QFutureWatcher<MergeResult>* merge_watcher;
+static DatasetSnapshot merge_base_dataset;
+
+//Index of the star names of the current list, built in the background, and the rows found by the last search
+static shared_ptr<NameIndex> name_index;
+static QFutureWatcher<shared_ptr<NameIndex>>* name_index_watcher;
+static QStringListModel* search_model;
+static vector<unsigned> search_rows;
+static const unsigned max_search_results = 50;
+
+//Statistics of the current list, calculated again in the background when they cannot be updated star by star
+static QFutureWatcher<ListStatistics>* statistics_watcher;
+//The panel is created the first time it is shown
+static StatisticsPanel* statistics_panel = nullptr;
+
+//Listener receiving live stars, which are appended once per frame, at most 'max_live_batch' at a time so a frame stays short
+//The name index and the statistics are brought up to each batch, they are only calculated again in the background when that is not possible
+//The statistics panel and the count of received stars are shown every 'live_refresh_ticks' frames
+//The listener and its ring buffer are created the first time live ingestion is started
+static LiveListener* live_listener = nullptr;
+static QTimer* live_timer;
+static const int live_frame_interval = 16;
+static const unsigned max_live_batch = 1 << 16;
+static const int live_refresh_ticks = 30;
+static int live_ticks = 0;
+
+//Window playing a sequence of snapshots, created the first time one is played
+static PlaybackPanel* playback_panel = nullptr;
+
+//Window showing the memory of each subsystem, created the first time it is shown
+static MemoryPanel* memory_panel = nullptr;
+
+//Preview of a list: a sample read in a single pass, which the whole list loaded in the background replaces
+//'preview_file_path' is empty when the list is not a preview, 'preview_version' is the snapshot of the preview before any change
+static int preview_size = 100000;
+static bool preview_stratified = true;
+static QString preview_file_path = "";
+static unsigned preview_version = 0;
+static quint64 preview_row_count = 0;
+static QFutureWatcher<FullListLoad>* full_load_watcher;
+static QString full_load_path = "";
+static LoadMode full_load_mode = string_load;
+
+//Sort of the table running in the background, the table shows the list in its own order until it is done
+static QFutureWatcher<TableOrder>* sort_watcher;
+
+//Conversion of a table to a column file running in the background, its progress is shown in a dialog which can cancel it
+//Once the column file is written it is opened as a large catalog or, if 'conversion_degraded' is set, as a list degraded to fit in the memory budget
+static QFutureWatcher<bool>* conversion_watcher;
+static shared_ptr<ConversionProgress> conversion_progress;
+static QProgressDialog* conversion_dialog = nullptr;
+static QTimer* conversion_timer;
+static QString conversion_file_path = "";
+static bool conversion_degraded = false;
+
 //Set up the user interface
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWindow)
 {
     ui->setupUi(this);
+    StartupTraceFunctions::mark("user interface set up");
+
+    //Apply the stylesheet before the window is shown, so its widgets are polished only once
+    StyleFunctions::apply_stylesheet(this);
+    StartupTraceFunctions::mark("stylesheet applied");
 
     //Show version information
     this->setWindowTitle("StarGraph v" + stargraph_version);
@@ -49,8 +164,84 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
     ui->lineEdit_input_temperature->setValidator(temp_validator);
     ui->lineEdit_input_luminosity->setValidator(lum_validator);
 
-    //Initialize the entry list
+    //Initialize the entry list, whose rows are added as it is scrolled
     entry_table = ui->table_entries;
+    connect(ui->table_entries->verticalScrollBar(), &QScrollBar::valueChanged, this, &MainWindow::table_scrolled);
+
+    //The table is sorted through a permutation of the rows, the header only shows the order
+    ui->table_entries->horizontalHeader()->setSectionsClickable(true);
+    connect(ui->table_entries->horizontalHeader(), &QHeaderView::sectionClicked, this, &MainWindow::table_header_clicked);
+
+    //Initialize the journal autosave
+    snapshot_watcher = new QFutureWatcher<bool>(this);
+    connect(snapshot_watcher, &QFutureWatcher<bool>::finished, this, &MainWindow::journal_snapshot_finished);
+    autosave_timer = new QTimer(this);
+    connect(autosave_timer, &QTimer::timeout, this, &MainWindow::autosave_journal);
+    autosave_timer->start(autosave_interval);
+
+    //Initialize the bulk operations on the stars selected on the diagram
+    connect(ui->openGLWidget_diagram, &GL_Diagram::selection_changed, this, &MainWindow::update_selection_actions);
+    //A selection made on a list which has been changed since then is not valid anymore
+    connect(ui->menuSelection, &QMenu::aboutToShow, this, &MainWindow::update_selection_actions);
+    update_selection_actions();
+
+    //Initialize the density pyramid builder
+    pyramid_watcher = new QFutureWatcher<bool>(this);
+    connect(pyramid_watcher, &QFutureWatcher<bool>::finished, this, &MainWindow::density_pyramid_finished);
+
+    //Initialize the list merger
+    merge_watcher = new QFutureWatcher<MergeResult>(this);
+    connect(merge_watcher, &QFutureWatcher<MergeResult>::finished, this, &MainWindow::merge_finished);
+
+    //Initialize the name search, the results are shown in the popup of a completer
+    name_index_watcher = new QFutureWatcher<shared_ptr<NameIndex>>(this);
+    connect(name_index_watcher, &QFutureWatcher<shared_ptr<NameIndex>>::finished, this, &MainWindow::name_index_finished);
+    search_model = new QStringListModel(this);
+    QCompleter* search_completer = new QCompleter(search_model, this);
+    search_completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    ui->lineEdit_search->setCompleter(search_completer);
+    connect(search_completer, static_cast<void (QCompleter::*)(const QModelIndex&)>(&QCompleter::activated), this, &MainWindow::search_result_activated);
+
+    //Initialize the statistics panel
+    statistics_watcher = new QFutureWatcher<ListStatistics>(this);
+    connect(statistics_watcher, &QFutureWatcher<ListStatistics>::finished, this, &MainWindow::statistics_finished);
+
+    //Initialize the loading of the whole list of a preview
+    full_load_watcher = new QFutureWatcher<FullListLoad>(this);
+    connect(full_load_watcher, &QFutureWatcher<FullListLoad>::finished, this, &MainWindow::full_load_finished);
+
+    //Initialize the sort of the table
+    sort_watcher = new QFutureWatcher<TableOrder>(this);
+    connect(sort_watcher, &QFutureWatcher<TableOrder>::finished, this, &MainWindow::table_sort_finished);
+
+    //Initialize the conversion of tables to column files
+    conversion_watcher = new QFutureWatcher<bool>(this);
+    connect(conversion_watcher, &QFutureWatcher<bool>::finished, this, &MainWindow::conversion_finished);
+    conversion_timer = new QTimer(this);
+    connect(conversion_timer, &QTimer::timeout, this, &MainWindow::conversion_progressed);
+
+    //Initialize the live ingestion
+    live_timer = new QTimer(this);
+    connect(live_timer, &QTimer::timeout, this, &MainWindow::live_ingest_tick);
+
+    //Initialize the catalog layers menu
+    update_layer_menu();
+
+    //Initialize the projection menu, one checkable action for each projection
+    QActionGroup* projection_group = new QActionGroup(ui->menuProjection);
+    QStringList projection_names = ProjectionFunctions::get_names();
+    for(int i = 0; i < projection_names.size(); i ++)
+    {
+        QAction* projection_action = ui->menuProjection->addAction(projection_names[i]);
+        projection_action->setCheckable(true);
+        projection_action->setChecked(diagram_projection == i);
+        projection_group->addAction(projection_action);
+        connect(projection_action, &QAction::triggered, this, [this, i]()
+        {
+            diagram_projection = static_cast<DiagramProjection>(i);
+            ui->openGLWidget_diagram->update();
+        });
+    }
 
     //Update the OpenGL widget
     ui->openGLWidget_diagram->update();
@@ -59,6 +250,15 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
 //MainWindow deconstructor
 MainWindow::~MainWindow()
 {
+    //Append the last changes to the journal and wait for the running snapshot
+    finish_journal();
+    pyramid_watcher->waitForFinished();
+    merge_watcher->waitForFinished();
+    name_index_watcher->waitForFinished();
+    statistics_watcher->waitForFinished();
+    full_load_watcher->waitForFinished();
+    delete live_listener;
+
     delete ui;
 }
 
@@ -166,13 +366,16 @@ void MainWindow::on_pushButton_add_entry_clicked()
         entry.push_back(name_value);
         entry.push_back(temperature_value);
         entry.push_back(luminosity_value);
-        entry.push_back(spectral_class_value);
-        entry.push_back(absolute_magnitude_value);
 
-        entry_list.push_back(entry);
+        unsigned old_version = DatasetFunctions::current()->get_version();
+        DatasetFunctions::append(entry);
+        JournalFunctions::record_add(entry);
+        StatisticsFunctions::record_add(old_version, DatasetFunctions::current()->get_version(), entry);
+        SortFunctions::record_add(old_version, DatasetFunctions::current());
 
         //Draw the values to the table
         update_table(ui->table_entries);
+        update_statistics();
 
         //Clear the lineEdit widgets
         ui->lineEdit_input_name->clear();
@@ -257,21 +460,164 @@ void MainWindow::on_actionHorizontal_toggled(bool arg1)
 //Save the diagram as an image
 void MainWindow::on_actionExport_as_image_triggered()
 {
-    FileIOFunctions::save_image(ui->openGLWidget_diagram);
+    FileDialogFunctions::save_image(ui->openGLWidget_diagram);
+}
+
+//Save the diagram as a PNG or TIFF image larger than the OpenGL widget
+void MainWindow::on_actionExport_as_high_resolution_image_triggered()
+{
+    QString file_name = QFileDialog::getSaveFileName(this, "Export the diagram as a high-resolution image", "untitled", "PNG image (*.png);; TIFF image (*.tif)");
+    //Check if the user selected a path
+    if(file_name.isEmpty())
+    {
+        return;
+    }
+
+    bool accepted;
+    int width = QInputDialog::getInt(this, "Image size", "Width of the image (pixels):", 8192, diagram_width, 65536, 1024, &accepted);
+    if(!accepted)
+    {
+        return;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    bool saved = TiledExportFunctions::save_tiled(ui->openGLWidget_diagram, file_name, width);
+    QApplication::restoreOverrideCursor();
+
+    if(!saved)
+    {
+        QMessageBox error_msg_box;
+        error_msg_box.setText("The diagram could not be exported.");
+        error_msg_box.exec();
+    }
+}
+
+//Save the diagram as an SVG image or a PDF document
+void MainWindow::on_actionExport_as_vector_graphics_triggered()
+{
+    QString file_name = QFileDialog::getSaveFileName(this, "Export the diagram as vector graphics", "untitled", "SVG image (*.svg);; PDF document (*.pdf)");
+    //Check if the user selected a path
+    if(file_name.isEmpty())
+    {
+        return;
+    }
+
+    bool accepted;
+    int dpi = QInputDialog::getInt(this, "Export resolution", "Stars closer than one dot at this resolution are merged (dpi):", 300, 72, 4800, 1, &accepted);
+    if(!accepted)
+    {
+        return;
+    }
+
+    if(!VectorExportFunctions::save_vector(file_name, dpi))
+    {
+        QMessageBox error_msg_box;
+        error_msg_box.setText("The diagram could not be exported.");
+        error_msg_box.exec();
+    }
 }
 
 //Save the list as a '.sgl' file
 void MainWindow::on_actionSave_list_triggered()
 {
-    FileIOFunctions::save_list_as_new(entry_list);
+    //A list which has already been saved only needs the changes appended to its journal
+    if(journaled_saving && !current_list_path.isEmpty())
+    {
+        if(JournalFunctions::flush())
+        {
+            return;
+        }
+    }
+
+    int journal_seq = journaled_saving ? journal_next_seq - 1 : -1;
+    QString file_name = FileDialogFunctions::save_list_as_new(DatasetFunctions::current(), journal_seq);
+    if(!file_name.isEmpty())
+    {
+        //The new file includes every change, so the journal starts again from scratch
+        finish_journal();
+        end_preview();
+        JournalFunctions::remove(file_name);
+        JournalFunctions::reset(journal_next_seq);
+        current_list_path = journaled_saving ? file_name : "";
+        list_file_path = file_name;
+    }
+}
+
+//Append the queued changes to the journal of the current list and wait for its running snapshot
+void MainWindow::finish_journal()
+{
+    if(journaled_saving)
+    {
+        JournalFunctions::flush();
+    }
+    snapshot_watcher->waitForFinished();
+
+    //The snapshot is not compacted anymore, its records are skipped by 'JournalFunctions::recover()' instead
+    snapshot_path = "";
+}
+
+//Enable or disable the journal autosave
+void MainWindow::on_actionJournaled_autosave_toggled(bool arg1)
+{
+    if(!arg1)
+    {
+        finish_journal();
+        current_list_path = "";
+    }
+    journaled_saving = arg1;
+}
+
+//Pack the lists opened from now on: the lists already loaded keep their full precision
+void MainWindow::on_actionCompact_storage_toggled(bool arg1)
+{
+    compact_storage = arg1;
+}
+
+//Append the queued changes to the journal and take a snapshot in the background when the journal grows too long
+void MainWindow::autosave_journal()
+{
+    if(!journaled_saving || current_list_path.isEmpty())
+    {
+        return;
+    }
+
+    JournalFunctions::flush();
+    autosave_ticks ++;
+
+    bool snapshot_due = journal_records_since_snapshot >= snapshot_records || (journal_records_since_snapshot > 0 && autosave_ticks >= snapshot_interval);
+    if(snapshot_due && !snapshot_watcher->isRunning())
+    {
+        autosave_ticks = 0;
+        snapshot_seq = journal_next_seq - 1;
+        snapshot_path = current_list_path;
+        //The background thread keeps its own snapshot, so the list can be edited while it is being written
+        snapshot_watcher->setFuture(QtConcurrent::run(FileIOFunctions::write_list, current_list_path, DatasetFunctions::current(), snapshot_seq));
+    }
+}
+
+//Drop the records included in the snapshot from the journal
+void MainWindow::journal_snapshot_finished()
+{
+    if(snapshot_watcher->result() && !snapshot_path.isEmpty() && snapshot_path == current_list_path)
+    {
+        JournalFunctions::compact(current_list_path, snapshot_seq);
+    }
 }
 
 //Clear the current list and starts a new one
 void MainWindow::on_actionNew_list_triggered()
 {
-    entry_list.clear();
+    finish_journal();
+    end_preview();
+    current_list_path = "";
+    JournalFunctions::reset(0);
+    list_file_path = "";
+
+    DatasetFunctions::publish_rows(vector<vector<QString>>());
+    selected_star = -1;
     manual_input = false;
     update_table(ui->table_entries); 
+    update_statistics();
     ui->openGLWidget_diagram->update();
     manual_input = true;
 }
@@ -279,9 +625,58 @@ void MainWindow::on_actionNew_list_triggered()
 //Open a '.sgl' file into a new list
 void MainWindow::on_actionOpen_list_triggered()
 {
+    QString file_name = QFileDialog::getOpenFileName(this, "Open list", "", "StarGraph list (*.sgl)");
+    //Check if the user selected a path
+    if(file_name.isEmpty())
+    {
+        return;
+    }
+
+    //A list which does not fit in the memory budget as strings is loaded in another way
+    LoadMode mode;
+    unsigned sample_size;
+    if(!choose_load_mode(file_name, true, &mode, &sample_size))
+    {
+        return;
+    }
+    if(mode != string_load)
+    {
+        open_degraded_list(file_name, mode, sample_size);
+        return;
+    }
+
+    finish_journal();
+    end_preview();
+
     manual_input = false;
-    entry_list = FileIOFunctions::open_list();
+    int journal_seq;
+    vector<vector<QString>> list = FileIOFunctions::open_list(file_name, &journal_seq);
+
+    //Replay the changes which were not included in the last snapshot, for example because of a crash
+    int recovered = JournalFunctions::recover(file_name, list, journal_seq);
+    DatasetFunctions::publish_rows(list);
+    selected_star = -1;
+    current_list_path = journaled_saving ? file_name : "";
+    list_file_path = file_name;
+    //A pyramid built before the recovered changes would not match the list anymore
+    if(recovered == 0)
+    {
+        load_density_pyramid();
+    }
+    else
+    {
+        density_pyramid.reset();
+    }
+    if(recovered > 0)
+    {
+        QMessageBox recovery_msg_box;
+        recovery_msg_box.setText(QString::number(recovered) + " unsaved changes have been recovered from the journal.");
+        recovery_msg_box.exec();
+    }
+
     update_table(ui->table_entries);
+    update_name_index();
+    update_statistics();
     ui->openGLWidget_diagram->update();
     manual_input = true;
 }
@@ -289,77 +684,1298 @@ void MainWindow::on_actionOpen_list_triggered()
 //Open a '.csv' file into a new list
 void MainWindow::on_actionImport_list_triggered()
 {
+    QString file_name = QFileDialog::getOpenFileName(this, "Import list", "", "CSV table (*.csv)");
+    //Check if the user selected a path
+    if(file_name.isEmpty())
+    {
+        return;
+    }
+
+    LoadMode mode;
+    unsigned sample_size;
+    if(!choose_load_mode(file_name, true, &mode, &sample_size))
+    {
+        return;
+    }
+    if(mode != string_load)
+    {
+        open_degraded_list(file_name, mode, sample_size);
+        return;
+    }
+
+    finish_journal();
+    end_preview();
+    current_list_path = "";
+    JournalFunctions::reset(0);
+    list_file_path = "";
+
     manual_input = false;
-    entry_list = FileIOFunctions::import_csv();
+    DatasetFunctions::publish_rows(FileDialogFunctions::import_csv(file_name));
+    selected_star = -1;
     update_table(ui->table_entries);
+    update_name_index();
+    update_statistics();
     ui->openGLWidget_diagram->update();
     manual_input = true;
 }
 
-void MainWindow::on_table_entries_cellChanged(int row, int column)
+//Merge a list or a table into the current list in the background, matching the stars by name
+void MainWindow::on_actionMerge_list_triggered()
 {
-    QString new_value = ui->table_entries->item(row, column)->text();
-    if(manual_input)
+    if(merge_watcher->isRunning())
     {
-        manual_input = 0;
-        switch(column)
+        return;
+    }
+
+    QString file_name = QFileDialog::getOpenFileName(this, "Merge list", "", "StarGraph list or CSV table (*.sgl *.csv)");
+    //Check if the user selected a path
+    if(file_name.isEmpty())
+    {
+        return;
+    }
+
+    bool accepted;
+    QStringList modes;
+    modes << "Update them with the merged values" << "Keep them unchanged";
+    QString mode = QInputDialog::getItem(this, "Merge list", "Stars already in the list:", modes, 0, false, &accepted);
+    if(!accepted)
+    {
+        return;
+    }
+    QStringList matchings;
+    matchings << "Same name" << "Same designation, ignoring case, spaces and punctuation";
+    QString matching = QInputDialog::getItem(this, "Merge list", "Match the stars with:", matchings, 0, false, &accepted);
+    if(!accepted)
+    {
+        return;
+    }
+
+    //The incoming list is loaded by the merge job as well
+    merge_base_dataset = DatasetFunctions::current();
+    ui->actionMerge_list->setEnabled(false);
+    merge_watcher->setFuture(QtConcurrent::run(MergeFunctions::merge_file, merge_base_dataset, file_name, mode == modes[0] ? update_existing_stars : keep_existing_stars, matching == matchings[1]));
+}
+
+//Publish the merged list and report what has been changed, unless the list has been edited in the meantime
+void MainWindow::merge_finished()
+{
+    ui->actionMerge_list->setEnabled(true);
+    MergeResult result = merge_watcher->result();
+    DatasetSnapshot base = merge_base_dataset;
+    merge_base_dataset.reset();
+    if(!result.supported)
+    {
+        FileDialogFunctions::show_unsupported_table();
+    }
+    if(base != DatasetFunctions::current())
+    {
+        QMessageBox error_msg_box;
+        error_msg_box.setText("The list has been changed while it was being merged, merge it again.");
+        error_msg_box.exec();
+        return;
+    }
+
+    //Journal the updated stars, then the appended ones
+    for(unsigned i = 0; i < result.conflicts.size() && result.updated_count > 0; i ++)
+    {
+        JournalFunctions::record_edit(static_cast<int>(result.conflicts[i].row), (*result.dataset)[result.conflicts[i].row]);
+    }
+    for(unsigned i = base->size(); i < result.dataset->size(); i ++)
+    {
+        JournalFunctions::record_add((*result.dataset)[i]);
+    }
+
+    DatasetFunctions::publish(result.dataset);
+    manual_input = false;
+    update_table(ui->table_entries);
+    manual_input = true;
+    update_name_index();
+    update_statistics();
+    ui->openGLWidget_diagram->update();
+
+    //List the first conflicts, a merge of large lists can have millions
+    QString conflict_details;
+    for(unsigned i = 0; i < result.conflicts.size() && i < 1000; i ++)
+    {
+        const MergeConflict& conflict = result.conflicts[i];
+        conflict_details += conflict.existing[0] + ": " + conflict.existing[1] + " K, " + conflict.existing[2] + " Sol in the list, " + conflict.incoming[1] + " K, " + conflict.incoming[2] + " Sol in the merged one\n";
+    }
+    if(result.conflicts.size() > 1000)
+    {
+        conflict_details += "and " + QString::number(result.conflicts.size() - 1000) + " more\n";
+    }
+
+    QMessageBox report_msg_box;
+    report_msg_box.setText(QString::number(result.matched_count) + " stars were already in the list, " + QString::number(result.updated_count) + " of them have been updated.\n"
+                           + QString::number(result.appended_count) + " stars have been appended, " + QString::number(result.duplicate_count) + " repeated stars have been ignored.\n"
+                           + QString::number(result.conflicts.size()) + " stars have a different temperature or luminosity in the two lists.");
+    if(!conflict_details.isEmpty())
+    {
+        report_msg_box.setDetailedText(conflict_details);
+    }
+    report_msg_box.exec();
+}
+
+//Overlay a list or a table as a new catalog layer
+void MainWindow::on_actionAdd_layer_triggered()
+{
+    QString file_name = QFileDialog::getOpenFileName(this, "Add catalog layer", "", "StarGraph list or CSV table (*.sgl *.csv)");
+    //Check if the user selected a path
+    if(file_name.isEmpty())
+    {
+        return;
+    }
+
+    LayerFunctions::add_layer(QFileInfo(file_name).completeBaseName(), StarDataset::from_rows(FileDialogFunctions::load_any(file_name)));
+    update_layer_menu();
+    ui->openGLWidget_diagram->update();
+}
+
+//Rebuild the menu containing the visibility and style settings of each catalog layer
+void MainWindow::update_layer_menu()
+{
+    ui->menuLayers->clear();
+    if(catalog_layers.empty())
+    {
+        ui->menuLayers->addAction("No catalog layers")->setEnabled(false);
+        return;
+    }
+
+    for(unsigned i = 0; i < catalog_layers.size(); i ++)
+    {
+        int id = catalog_layers[i].id;
+        QMenu* layer_menu = ui->menuLayers->addMenu(catalog_layers[i].name + " (" + QString::number(catalog_layers[i].dataset->size()) + " stars)");
+
+        //Every setting only changes the style of the layer, so the diagram is just drawn again
+        QAction* visible_action = layer_menu->addAction("Visible");
+        visible_action->setCheckable(true);
+        visible_action->setChecked(catalog_layers[i].visible);
+        connect(visible_action, &QAction::toggled, this, [this, id](bool checked)
         {
-            case 1:
-                entry_list[static_cast<unsigned>(row)][3] = ParameterCalculation::get_spectral_class_str(new_value);
-                ui->table_entries->setItem(row, 3, new QTableWidgetItem(ParameterCalculation::get_spectral_class_str(new_value)));
-                break;
+            LayerFunctions::find_layer(id)->visible = checked;
+            ui->openGLWidget_diagram->update();
+        });
 
-            case 2:
-                entry_list[static_cast<unsigned>(row)][4] = ParameterCalculation::get_absolute_magnitude_str(new_value);
-                ui->table_entries->setItem(row, 4, new QTableWidgetItem(ParameterCalculation::get_absolute_magnitude_str(new_value)));
-                break;
+        QAction* temperature_colour_action = layer_menu->addAction("Colour by temperature");
+        temperature_colour_action->setCheckable(true);
+        temperature_colour_action->setChecked(catalog_layers[i].temperature_colour);
+        connect(temperature_colour_action, &QAction::toggled, this, [this, id](bool checked)
+        {
+            LayerFunctions::find_layer(id)->temperature_colour = checked;
+            ui->openGLWidget_diagram->update();
+        });
 
-            case 3:
-                ui->table_entries->setItem(row, 3, new QTableWidgetItem(new_value.toUpper()));
-                entry_list[static_cast<unsigned>(row)][1] = ParameterCalculation::get_temperature_str(new_value);
-                ui->table_entries->setItem(row, 1, new QTableWidgetItem(ParameterCalculation::get_temperature_str(new_value)));
-                break;
+        QAction* colour_action = layer_menu->addAction("Colour...");
+        connect(colour_action, &QAction::triggered, this, [this, id, temperature_colour_action]()
+        {
+            QColor colour = QColorDialog::getColor(LayerFunctions::find_layer(id)->colour, this, "Layer colour");
+            if(colour.isValid())
+            {
+                LayerFunctions::find_layer(id)->colour = colour;
+                temperature_colour_action->setChecked(false);
+                ui->openGLWidget_diagram->update();
+            }
+        });
 
-            case 4:
-                entry_list[static_cast<unsigned>(row)][2] = ParameterCalculation::get_relative_luminosity_str(new_value);
-                ui->table_entries->setItem(row, 2, new QTableWidgetItem(ParameterCalculation::get_relative_luminosity_str(new_value)));
-                break;
+        QAction* round_markers_action = layer_menu->addAction("Round markers");
+        round_markers_action->setCheckable(true);
+        round_markers_action->setChecked(catalog_layers[i].round_markers);
+        connect(round_markers_action, &QAction::toggled, this, [this, id](bool checked)
+        {
+            LayerFunctions::find_layer(id)->round_markers = checked;
+            ui->openGLWidget_diagram->update();
+        });
+
+        QMenu* point_size_menu = layer_menu->addMenu("Point size");
+        QActionGroup* point_size_group = new QActionGroup(point_size_menu);
+        for(int size = 1; size <= 4; size ++)
+        {
+            QAction* point_size_action = point_size_menu->addAction(QString::number(size) + " px");
+            point_size_action->setCheckable(true);
+            point_size_action->setChecked(static_cast<int>(catalog_layers[i].point_size) == size);
+            point_size_group->addAction(point_size_action);
+            connect(point_size_action, &QAction::triggered, this, [this, id, size]()
+            {
+                LayerFunctions::find_layer(id)->point_size = size;
+                ui->openGLWidget_diagram->update();
+            });
         }
 
-        entry_list[static_cast<unsigned>(row)][static_cast<unsigned>(column)] = new_value;
-        entry_table = ui->table_entries;
-        ui->openGLWidget_diagram->update();
-        manual_input = 1;
+        layer_menu->addSeparator();
+        QAction* remove_action = layer_menu->addAction("Remove");
+        connect(remove_action, &QAction::triggered, this, [this, id]()
+        {
+            LayerFunctions::remove_layer(id);
+            ui->openGLWidget_diagram->update();
+
+            //The menu is rebuilt once the action which deletes it has returned
+            QMetaObject::invokeMethod(this, "update_layer_menu", Qt::QueuedConnection);
+        });
     }
 }
 
-void MainWindow::on_table_entries_cellPressed(int row, int column)
+//Add the next rows to the table when its end is reached
+void MainWindow::table_scrolled(int value)
 {
-    selected_star = row;
-    ui->openGLWidget_diagram->update();
+    if(value >= ui->table_entries->verticalScrollBar()->maximum())
+    {
+        load_table_rows(ui->table_entries);
+    }
+
+    //Fill the chunks on screen which were skipped by a jump to a search result
+    int top = ui->table_entries->rowAt(0);
+    int bottom = ui->table_entries->rowAt(ui->table_entries->viewport()->height() - 1);
+    if(top >= 0)
+    {
+        for(unsigned c = static_cast<unsigned>(top) / StarDataset::chunk_size; c <= static_cast<unsigned>(bottom >= 0 ? bottom : top) / StarDataset::chunk_size; c ++)
+        {
+            load_table_chunk(ui->table_entries, c);
+        }
+    }
 }
 
-void MainWindow::on_doubleSpinBox_highlighted_area_valueChanged(double arg1)
+//Sort the table by the clicked column, then in the other direction, then show the list in its own order again
+void MainWindow::table_header_clicked(int column)
 {
-    graph_pos_square_size = static_cast<int>(arg1 / 2);
-    ui->openGLWidget_diagram->update();
+    bool descending = false;
+    if(column == table_order.column)
+    {
+        if(table_order.descending)
+        {
+            column = -1;
+        }
+        descending = true;
+    }
+
+    if(column >= 0 && !SortFunctions::can_sort(DatasetFunctions::current()))
+    {
+        QMessageBox error_msg_box;
+        error_msg_box.setText("A list read from a column file cannot be sorted, save it as a new list to sort it.");
+        error_msg_box.exec();
+        return;
+    }
+
+    //A permutation which is not cached is computed in the background
+    if(!SortFunctions::sort_table(DatasetFunctions::current(), column, descending))
+    {
+        start_table_sort();
+    }
+    ui->table_entries->horizontalHeader()->setSortIndicator(column, descending ? Qt::DescendingOrder : Qt::AscendingOrder);
+    manual_input = false;
+    update_table(ui->table_entries);
+    manual_input = true;
 }
 
-void MainWindow::on_checkBox_highlight_selected_star_toggled(bool checked)
+//Sort the current list by the column of the table in the background, unless a sort is already running: it is started again once that one is done
+void MainWindow::start_table_sort()
 {
-    graph_highlight_selected_star = checked;
-    selected_star = -1;
+    if(!sort_watcher->isRunning())
+    {
+        sort_watcher->setFuture(QtConcurrent::run(SortFunctions::sort_list, DatasetFunctions::current(), table_order.column, table_order.descending));
+    }
+}
 
-    ui->openGLWidget_diagram->update();
+//Show the sorted table, or sort again if the list or the column have changed in the meantime
+void MainWindow::table_sort_finished()
+{
+    if(SortFunctions::apply(sort_watcher->result()))
+    {
+        manual_input = false;
+        update_table(ui->table_entries);
+        manual_input = true;
+    }
+    else if(table_order.column >= 0 && !table_order.rows)
+    {
+        start_table_sort();
+    }
 }
 
-void MainWindow::on_actionAbout_triggered()
+//Index the names of the current list in the background, unless the index is up to date or already being built
+void MainWindow::update_name_index()
 {
-    QMessageBox message_box_about;
-    message_box_about.setTextFormat(Qt::RichText);
-    message_box_about.setWindowTitle("About StarGraph v" + stargraph_version);
-    message_box_about.setText("StarGraph is an open source software developed by Filippo Dusi and licensed under GPL. The official SourceForge repository and the credits for the used assets can be found <a href='https://sourceforge.net/projects/stargraph'>here</a>.");
-    message_box_about.setIcon(QMessageBox::Icon::Information);
-    message_box_about.setButtonText(1, "Close");
-    message_box_about.exec();
+    DatasetSnapshot list = DatasetFunctions::current();
+    if(name_index_watcher->isRunning() || (name_index && name_index->get_dataset_version() == list->get_version()))
+    {
+        return;
+    }
+    name_index_watcher->setFuture(QtConcurrent::run(NameIndex::build, list));
+}
+
+//Keep the new index, bringing it up to the stars appended while it was built, and search again with it if the user is searching
+void MainWindow::name_index_finished()
+{
+    name_index = name_index_watcher->result();
+    if(name_index && !name_index->append(DatasetFunctions::current()))
+    {
+        update_name_index();
+    }
+    if(!ui->lineEdit_search->text().isEmpty())
+    {
+        on_lineEdit_search_textEdited(ui->lineEdit_search->text());
+    }
+}
+
+//Show the statistics of the current list, they are calculated first if they are out of date
+void MainWindow::on_actionStatistics_triggered()
+{
+    if(statistics_panel == nullptr)
+    {
+        statistics_panel = new StatisticsPanel(this);
+    }
+    statistics_panel->show();
+    statistics_panel->raise();
+    update_statistics();
+}
+
+//Calculate the statistics of the current list in the background, unless they are up to date or already being calculated
+//The statistics of an out-of-core list are only calculated when they are shown, since every chunk has to be read
+void MainWindow::update_statistics()
+{
+    DatasetSnapshot list = DatasetFunctions::current();
+    if(list_statistics.dataset_version == list->get_version())
+    {
+        if(statistics_panel != nullptr && statistics_panel->isVisible())
+        {
+            statistics_panel->show_statistics(list_statistics);
+        }
+        return;
+    }
+    if(statistics_watcher->isRunning() || (list->is_out_of_core() && (statistics_panel == nullptr || !statistics_panel->isVisible())))
+    {
+        return;
+    }
+    statistics_watcher->setFuture(QtConcurrent::run(StatisticsFunctions::build, list));
+}
+
+//Keep the new statistics, bringing them up to the stars appended in the meantime, and calculate them again if the list has been changed in another way
+void MainWindow::statistics_finished()
+{
+    list_statistics = statistics_watcher->result();
+    StatisticsFunctions::record_appended(list_statistics, DatasetFunctions::current());
+    update_statistics();
+}
+
+//Start or stop listening for live stars on a local socket
+void MainWindow::on_actionLive_ingestion_toggled(bool checked)
+{
+    if(!checked)
+    {
+        live_listener->stop();
+        live_timer->stop();
+        live_ingest_tick();
+        ui->actionLive_ingestion->setText("Listen for live stars");
+        return;
+    }
+    if(live_listener == nullptr)
+    {
+        live_listener = new LiveListener();
+    }
+    if(live_listener->is_running())
+    {
+        return;
+    }
+
+    bool ok;
+    QString server_name = QInputDialog::getText(this, "Listen for live stars", "Local socket name:", QLineEdit::Normal, "stargraph", &ok);
+    QString error = ok && !server_name.isEmpty() ? live_listener->start(server_name) : "";
+    if(!ok || server_name.isEmpty() || !error.isEmpty())
+    {
+        if(!error.isEmpty())
+        {
+            QMessageBox error_msg_box;
+            error_msg_box.setText("The socket could not be opened: " + error);
+            error_msg_box.exec();
+        }
+        ui->actionLive_ingestion->setChecked(false);
+        return;
+    }
+
+    //The received stars are kept in memory until the list is saved, like the changes to an out-of-core list
+    finish_journal();
+    current_list_path = "";
+    JournalFunctions::reset(0);
+    live_ticks = 0;
+    live_timer->start(live_frame_interval);
+}
+
+//Append the stars received since the last frame as a single snapshot, the diagram uploads only their vertices and is repainted once
+void MainWindow::live_ingest_tick()
+{
+    //Once the listener has stopped, all the stars left in the buffer are appended
+    vector<vector<QString>> rows;
+    if(live_listener->take(rows, live_timer->isActive() ? max_live_batch : LiveListener::buffer_capacity) > 0)
+    {
+        DatasetFunctions::publish(DatasetFunctions::current()->with_changes(vector<pair<unsigned, vector<QString>>>(), rows));
+
+        //The statistics and the name index only add the new stars, they are calculated again in the background if they were made from another snapshot
+        DatasetSnapshot list = DatasetFunctions::current();
+        if(!StatisticsFunctions::record_appended(list_statistics, list))
+        {
+            update_statistics();
+        }
+        if(!name_index || !name_index->append(list))
+        {
+            update_name_index();
+        }
+
+        //Only the first rows of the table are filled here, the others when they are scrolled to
+        if(ui->table_entries->rowCount() < static_cast<int>(StarDataset::chunk_size))
+        {
+            load_table_chunk(ui->table_entries, 0);
+        }
+        ui->openGLWidget_diagram->update();
+    }
+
+    if(++ live_ticks >= live_refresh_ticks || !live_timer->isActive())
+    {
+        live_ticks = 0;
+        update_statistics();
+        if(live_listener->is_running())
+        {
+            ui->actionLive_ingestion->setText("Listen for live stars (" + QString::number(live_listener->get_received_count()) + " received, " + QString::number(live_listener->get_rejected_count()) + " rejected)");
+        }
+    }
+}
+
+//Play the lists chosen, or every list of the directory of a single list chosen, as an animation
+void MainWindow::on_actionPlay_snapshot_sequence_triggered()
+{
+    QStringList file_names = QFileDialog::getOpenFileNames(this, "Play snapshot sequence, choose one list to play its whole directory", "", "StarGraph lists (*.sgl *.csv)");
+    if(file_names.size() == 1)
+    {
+        file_names = SnapshotPlayer::get_sequence_files(QFileInfo(file_names[0]).absolutePath());
+    }
+    if(file_names.isEmpty())
+    {
+        return;
+    }
+
+    //The frames replace the list without being journaled, like the stars received live
+    finish_journal();
+    end_preview();
+    current_list_path = "";
+    JournalFunctions::reset(0);
+    list_file_path = "";
+    selected_star = -1;
+
+    if(playback_panel == nullptr)
+    {
+        playback_panel = new PlaybackPanel(this);
+    }
+    playback_panel->start(file_names, [this](const PlaybackFrame& frame, bool playing)
+    {
+        show_playback_frame(frame, playing);
+    });
+}
+
+//Show a frame of the playback on the diagram, whose vertices are already built; the table and the other views follow once the playback stops on a frame
+void MainWindow::show_playback_frame(const PlaybackFrame& frame, bool playing)
+{
+    DatasetFunctions::publish(frame.dataset);
+    if(frame.vertices)
+    {
+        ui->openGLWidget_diagram->set_prepared_vertices(frame.dataset->get_version(), frame.projection, frame.vertices, frame.faint_count);
+    }
+    ui->openGLWidget_diagram->update();
+
+    if(!playing)
+    {
+        manual_input = false;
+        update_table(ui->table_entries);
+        manual_input = true;
+        update_name_index();
+        update_statistics();
+    }
+}
+
+//Show the stars whose name starts with or contains the text typed so far
+void MainWindow::on_lineEdit_search_textEdited(const QString& text)
+{
+    //The index of an older snapshot is used until the new one is ready, the names shown are always the current ones
+    //Its rows may belong to other stars by then, or to another list, so they are only kept if the current name still contains the text
+    update_name_index();
+    DatasetSnapshot list = DatasetFunctions::current();
+    bool outdated = name_index && name_index->get_dataset_version() != list->get_version();
+    QStringList names;
+    search_rows.clear();
+    if(name_index)
+    {
+        vector<unsigned> rows = name_index->search(text, max_search_results);
+        for(unsigned i = 0; i < rows.size(); i ++)
+        {
+            if(rows[i] >= list->size())
+            {
+                continue;
+            }
+            QString name = list->get_name(rows[i]);
+            if(!outdated || name.contains(text, Qt::CaseInsensitive))
+            {
+                search_rows.push_back(rows[i]);
+                names << name;
+            }
+        }
+    }
+    search_model->setStringList(names);
+    if(!names.isEmpty())
+    {
+        ui->lineEdit_search->completer()->complete();
+    }
+}
+
+//Select the star chosen among the results, scroll the table to it and flash its position on the diagram
+void MainWindow::search_result_activated(const QModelIndex& index)
+{
+    QAbstractProxyModel* completion_model = static_cast<QAbstractProxyModel*>(ui->lineEdit_search->completer()->completionModel());
+    int result = completion_model->mapToSource(index).row();
+    if(result < 0 || result >= static_cast<int>(search_rows.size()) || search_rows[static_cast<unsigned>(result)] >= DatasetFunctions::current()->size())
+    {
+        return;
+    }
+
+    unsigned row = search_rows[static_cast<unsigned>(result)];
+    unsigned position = SortFunctions::get_table_position(row);
+    selected_star = static_cast<int>(row);
+    load_table_chunk(ui->table_entries, position / StarDataset::chunk_size);
+    ui->table_entries->scrollToItem(ui->table_entries->item(static_cast<int>(position), 0), QAbstractItemView::PositionAtCenter);
+    ui->openGLWidget_diagram->flash_selected_star();
+}
+
+//Open a column file, or convert a csv table to one first, and explore it without loading it into memory
+void MainWindow::on_actionOpen_large_catalog_triggered()
+{
+    QString file_name = QFileDialog::getOpenFileName(this, "Open large catalog", "", "StarGraph column file or CSV table (*.sgc *.csv)");
+    //Check if the user selected a path
+    if(file_name.isEmpty())
+    {
+        return;
+    }
+
+    //A table is converted in the background, unless its column file is up to date
+    if(!file_name.endsWith(".sgc", Qt::CaseInsensitive))
+    {
+        if(ColumnFileFunctions::is_up_to_date(file_name, ColumnFileFunctions::get_column_file_path(file_name)))
+        {
+            open_column_file(ColumnFileFunctions::get_column_file_path(file_name));
+        }
+        else if(confirm_column_file(file_name))
+        {
+            start_conversion(file_name, false);
+        }
+        return;
+    }
+    open_column_file(file_name);
+}
+
+//Open the column file 'column_file_name' as the current list, without loading it into memory
+void MainWindow::open_column_file(QString column_file_name)
+{
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    shared_ptr<ColumnFileStore> store = make_shared<ColumnFileStore>();
+    DatasetSnapshot list;
+    if(store->open(column_file_name))
+    {
+        list = StarDataset::from_source(store);
+    }
+    QApplication::restoreOverrideCursor();
+    if(!list)
+    {
+        QMessageBox error_msg_box;
+        error_msg_box.setText("The selected catalog could not be opened.");
+        error_msg_box.exec();
+        return;
+    }
+
+    //The changes to an out-of-core list are kept in memory until it is saved as a new list
+    finish_journal();
+    end_preview();
+    current_list_path = "";
+    JournalFunctions::reset(0);
+
+    manual_input = false;
+    DatasetFunctions::publish(list);
+    selected_star = -1;
+    list_file_path = column_file_name;
+    load_density_pyramid();
+    update_table(ui->table_entries);
+    update_name_index();
+    update_statistics();
+    ui->openGLWidget_diagram->update();
+    manual_input = true;
+}
+
+//Returns true if the column file of 'file_name' can be written: it does not exist yet or the user agreed to replace it
+bool MainWindow::confirm_column_file(QString file_name)
+{
+    QString column_file_name = ColumnFileFunctions::get_column_file_path(file_name);
+    if(!QFile::exists(column_file_name))
+    {
+        return true;
+    }
+    QMessageBox overwrite_msg_box;
+    overwrite_msg_box.setText("The column file " + QFileInfo(column_file_name).fileName() + " is older than " + QFileInfo(file_name).fileName() + ". Convert the table again and overwrite it?");
+    overwrite_msg_box.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
+    return overwrite_msg_box.exec() == QMessageBox::Yes;
+}
+
+//Convert the table 'file_name' to its column file in the background, showing the progress
+void MainWindow::start_conversion(QString file_name, bool degraded)
+{
+    if(conversion_watcher->isRunning())
+    {
+        return;
+    }
+    conversion_file_path = file_name;
+    conversion_degraded = degraded;
+    conversion_progress = make_shared<ConversionProgress>();
+
+    conversion_dialog = new QProgressDialog("Converting " + QFileInfo(file_name).fileName() + " to a column file...", "Cancel", 0, 1000, this);
+    conversion_dialog->setWindowModality(Qt::WindowModal);
+    conversion_dialog->setMinimumDuration(0);
+    conversion_dialog->setValue(0);
+    connect(conversion_dialog, &QProgressDialog::canceled, this, []()
+    {
+        conversion_progress->cancelled = true;
+    });
+
+    conversion_watcher->setFuture(QtConcurrent::run(ColumnFileFunctions::convert_csv, file_name, ColumnFileFunctions::get_column_file_path(file_name), conversion_progress.get()));
+    conversion_timer->start(100);
+}
+
+//Show the part of the table converted so far
+void MainWindow::conversion_progressed()
+{
+    qint64 file_size = max<qint64>(1, QFileInfo(conversion_file_path).size());
+    if(conversion_dialog != nullptr && !conversion_progress->cancelled)
+    {
+        conversion_dialog->setValue(static_cast<int>(min<qint64>(999, conversion_progress->read_bytes * 1000 / file_size)));
+    }
+}
+
+//Open the column file once the conversion is done, unless it was cancelled
+void MainWindow::conversion_finished()
+{
+    conversion_timer->stop();
+    conversion_dialog->deleteLater();
+    conversion_dialog = nullptr;
+    if(conversion_progress->cancelled)
+    {
+        return;
+    }
+    if(!conversion_watcher->result())
+    {
+        QMessageBox error_msg_box;
+        error_msg_box.setText("The selected catalog could not be converted.");
+        error_msg_box.exec();
+        return;
+    }
+
+    if(conversion_degraded)
+    {
+        open_degraded_list(conversion_file_path, disk_load, 0);
+    }
+    else
+    {
+        open_column_file(ColumnFileFunctions::get_column_file_path(conversion_file_path));
+    }
+}
+
+//Open the density pyramid stored next to the file of the current list, if there is one
+void MainWindow::load_density_pyramid()
+{
+    shared_ptr<DensityPyramid> pyramid = make_shared<DensityPyramid>();
+    if(!list_file_path.isEmpty() && pyramid->open(list_file_path, DatasetFunctions::current()->size()))
+    {
+        pyramid->set_dataset_version(DatasetFunctions::current()->get_version());
+        density_pyramid = pyramid;
+    }
+    else
+    {
+        density_pyramid.reset();
+    }
+}
+
+//Count the stars of the current list into a density pyramid in the background
+void MainWindow::on_actionBuild_density_pyramid_triggered()
+{
+    if(list_file_path.isEmpty())
+    {
+        QMessageBox error_msg_box;
+        error_msg_box.setText("Save the list before building its density pyramid.");
+        error_msg_box.exec();
+        return;
+    }
+    if(pyramid_watcher->isRunning())
+    {
+        return;
+    }
+
+    pyramid_dataset = DatasetFunctions::current();
+    QFileInfo list_info(list_file_path);
+    ui->actionBuild_density_pyramid->setEnabled(false);
+    pyramid_watcher->setFuture(QtConcurrent::run(PyramidBuilder::build, pyramid_dataset, list_file_path, list_info.size(), list_info.lastModified().toMSecsSinceEpoch()));
+}
+
+//Draw the list from the new pyramid, unless it has been changed in the meantime
+void MainWindow::density_pyramid_finished()
+{
+    ui->actionBuild_density_pyramid->setEnabled(true);
+    if(pyramid_watcher->result() && pyramid_dataset == DatasetFunctions::current())
+    {
+        load_density_pyramid();
+        ui->openGLWidget_diagram->update();
+    }
+    pyramid_dataset.reset();
+}
+
+//Enable the bulk operations only when the current list has selected stars
+//Deleting from an out-of-core list would move every chunk after the first deleted star to memory, so it is only offered for lists in memory
+void MainWindow::update_selection_actions()
+{
+    DatasetSnapshot list = DatasetFunctions::current();
+    unsigned count = SelectionFunctions::get_count(*list);
+    ui->menuSelection->setTitle(count > 0 ? "Selection (" + QString::number(count) + " stars)" : "Selection");
+    ui->actionDelete_selected_stars->setEnabled(count > 0 && !list->is_out_of_core());
+    ui->actionExport_selected_stars->setEnabled(count > 0);
+    ui->actionRecolour_selected_stars->setEnabled(count > 0);
+    ui->actionClear_selection->setEnabled(count > 0);
+}
+
+//Remove the selected stars from the list with a single new snapshot, the table is filled again only once
+void MainWindow::remove_selected_stars()
+{
+    DatasetSnapshot list = DatasetFunctions::current();
+
+    //The rows are recorded from the last one, so their indexes are still valid when the journal is replayed
+    for(unsigned i = list->size(); i -- > 0;)
+    {
+        if(SelectionFunctions::is_selected(i))
+        {
+            JournalFunctions::record_delete(static_cast<int>(i));
+        }
+    }
+
+    DatasetFunctions::publish(list->without_rows(star_selection.bits));
+    SelectionFunctions::clear();
+    selected_star = -1;
+
+    manual_input = false;
+    update_table(ui->table_entries);
+    manual_input = true;
+    update_statistics();
+    update_selection_actions();
+    ui->openGLWidget_diagram->update();
+}
+
+void MainWindow::on_actionDelete_selected_stars_triggered()
+{
+    DatasetSnapshot list = DatasetFunctions::current();
+    if(SelectionFunctions::get_count(*list) > 0 && !list->is_out_of_core())
+    {
+        remove_selected_stars();
+    }
+}
+
+//Save the selected stars as a new list
+void MainWindow::on_actionExport_selected_stars_triggered()
+{
+    DatasetSnapshot list = DatasetFunctions::current();
+    if(SelectionFunctions::get_count(*list) == 0)
+    {
+        return;
+    }
+
+    QString file_name = QFileDialog::getSaveFileName(this, "Export selected stars", "", "StarGraph list (*.sgl);;StarGraph column file (*.sgc)");
+    //Check if the user selected a path
+    if(file_name.isEmpty())
+    {
+        return;
+    }
+
+    vector<vector<QString>> rows = SelectionFunctions::get_rows(*list, true);
+    bool written;
+    if(file_name.endsWith(".sgc", Qt::CaseInsensitive))
+    {
+        written = ColumnFileFunctions::write_column_file(file_name, rows);
+    }
+    else
+    {
+        written = FileIOFunctions::write_list(file_name, StarDataset::from_rows(rows, false), -1);
+    }
+
+    if(!written)
+    {
+        QMessageBox error_msg_box;
+        error_msg_box.setText("The selected stars could not be exported.");
+        error_msg_box.exec();
+    }
+}
+
+//The list has no colour of its own for each star, so the selected stars are copied to a new catalog layer drawn over the list in the chosen colour
+//The stars stay in the list: the layer is not saved with it
+void MainWindow::on_actionRecolour_selected_stars_triggered()
+{
+    DatasetSnapshot list = DatasetFunctions::current();
+    if(SelectionFunctions::get_count(*list) == 0)
+    {
+        return;
+    }
+
+    QColor colour = QColorDialog::getColor(QColor(255, 0, 255), this, "Recolour selected stars");
+    if(!colour.isValid())
+    {
+        return;
+    }
+
+    int id = LayerFunctions::add_layer("Selection", StarDataset::from_rows(SelectionFunctions::get_rows(*list, true), list->is_packed()));
+    CatalogLayer* layer = LayerFunctions::find_layer(id);
+    layer->colour = colour;
+    layer->round_markers = false;
+    layer->point_size = graph_point_size;
+    layer->over_list = true;
+
+    SelectionFunctions::clear();
+    update_selection_actions();
+    update_layer_menu();
+    ui->openGLWidget_diagram->update();
+}
+
+void MainWindow::on_actionClear_selection_triggered()
+{
+    SelectionFunctions::clear();
+    update_selection_actions();
+    ui->openGLWidget_diagram->update();
+}
+
+//Set how much memory the chunks of an out-of-core list can use
+void MainWindow::on_actionChunk_cache_size_triggered()
+{
+    bool accepted;
+    int size = QInputDialog::getInt(this, "Chunk cache size", "Memory used by the chunks of a large catalog (MB):", chunk_cache_size, 16, 1048576, 256, &accepted);
+    if(accepted)
+    {
+        chunk_cache_size = size;
+    }
+}
+
+//Set how much memory the lists opened or imported can use, '0' for no limit
+void MainWindow::on_actionMemory_budget_triggered()
+{
+    bool accepted;
+    int size = QInputDialog::getInt(this, "Memory budget", "Memory the lists can use, 0 for no limit (MB):", memory_budget, 0, 1048576, 256, &accepted);
+    if(accepted)
+    {
+        memory_budget = size;
+    }
+}
+
+//Show the memory counted for the lists, the table, the file buffers, the diagram and the indexes
+void MainWindow::on_actionMemory_usage_triggered()
+{
+    if(memory_panel == nullptr)
+    {
+        memory_panel = new MemoryPanel(this);
+    }
+    memory_panel->show();
+    memory_panel->raise();
+}
+
+//Choose how to load 'file_name' within the memory budget: as strings if they fit, in the packed form if only that fits, otherwise as the user chooses
+//The estimate assumes the current list is released first; returns false if the user cancelled, 'sample_size' is set for a sample
+bool MainWindow::choose_load_mode(QString file_name, bool allow_sample, LoadMode* mode, unsigned* sample_size)
+{
+    *mode = string_load;
+    *sample_size = 0;
+    qint64 budget = MemoryFunctions::get_budget();
+    if(budget == 0)
+    {
+        return true;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    ListEstimate estimate = FileIOFunctions::estimate_list(file_name);
+    QApplication::restoreOverrideCursor();
+    qint64 available = budget - (MemoryFunctions::get_total() - DatasetFunctions::current()->get_memory_size() - MemoryFunctions::get_usage(table_memory));
+    if(estimate.string_bytes <= available)
+    {
+        return true;
+    }
+    if(estimate.packed_bytes <= available)
+    {
+        *mode = packed_load;
+        return true;
+    }
+
+    QMessageBox budget_msg_box;
+    budget_msg_box.setText("The list has about " + QString::number(estimate.row_count) + " stars, which need about " + MemoryFunctions::get_size_str(estimate.packed_bytes) + " even in compact storage, while " + MemoryFunctions::get_size_str(max<qint64>(available, 0)) + " are left in the memory budget.");
+    budget_msg_box.setInformativeText(allow_sample ? "It can be opened from a column file on disk, or a random sample of its stars can be loaded." : "It can be opened from a column file on disk.");
+    QPushButton* disk_button = budget_msg_box.addButton("Open on disk", QMessageBox::AcceptRole);
+    QPushButton* sample_button = allow_sample ? budget_msg_box.addButton("Load a sample", QMessageBox::AcceptRole) : nullptr;
+    budget_msg_box.addButton(QMessageBox::Cancel);
+    budget_msg_box.exec();
+    if(budget_msg_box.clickedButton() == disk_button)
+    {
+        *mode = disk_load;
+        return true;
+    }
+    if(sample_button != nullptr && budget_msg_box.clickedButton() == sample_button)
+    {
+        //Other subsystems may already use the whole budget, the sample then takes at least a megabyte
+        qint64 room = max<qint64>(available, 1024 * 1024);
+        *mode = sample_load;
+        double size = static_cast<double>(estimate.row_count) * room / max<qint64>(1, estimate.packed_bytes);
+        *sample_size = static_cast<unsigned>(max(1.0, min(size, static_cast<double>(UINT_MAX))));
+        return true;
+    }
+    return false;
+}
+
+//Open 'file_name' in the packed form, from a column file or as a sample, releasing the current list first so both are never in memory at once
+//The journal is not replayed and the list is not journaled: it is saved as a new list, like a large catalog
+void MainWindow::open_degraded_list(QString file_name, LoadMode mode, unsigned sample_size)
+{
+    //The column file is written in the background first, the list is opened once it is done
+    if(mode == disk_load && !ColumnFileFunctions::is_up_to_date(file_name, ColumnFileFunctions::get_column_file_path(file_name)))
+    {
+        if(confirm_column_file(file_name))
+        {
+            start_conversion(file_name, true);
+        }
+        return;
+    }
+
+    finish_journal();
+    end_preview();
+    current_list_path = "";
+    JournalFunctions::reset(0);
+    list_file_path = "";
+
+    manual_input = false;
+    DatasetFunctions::publish_rows(vector<vector<QString>>());
+    selected_star = -1;
+    update_table(ui->table_entries);
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    DatasetSnapshot list;
+    bool supported = true;
+    quint64 row_count = 0;
+    if(mode == disk_load)
+    {
+        QString column_file_name = ColumnFileFunctions::get_column_file_path(file_name);
+        shared_ptr<ColumnFileStore> store = make_shared<ColumnFileStore>();
+        if(store->open(column_file_name))
+        {
+            list = StarDataset::from_source(store);
+            list_file_path = column_file_name;
+        }
+    }
+    else if(mode == packed_load)
+    {
+        list = FileIOFunctions::load_packed(file_name, &supported);
+        list_file_path = file_name;
+    }
+    else
+    {
+        //A uniform sample keeps the proportions of the list, so it can stand for it in the statistics
+        ListSample sample = SampleFunctions::read_sample(file_name, sample_size, uniform_sample);
+        supported = sample.supported;
+        list = StarDataset::from_rows(sample.rows, true);
+        row_count = sample.row_count;
+    }
+    QApplication::restoreOverrideCursor();
+
+    if(list && supported)
+    {
+        DatasetFunctions::publish(list);
+    }
+    else
+    {
+        list_file_path = "";
+    }
+    load_density_pyramid();
+
+    QMessageBox budget_msg_box;
+    if(!list || !supported)
+    {
+        budget_msg_box.setText("The selected list could not be opened.");
+    }
+    else if(mode == packed_load)
+    {
+        budget_msg_box.setText("The list has been loaded in compact storage to fit in the memory budget.");
+    }
+    else if(mode == disk_load)
+    {
+        budget_msg_box.setText("The list is read from the column file " + QFileInfo(list_file_path).fileName() + " to fit in the memory budget.");
+    }
+    else
+    {
+        budget_msg_box.setText("A random sample of " + QString::number(list->size()) + " of the " + QString::number(row_count) + " stars has been loaded to fit in the memory budget.");
+    }
+    if(list && supported && file_name.endsWith(".sgl", Qt::CaseInsensitive) && QFile::exists(JournalFunctions::get_journal_path(file_name)))
+    {
+        budget_msg_box.setInformativeText("The journal of the list has not been replayed, its changes are recovered when the list is opened whole.");
+    }
+    budget_msg_box.exec();
+
+    update_table(ui->table_entries);
+    update_name_index();
+    update_statistics();
+    ui->openGLWidget_diagram->update();
+    manual_input = true;
+}
+
+void MainWindow::on_table_entries_cellChanged(int row, int column)
+{
+    QString new_value = ui->table_entries->item(row, column)->text();
+    if(manual_input)
+    {
+        manual_input = 0;
+
+        //Edit a copy of the stored values and publish it in a new snapshot: the derived columns of this row are calculated again
+        unsigned list_row = SortFunctions::get_table_row(static_cast<unsigned>(row));
+        unsigned old_version = DatasetFunctions::current()->get_version();
+        vector<QString> entry = (*DatasetFunctions::current())[list_row];
+        vector<QString> old_entry = entry;
+        switch(column)
+        {
+            case 0:
+            case 1:
+            case 2:
+                entry[static_cast<unsigned>(column)] = new_value;
+                break;
+
+            case 3:
+                entry[1] = ParameterCalculation::get_temperature_str(new_value);
+                break;
+
+            case 4:
+                entry[2] = ParameterCalculation::get_relative_luminosity_str(new_value);
+                break;
+        }
+
+        DatasetFunctions::set_row(list_row, entry);
+        JournalFunctions::record_edit(static_cast<int>(list_row), entry);
+        StatisticsFunctions::record_edit(old_version, DatasetFunctions::current()->get_version(), old_entry, entry);
+        SortFunctions::record_edit(old_version, DatasetFunctions::current(), list_row);
+        update_statistics();
+
+        //Show the new values of the row
+        DatasetSnapshot list = DatasetFunctions::current();
+        for(int j = 0; j < column_count; j ++)
+        {
+            ui->table_entries->setItem(row, j, create_item(*list, list_row, j));
+        }
+
+        entry_table = ui->table_entries;
+        ui->openGLWidget_diagram->update();
+        manual_input = 1;
+    }
+}
+
+void MainWindow::on_table_entries_cellPressed(int row, int column)
+{
+    selected_star = static_cast<int>(SortFunctions::get_table_row(static_cast<unsigned>(row)));
+    ui->openGLWidget_diagram->update();
+}
+
+void MainWindow::on_doubleSpinBox_highlighted_area_valueChanged(double arg1)
+{
+    graph_pos_square_size = static_cast<int>(arg1 / 2);
+    ui->openGLWidget_diagram->update();
+}
+
+void MainWindow::on_checkBox_highlight_selected_star_toggled(bool checked)
+{
+    graph_highlight_selected_star = checked;
+    selected_star = -1;
+
+    ui->openGLWidget_diagram->update();
+}
+
+void MainWindow::on_actionAbout_triggered()
+{
+    QMessageBox message_box_about;
+    message_box_about.setTextFormat(Qt::RichText);
+    message_box_about.setWindowTitle("About StarGraph v" + stargraph_version);
+    message_box_about.setText("StarGraph is an open source software developed by Filippo Dusi and licensed under GPL. The official SourceForge repository and the credits for the used assets can be found <a href='https://sourceforge.net/projects/stargraph'>here</a>.");
+    message_box_about.setIcon(QMessageBox::Icon::Information);
+    message_box_about.setButtonText(1, "Close");
+    message_box_about.exec();
+}
+
+//Open a sample of a list or a table, read in a single pass with bounded memory, which the whole list can replace later
+void MainWindow::on_actionOpen_preview_triggered()
+{
+    QString file_name = QFileDialog::getOpenFileName(this, "Open preview", "", "StarGraph list or CSV table (*.sgl *.csv)");
+    //Check if the user selected a path
+    if(file_name.isEmpty())
+    {
+        return;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    ListSample sample = SampleFunctions::read_sample(file_name, static_cast<unsigned>(preview_size), preview_stratified ? spectral_class_sample : uniform_sample);
+    QApplication::restoreOverrideCursor();
+    if(!sample.supported)
+    {
+        QMessageBox error_msg_box;
+        error_msg_box.setText("The selected list could not be opened.");
+        error_msg_box.exec();
+        return;
+    }
+
+    //The preview is not journaled, its changes are lost when the whole list replaces it
+    finish_journal();
+    current_list_path = "";
+    JournalFunctions::reset(0);
+    list_file_path = "";
+
+    manual_input = false;
+    DatasetFunctions::publish_rows(sample.rows);
+    preview_file_path = file_name;
+    preview_version = DatasetFunctions::current()->get_version();
+    preview_row_count = sample.row_count;
+    selected_star = -1;
+    density_pyramid.reset();
+    update_preview_state();
+    update_table(ui->table_entries);
+    update_name_index();
+    update_statistics();
+    ui->openGLWidget_diagram->update();
+    manual_input = true;
+}
+
+//Load the whole list of the preview in the background, within the memory budget; the preview stays usable until it is replaced
+void MainWindow::on_actionLoad_full_list_triggered()
+{
+    if(preview_file_path.isEmpty() || full_load_watcher->isRunning())
+    {
+        return;
+    }
+
+    LoadMode mode;
+    unsigned sample_size;
+    if(!choose_load_mode(preview_file_path, false, &mode, &sample_size))
+    {
+        return;
+    }
+    if(mode == disk_load && !ColumnFileFunctions::is_up_to_date(preview_file_path, ColumnFileFunctions::get_column_file_path(preview_file_path)) && !confirm_column_file(preview_file_path))
+    {
+        return;
+    }
+    full_load_path = preview_file_path;
+    full_load_mode = mode;
+    full_load_watcher->setFuture(QtConcurrent::run(PreviewFunctions::load_full, full_load_path, mode));
+    update_preview_state();
+}
+
+//Replace the preview with its whole list, unless another list has been opened in the meantime
+void MainWindow::full_load_finished()
+{
+    FullListLoad load = full_load_watcher->result();
+    if(preview_file_path != full_load_path)
+    {
+        update_preview_state();
+        return;
+    }
+    if(!load.supported)
+    {
+        update_preview_state();
+        QMessageBox error_msg_box;
+        error_msg_box.setText("The full list could not be loaded, the preview has been kept.");
+        error_msg_box.exec();
+        return;
+    }
+    if(DatasetFunctions::current()->get_version() != preview_version)
+    {
+        QMessageBox replace_msg_box;
+        replace_msg_box.setText("The preview has been changed. Replace it with the full list anyway?");
+        replace_msg_box.setStandardButtons(QMessageBox::Yes | QMessageBox::No);
+        if(replace_msg_box.exec() != QMessageBox::Yes)
+        {
+            update_preview_state();
+            return;
+        }
+    }
+
+    //A list loaded as strings is journaled like an opened one, the other ones like a large catalog
+    finish_journal();
+    bool journaled = full_load_mode == string_load && full_load_path.endsWith(".sgl", Qt::CaseInsensitive);
+    int recovered = 0;
+    DatasetSnapshot list = load.dataset;
+    if(!list)
+    {
+        recovered = JournalFunctions::recover(full_load_path, load.rows, load.journal_seq);
+        list = StarDataset::from_rows(load.rows);
+    }
+    else
+    {
+        JournalFunctions::reset(journaled ? load.journal_seq + 1 : 0);
+    }
+
+    manual_input = false;
+    DatasetFunctions::publish(list);
+    current_list_path = journaled && journaled_saving ? full_load_path : "";
+    list_file_path = full_load_mode == disk_load ? load.column_file_path : (journaled || full_load_mode == packed_load ? full_load_path : "");
+    selected_star = -1;
+    if(recovered == 0)
+    {
+        load_density_pyramid();
+    }
+    else
+    {
+        density_pyramid.reset();
+    }
+    end_preview();
+    if(recovered > 0)
+    {
+        QMessageBox recovery_msg_box;
+        recovery_msg_box.setText(QString::number(recovered) + " unsaved changes have been recovered from the journal.");
+        recovery_msg_box.exec();
+    }
+
+    update_table(ui->table_entries);
+    update_name_index();
+    update_statistics();
+    ui->openGLWidget_diagram->update();
+    manual_input = true;
+}
+
+//Set how many stars a preview keeps
+void MainWindow::on_actionPreview_size_triggered()
+{
+    bool accepted;
+    int size = QInputDialog::getInt(this, "Preview size", "Stars kept by a preview:", preview_size, 1000, 100000000, 10000, &accepted);
+    if(accepted)
+    {
+        preview_size = size;
+    }
+}
+
+//Sample each spectral class on its own, or every star with the same chance
+void MainWindow::on_actionStratified_preview_toggled(bool arg1)
+{
+    preview_stratified = arg1;
+}
+
+//The list is not a preview anymore, a full list still loading for it is discarded when it finishes
+void MainWindow::end_preview()
+{
+    preview_file_path = "";
+    update_preview_state();
+}
+
+//Show in the title whether the list is a preview, and allow loading the whole list only then
+void MainWindow::update_preview_state()
+{
+    QString title = "StarGraph v" + stargraph_version;
+    if(!preview_file_path.isEmpty())
+    {
+        title += " - preview of " + QFileInfo(preview_file_path).fileName() + ", " + QString::number(DatasetFunctions::current()->size()) + " of " + QString::number(preview_row_count) + " stars";
+        if(full_load_watcher->isRunning())
+        {
+            title += ", loading the full list";
+        }
+    }
+    setWindowTitle(title);
+    ui->actionLoad_full_list->setEnabled(!preview_file_path.isEmpty() && !full_load_watcher->isRunning());
 }
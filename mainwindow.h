@@ -3,25 +3,26 @@
 */
 #pragma once
 
+#include <QHeaderView>
 #include <QMainWindow>
 #include <QTableWidget>
 #include <QWidget>
-#include <sstream>
-#include <iomanip>
+#include <atomic>
 
-#include "converter.h"
+#include "list_sort.h"
+#include "memory_budget.h"
+#include "snapshot_playback.h"
+#include "parameter_calculation.h"
+#include "star_dataset.h"
+#include "stargraph_core.h"
 
 using namespace std;
 
-//Version
-extern QString stargraph_version;
-
 //Declare the 'entry_table' variable
 extern QTableWidget* entry_table;
 
-extern vector<vector<QString>> entry_list;
-
-extern int selected_star;
+//Index of the selected star, read by the renderer
+extern atomic<int> selected_star;
 
 extern bool manual_input;
 
@@ -63,6 +64,10 @@ private slots:
 
     void on_actionExport_as_image_triggered();
 
+    void on_actionExport_as_vector_graphics_triggered();
+
+    void on_actionExport_as_high_resolution_image_triggered();
+
     void on_actionSave_list_triggered();
 
     void on_actionNew_list_triggered();
@@ -83,129 +88,191 @@ private slots:
 
     void on_actionAbout_triggered();
 
+    void on_actionJournaled_autosave_toggled(bool arg1);
+
+    void on_actionCompact_storage_toggled(bool arg1);
+
+    void on_actionAdd_layer_triggered();
+
+    void autosave_journal();
+
+    void journal_snapshot_finished();
+
+    void update_layer_menu();
+
+    void on_actionOpen_large_catalog_triggered();
+
+    void on_actionChunk_cache_size_triggered();
+
+    void table_scrolled(int value);
+
+    void on_actionBuild_density_pyramid_triggered();
+
+    void on_actionDelete_selected_stars_triggered();
+
+    void on_actionExport_selected_stars_triggered();
+
+    void on_actionRecolour_selected_stars_triggered();
+
+    void on_actionClear_selection_triggered();
+
+    void update_selection_actions();
+
+    void density_pyramid_finished();
+
+    void on_actionMerge_list_triggered();
+
+    void merge_finished();
+
+    void on_lineEdit_search_textEdited(const QString& text);
+
+    void search_result_activated(const QModelIndex& index);
+
+    void name_index_finished();
+
+    void table_header_clicked(int column);
+
+    void on_actionStatistics_triggered();
+
+    void statistics_finished();
+
+    void on_actionLive_ingestion_toggled(bool checked);
+
+    void live_ingest_tick();
+
+    void on_actionPlay_snapshot_sequence_triggered();
+
+    void on_actionMemory_usage_triggered();
+
+    void on_actionMemory_budget_triggered();
+
+    void on_actionOpen_preview_triggered();
+
+    void on_actionLoad_full_list_triggered();
+
+    void full_load_finished();
+
+    void table_sort_finished();
+
+    void on_actionPreview_size_triggered();
+
+    void on_actionStratified_preview_toggled(bool arg1);
+
+    void conversion_progressed();
+
+    void conversion_finished();
+
 private:
     Ui::MainWindow *ui;
 
+    void finish_journal();
+
+    void load_density_pyramid();
+
+    void remove_selected_stars();
+
+    void update_name_index();
+
+    void update_statistics();
+
+    void show_playback_frame(const PlaybackFrame& frame, bool playing);
+
+    bool choose_load_mode(QString file_name, bool allow_sample, LoadMode* mode, unsigned* sample_size);
+
+    void open_degraded_list(QString file_name, LoadMode mode, unsigned sample_size);
+
+    void end_preview();
+
+    void update_preview_state();
+
+    void open_column_file(QString column_file_name);
+
+    bool confirm_column_file(QString file_name);
+
+    void start_conversion(QString file_name, bool degraded);
+
 public:
-    static void update_table(QTableWidget* table)
+    //Create the table item of a cell, the radius and the mass are estimates which cannot be edited
+    static QTableWidgetItem* create_item(const StarDataset& list, unsigned row, int column)
     {
-        while(table->rowCount() > 0)
+        QTableWidgetItem* item = new QTableWidgetItem(ParameterCalculation::get_column_str(list, row, column));
+        if(column == radius_column || column == mass_column)
         {
-            table->removeRow(table->rowCount() - 1);
-        }
-        for(int i = 0; i < static_cast<int>(entry_list.size()); i ++)
-        {
-            table->insertRow(static_cast<int>(i));
-            for(int j = 0; j < 5; j ++)
-            {
-                table->setItem(i, j, new QTableWidgetItem(entry_list[static_cast<unsigned>(i)][static_cast<unsigned>(j)]));
-            }
+            item->setFlags(item->flags() & ~Qt::ItemIsEditable);
         }
+        return item;
+    }
 
-        entry_table = table;
+    //Memory of the items of the table, counted as their chunks are shown
+    static MemoryCounter& get_table_memory()
+    {
+        static MemoryCounter memory(table_memory);
+        return memory;
     }
 
-};
+    static void start_table_sort();
 
-class ParameterCalculation
-{
-public:
-    static QString get_spectral_class_str(QString temperature_value)
+    //Show the first rows of the current list, the others are added as the table is scrolled
+    static void update_table(QTableWidget* table)
     {
-        //Calculate the spectral class
-        QString str_spectral_class = QString::number(StarFunctions::get_spectral_type(temperature_value.toInt()));
-        switch (str_spectral_class.toStdString()[0])
+        if(!SortFunctions::refresh(DatasetFunctions::current()))
         {
-            case '1':
-                str_spectral_class[0] = 'O';
-                break;
-            case '2':
-                str_spectral_class[0] = 'B';
-                break;
-            case '3':
-                str_spectral_class[0] = 'A';
-                break;
-            case '4':
-                str_spectral_class[0] = 'F';
-                break;
-            case '5':
-                str_spectral_class[0] = 'G';
-                break;
-            case '6':
-                str_spectral_class[0] = 'K';
-                break;
-            case '7':
-                str_spectral_class[0] = 'M';
-                break;
+            start_table_sort();
         }
+        table->horizontalHeader()->setSortIndicatorShown(table_order.column >= 0);
+        table->setRowCount(0);
+        get_table_memory().set(0);
+        load_table_rows(table);
 
-        return str_spectral_class;
+        entry_table = table;
     }
 
-    static QString get_temperature_str(QString spectral_class_value)
+    //Add the next chunk of the current list to the table
+    static void load_table_rows(QTableWidget* table)
     {
-        //Calculate the temperature
-        QString num_spectral_class = spectral_class_value.toUpper();
-        switch (num_spectral_class.toStdString()[0])
-        {
-            case 'O':
-                num_spectral_class[0] = '1';
-                break;
-            case 'B':
-                num_spectral_class[0] = '2';
-                break;
-            case 'A':
-                num_spectral_class[0] = '3';
-                break;
-            case 'F':
-                num_spectral_class[0] = '4';
-                break;
-            case 'G':
-                num_spectral_class[0] = '5';
-                break;
-            case 'K':
-                num_spectral_class[0] = '6';
-                break;
-            case 'M':
-                num_spectral_class[0] = '7';
-                break;
-        }
-
-        return QString::number(StarFunctions::get_temperature(num_spectral_class.toInt()));
+        load_table_chunk(table, static_cast<unsigned>(table->rowCount()) / StarDataset::chunk_size);
     }
 
-    static QString get_absolute_magnitude_str(QString luminosity_value)
+    //Show the rows of the chunk 'c' of the current list, reading only that chunk
+    //The rows of the chunks before it are left empty if they have not been shown yet, and filled when they are scrolled to
+    static void load_table_chunk(QTableWidget* table, unsigned c)
     {
-        //Calculate the absolute magnitude
-        stringstream tempss;
-        tempss << fixed;
-        tempss << setprecision(10);
-        tempss << StarFunctions::get_absolute_magnitude(luminosity_value.toDouble());
-        QString absolute_magnitude_value = QString::fromStdString(tempss.str());
-
-        while(absolute_magnitude_value[absolute_magnitude_value.size() - 1] == '0' && absolute_magnitude_value.size() > 3)
+        DatasetSnapshot list = DatasetFunctions::current();
+        unsigned first = c * StarDataset::chunk_size;
+        if(first >= list->size())
         {
-            absolute_magnitude_value.truncate(absolute_magnitude_value.size() - 1);
+            return;
+        }
+        unsigned last = min(list->size(), first + StarDataset::chunk_size);
+        if(last <= static_cast<unsigned>(table->rowCount()) && table->item(static_cast<int>(first), 0) != nullptr)
+        {
+            return;
         }
-        return absolute_magnitude_value;
-    }
 
-    static QString get_relative_luminosity_str(QString absolute_magnitude_value)
-    {
-        //Calculate the relative luminosity
-        stringstream tempss;
-        tempss << fixed;
-        tempss << setprecision(10);
-        tempss << StarFunctions::get_relative_luminosity(absolute_magnitude_value.toDouble());
-        QString luminosity_value = QString::fromStdString(tempss.str());
-
-        while(luminosity_value[luminosity_value.size() - 1] == '0' && luminosity_value.size() > 3)
+        bool previous_manual_input = manual_input;
+        manual_input = false;
+
+        //Keep the chunk loaded while its rows are read, when the table is sorted the rows may come from any chunk
+        shared_ptr<const StarChunk> chunk = list->get_chunk(c);
+        if(static_cast<unsigned>(table->rowCount()) < last)
         {
-            luminosity_value.truncate(luminosity_value.size() - 1);
+            table->setRowCount(static_cast<int>(last));
         }
+        //Each item also holds its text in a vector of roles and values
+        qint64 bytes = 0;
+        for(unsigned i = first; i < last; i ++)
+        {
+            unsigned row = SortFunctions::get_table_row(i);
+            for(int j = 0; j < column_count; j ++)
+            {
+                QTableWidgetItem* item = create_item(*list, row, j);
+                bytes += static_cast<qint64>(sizeof(QTableWidgetItem) + sizeof(QVariant) * 2) + MemoryFunctions::get_string_size(item->text());
+                table->setItem(static_cast<int>(i), j, item);
+            }
+        }
+        get_table_memory().set(get_table_memory().get() + bytes);
 
-        return luminosity_value;
+        manual_input = previous_manual_input;
     }
 
 };
-
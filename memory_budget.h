@@ -0,0 +1,166 @@
+/*
+    MEMORY BUDGET
+*/
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <vector>
+
+using namespace std;
+
+//Memory the lists can use in megabytes, '0' if there is no limit
+extern int memory_budget;
+
+//Parts of the program whose memory is counted
+enum MemorySubsystem
+{
+    //Chunks of the snapshots and of the layers, with their derived values and the chunks cached from column files
+    dataset_memory,
+    //Items of the table
+    table_memory,
+    //Buffers of the files being read or written, and the rows read before they become a snapshot
+    io_memory,
+    //Vertex buffers and textures of the diagram
+    render_memory,
+    //Name index and sort orders of the current list
+    index_memory,
+    memory_subsystem_count
+};
+
+//Ways a list can be loaded, from the one which needs the most memory to the ones which fit any budget
+enum LoadMode
+{
+    //The rows are read as strings, then made into a snapshot
+    string_load,
+    //The rows are packed a block at a time
+    packed_load,
+    //The list is converted to a column file and read from disk one chunk at a time
+    disk_load,
+    //A random sample of the rows is packed, the others are skipped
+    sample_load
+};
+
+//Class containing the functions used to count the memory of each subsystem
+//The sizes are estimates: containers count their capacity and strings their characters, not what the allocator adds to them
+class MemoryFunctions
+{
+public:
+    static void add(MemorySubsystem subsystem, qint64 bytes)
+    {
+        get_counters()[subsystem] += bytes;
+    }
+
+    static qint64 get_usage(MemorySubsystem subsystem)
+    {
+        return get_counters()[subsystem];
+    }
+
+    static qint64 get_total()
+    {
+        qint64 total = 0;
+        for(int i = 0; i < memory_subsystem_count; i ++)
+        {
+            total += get_usage(static_cast<MemorySubsystem>(i));
+        }
+        return total;
+    }
+
+    //Returns the budget in bytes, '0' if there is no limit
+    static qint64 get_budget()
+    {
+        return static_cast<qint64>(memory_budget) * 1024 * 1024;
+    }
+
+    //Returns the names of the subsystems, in the order of 'MemorySubsystem'
+    static QStringList get_names()
+    {
+        return QStringList() << "Lists" << "Table" << "File buffers" << "Diagram" << "Indexes";
+    }
+
+    static QString get_size_str(qint64 bytes)
+    {
+        if(bytes < 1024 * 1024)
+        {
+            return QString::number(bytes / 1024.0, 'f', 1) + " KB";
+        }
+        if(bytes < 1024LL * 1024 * 1024)
+        {
+            return QString::number(bytes / (1024.0 * 1024), 'f', 1) + " MB";
+        }
+        return QString::number(bytes / (1024.0 * 1024 * 1024), 'f', 2) + " GB";
+    }
+
+    //Returns the memory used by a string; implicitly shared strings are counted by each of their owners
+    static qint64 get_string_size(const QString& text)
+    {
+        return text.isNull() ? 0 : static_cast<qint64>(sizeof(QArrayData)) + (text.capacity() + 1) * static_cast<qint64>(sizeof(QChar));
+    }
+
+    //Returns the memory used by the rows of 'rows' from 'first' on
+    static qint64 get_rows_size(const vector<vector<QString>>& rows, size_t first = 0)
+    {
+        qint64 bytes = 0;
+        for(size_t i = first; i < rows.size(); i ++)
+        {
+            bytes += static_cast<qint64>(sizeof(vector<QString>) + rows[i].capacity() * sizeof(QString));
+            for(unsigned j = 0; j < rows[i].size(); j ++)
+            {
+                bytes += get_string_size(rows[i][j]);
+            }
+        }
+        return bytes;
+    }
+
+private:
+    //The counters are shared by every user of the header, including the tools which do not link the core library
+    static atomic<qint64>* get_counters()
+    {
+        static atomic<qint64> counters[memory_subsystem_count];
+        return counters;
+    }
+};
+
+//Memory counted for one object: setting its size adds the difference to the counter of its subsystem, and destroying it removes it
+//A copy counts the same size again, like the copied object does
+class MemoryCounter
+{
+public:
+    explicit MemoryCounter(MemorySubsystem subsystem_id) : subsystem(subsystem_id), bytes(0)
+    {
+    }
+
+    MemoryCounter(const MemoryCounter& other) : subsystem(other.subsystem), bytes(0)
+    {
+        set(other.bytes);
+    }
+
+    MemoryCounter& operator=(const MemoryCounter& other)
+    {
+        set(0);
+        subsystem = other.subsystem;
+        set(other.bytes);
+        return *this;
+    }
+
+    ~MemoryCounter()
+    {
+        set(0);
+    }
+
+    void set(qint64 new_bytes)
+    {
+        MemoryFunctions::add(subsystem, new_bytes - bytes);
+        bytes = new_bytes;
+    }
+
+    qint64 get() const
+    {
+        return bytes;
+    }
+
+private:
+    MemorySubsystem subsystem;
+    qint64 bytes;
+};
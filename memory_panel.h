@@ -0,0 +1,92 @@
+/*
+    MEMORY PANEL
+*/
+#pragma once
+
+#include <QDialog>
+#include <QGridLayout>
+#include <QLabel>
+#include <QProgressBar>
+#include <QStringList>
+#include <QTimer>
+#include <algorithm>
+#include <vector>
+
+#include "memory_budget.h"
+
+using namespace std;
+
+//Window showing the memory counted for each subsystem against the memory budget, refreshed every second while it is shown
+class MemoryPanel : public QDialog
+{
+public:
+    static const int refresh_interval = 1000;
+
+    explicit MemoryPanel(QWidget* parent = nullptr) : QDialog(parent)
+    {
+        setWindowTitle("Memory usage");
+        QGridLayout* layout = new QGridLayout(this);
+        QStringList names = MemoryFunctions::get_names();
+        for(int i = 0; i <= memory_subsystem_count; i ++)
+        {
+            layout->addWidget(new QLabel(i < memory_subsystem_count ? names[i] + ":" : QString("<b>Total:</b>"), this), i, 0);
+            size_labels.push_back(new QLabel(this));
+            layout->addWidget(size_labels.back(), i, 1);
+            usage_bars.push_back(new QProgressBar(this));
+            usage_bars.back()->setRange(0, 1000);
+            usage_bars.back()->setTextVisible(false);
+            layout->addWidget(usage_bars.back(), i, 2);
+        }
+        budget_label = new QLabel(this);
+        layout->addWidget(budget_label, memory_subsystem_count + 1, 0, 1, 3);
+        layout->setColumnMinimumWidth(2, 200);
+
+        refresh_timer = new QTimer(this);
+        connect(refresh_timer, &QTimer::timeout, this, [this]()
+        {
+            refresh();
+        });
+    }
+
+    void refresh()
+    {
+        qint64 total = MemoryFunctions::get_total();
+        qint64 budget = MemoryFunctions::get_budget();
+        //Without a budget the bars show the share of the total
+        qint64 scale = max<qint64>(1, budget > 0 ? max(budget, total) : total);
+        for(int i = 0; i <= memory_subsystem_count; i ++)
+        {
+            qint64 bytes = i < memory_subsystem_count ? MemoryFunctions::get_usage(static_cast<MemorySubsystem>(i)) : total;
+            size_labels[i]->setText(MemoryFunctions::get_size_str(bytes));
+            usage_bars[i]->setValue(static_cast<int>(max<qint64>(0, bytes) * 1000 / scale));
+        }
+
+        if(budget == 0)
+        {
+            budget_label->setText("No memory budget");
+        }
+        else
+        {
+            budget_label->setText("Memory budget: " + MemoryFunctions::get_size_str(budget) + (total > budget ? ", exceeded" : ", " + MemoryFunctions::get_size_str(budget - total) + " free"));
+        }
+    }
+
+protected:
+    void showEvent(QShowEvent*)
+    {
+        refresh();
+        refresh_timer->start(refresh_interval);
+    }
+
+    void hideEvent(QHideEvent*)
+    {
+        refresh_timer->stop();
+    }
+
+private:
+    //One label and one bar for each subsystem, then the total
+    vector<QLabel*> size_labels;
+    vector<QProgressBar*> usage_bars;
+    QLabel* budget_label;
+    QTimer* refresh_timer;
+};
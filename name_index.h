@@ -0,0 +1,330 @@
+/*
+    NAME INDEX
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include "memory_budget.h"
+#include "star_dataset.h"
+
+using namespace std;
+
+//Class indexing the star names of a snapshot for searching them as they are typed
+//The names are kept in lower case one after the other in a single array, with:
+//    a sorted index of the rows, where the names starting with a prefix form a single range found by binary search
+//    an index of the trigrams of each name, hashed into buckets, where a substring is looked up in the intersection of the buckets of its trigrams
+//The names appended to the list since the index was built, by the live ingestion for example, are added on the GUI thread to a sorted map and to buckets of their own
+class NameIndex
+{
+public:
+    //Number of trigram buckets, trigrams sharing a bucket are told apart when the candidates are checked
+    static const unsigned trigram_buckets = 1 << 20;
+
+    NameIndex() : dataset_version(0), append_origin(0), base_count(0), base_bytes(0), appended_bytes(0), memory(index_memory)
+    {
+    }
+
+    //Index the names of 'dataset' chunk by chunk; this takes a few seconds for millions of names, so it runs in the background
+    static shared_ptr<NameIndex> build(DatasetSnapshot dataset)
+    {
+        shared_ptr<NameIndex> index = make_shared<NameIndex>();
+        index->dataset_version = dataset->get_version();
+        index->append_origin = dataset->get_append_origin();
+        index->offsets.reserve(dataset->size() + 1);
+        index->offsets.push_back(0);
+        for(unsigned c = 0; c < dataset->get_chunk_count(); c ++)
+        {
+            shared_ptr<const StarChunk> chunk = dataset->get_chunk(c);
+            for(unsigned i = 0; i < chunk->size(); i ++)
+            {
+                QByteArray name = chunk->get_name(i).toLower().toUtf8();
+                index->names.insert(index->names.end(), name.constData(), name.constData() + name.size());
+                index->offsets.push_back(index->names.size());
+            }
+        }
+        unsigned count = dataset->size();
+        index->base_count = count;
+
+        //Sort the rows by name, the rows with the same name stay in their order
+        index->sorted_rows.resize(count);
+        for(unsigned i = 0; i < count; i ++)
+        {
+            index->sorted_rows[i] = i;
+        }
+        const NameIndex& sorted_index = *index;
+        stable_sort(index->sorted_rows.begin(), index->sorted_rows.end(), [&sorted_index](unsigned first, unsigned second)
+        {
+            return sorted_index.compare_names(first, second) < 0;
+        });
+
+        //Count the trigrams of each bucket, then fill the buckets; a name is only added once to each bucket
+        vector<unsigned> last_rows(trigram_buckets, 0xffffffff);
+        index->bucket_starts.assign(trigram_buckets + 1, 0);
+        for(unsigned row = 0; row < count; row ++)
+        {
+            const char* name = index->get_name_data(row);
+            for(int i = 0; i + 3 <= index->get_name_size(row); i ++)
+            {
+                unsigned bucket = get_bucket(name + i);
+                if(last_rows[bucket] != row)
+                {
+                    last_rows[bucket] = row;
+                    index->bucket_starts[bucket + 1] ++;
+                }
+            }
+        }
+        for(unsigned b = 0; b < trigram_buckets; b ++)
+        {
+            index->bucket_starts[b + 1] += index->bucket_starts[b];
+        }
+
+        vector<quint64> positions(index->bucket_starts.begin(), index->bucket_starts.end() - 1);
+        index->bucket_rows.resize(index->bucket_starts.back());
+        last_rows.assign(trigram_buckets, 0xffffffff);
+        for(unsigned row = 0; row < count; row ++)
+        {
+            const char* name = index->get_name_data(row);
+            for(int i = 0; i + 3 <= index->get_name_size(row); i ++)
+            {
+                unsigned bucket = get_bucket(name + i);
+                if(last_rows[bucket] != row)
+                {
+                    last_rows[bucket] = row;
+                    index->bucket_rows[positions[bucket] ++] = row;
+                }
+            }
+        }
+        index->base_bytes = static_cast<qint64>(index->names.capacity() + index->offsets.capacity() * sizeof(size_t) + index->sorted_rows.capacity() * sizeof(unsigned) + index->bucket_starts.capacity() * sizeof(quint64) + index->bucket_rows.capacity() * sizeof(unsigned));
+        index->memory.set(index->base_bytes);
+        return index;
+    }
+
+    //Snapshot the index was built from
+    unsigned get_dataset_version() const
+    {
+        return dataset_version;
+    }
+
+    //Add the names of the stars appended to the snapshot of the index to make 'dataset', without building the index again
+    //Returns false if 'dataset' was made in another way, or if the appended names outnumber the indexed ones: the index should then be built again in the background
+    bool append(const DatasetSnapshot& dataset)
+    {
+        unsigned count = static_cast<unsigned>(offsets.size()) - 1;
+        unsigned max_appended = max(base_count, static_cast<unsigned>(min_rebuild_rows));
+        if(append_origin != dataset->get_append_origin() || count > dataset->size() || dataset->size() - base_count > max_appended)
+        {
+            return false;
+        }
+        for(unsigned row = count; row < dataset->size(); row ++)
+        {
+            QByteArray name = dataset->get_name(row).toLower().toUtf8();
+            names.insert(names.end(), name.constData(), name.constData() + name.size());
+            offsets.push_back(names.size());
+            appended_names.insert(make_pair(name, row));
+            appended_bytes += static_cast<qint64>(name.size() + sizeof(unsigned)) * 2;
+
+            const char* data = name.constData();
+            for(int i = 0; i + 3 <= name.size(); i ++)
+            {
+                vector<unsigned>& bucket = appended_buckets[get_bucket(data + i)];
+                if(bucket.empty() || bucket.back() != row)
+                {
+                    bucket.push_back(row);
+                    appended_bytes += sizeof(unsigned);
+                }
+            }
+        }
+        dataset_version = dataset->get_version();
+        memory.set(base_bytes + appended_bytes);
+        return true;
+    }
+
+    //Returns at most 'max_results' rows whose name contains 'text', ignoring case
+    //The names starting with 'text' come first in alphabetical order, then the ones containing it elsewhere in the order of the list
+    vector<unsigned> search(QString text, unsigned max_results) const
+    {
+        vector<unsigned> results;
+        QByteArray query = text.toLower().toUtf8();
+        if(query.isEmpty())
+        {
+            return results;
+        }
+
+        //Find the range of names starting with the query, among the indexed names and the appended ones, merged in alphabetical order
+        vector<unsigned>::const_iterator first = lower_bound(sorted_rows.begin(), sorted_rows.end(), query, [this](unsigned row, const QByteArray& prefix)
+        {
+            return compare_prefix(row, prefix) < 0;
+        });
+        multimap<QByteArray, unsigned>::const_iterator appended = appended_names.lower_bound(query);
+        while(results.size() < max_results)
+        {
+            bool indexed_match = first != sorted_rows.end() && compare_prefix(*first, query) == 0;
+            bool appended_match = appended != appended_names.end() && appended->first.startsWith(query);
+            if(!indexed_match && !appended_match)
+            {
+                break;
+            }
+            if(indexed_match && (!appended_match || compare_names(*first, appended->second) <= 0))
+            {
+                results.push_back(*first);
+                ++ first;
+            }
+            else
+            {
+                results.push_back(appended->second);
+                ++ appended;
+            }
+        }
+
+        //Look the other names up in the intersection of the buckets of every trigram of the query, walking the smallest bucket and skipping ahead in the others
+        //The rows of each bucket are in increasing order, the appended rows after the indexed ones, so each bucket is searched from where the previous row was found
+        if(query.size() < 3 || results.size() >= max_results)
+        {
+            return results;
+        }
+        vector<unsigned> buckets;
+        for(int i = 0; i + 3 <= query.size(); i ++)
+        {
+            buckets.push_back(get_bucket(query.constData() + i));
+        }
+        sort(buckets.begin(), buckets.end());
+        buckets.erase(unique(buckets.begin(), buckets.end()), buckets.end());
+        sort(buckets.begin(), buckets.end(), [this](unsigned first_bucket, unsigned second_bucket)
+        {
+            return get_bucket_size(first_bucket) < get_bucket_size(second_bucket);
+        });
+        vector<BucketCursor> cursors;
+        for(unsigned b = 0; b < buckets.size(); b ++)
+        {
+            cursors.push_back(get_cursor(buckets[b]));
+        }
+
+        BucketCursor& smallest = cursors[0];
+        while(results.size() < max_results && (smallest.indexed != smallest.indexed_end || smallest.appended != smallest.appended_end))
+        {
+            unsigned row = smallest.indexed != smallest.indexed_end ? *(smallest.indexed ++) : *(smallest.appended ++);
+            bool in_every_bucket = true;
+            for(unsigned b = 1; b < cursors.size() && in_every_bucket; b ++)
+            {
+                in_every_bucket = cursors[b].skip_to(row, base_count);
+            }
+            if(!in_every_bucket)
+            {
+                continue;
+            }
+
+            const char* name = get_name_data(row);
+            int size = get_name_size(row);
+            //The names starting with the query have already been found
+            if(size >= query.size() && memcmp(name, query.constData(), static_cast<size_t>(query.size())) == 0)
+            {
+                continue;
+            }
+            if(std::search(name + 1, name + size, query.constData(), query.constData() + query.size()) != name + size)
+            {
+                results.push_back(row);
+            }
+        }
+        return results;
+    }
+
+private:
+    //Below this many rows an index is not built again just because more names were appended than indexed
+    static const unsigned min_rebuild_rows = 1 << 16;
+
+    //Position reached in the rows of a bucket, first the indexed ones then the appended ones, which only moves forward
+    struct BucketCursor
+    {
+        vector<unsigned>::const_iterator indexed;
+        vector<unsigned>::const_iterator indexed_end;
+        vector<unsigned>::const_iterator appended;
+        vector<unsigned>::const_iterator appended_end;
+
+        //Move to 'row' or past it, returns true if the bucket has it; the rows from 'base_count' on are the appended ones
+        bool skip_to(unsigned row, unsigned base_count)
+        {
+            if(row < base_count)
+            {
+                indexed = lower_bound(indexed, indexed_end, row);
+                return indexed != indexed_end && *indexed == row;
+            }
+            appended = lower_bound(appended, appended_end, row);
+            return appended != appended_end && *appended == row;
+        }
+    };
+
+    BucketCursor get_cursor(unsigned bucket) const
+    {
+        static const vector<unsigned> no_rows;
+        QHash<unsigned, vector<unsigned>>::const_iterator appended = appended_buckets.constFind(bucket);
+        const vector<unsigned>& appended_rows = appended == appended_buckets.constEnd() ? no_rows : appended.value();
+        BucketCursor cursor = { bucket_rows.begin() + static_cast<ptrdiff_t>(bucket_starts[bucket]), bucket_rows.begin() + static_cast<ptrdiff_t>(bucket_starts[bucket + 1]), appended_rows.begin(), appended_rows.end() };
+        return cursor;
+    }
+
+    quint64 get_bucket_size(unsigned bucket) const
+    {
+        QHash<unsigned, vector<unsigned>>::const_iterator appended = appended_buckets.constFind(bucket);
+        return bucket_starts[bucket + 1] - bucket_starts[bucket] + (appended == appended_buckets.constEnd() ? 0 : appended.value().size());
+    }
+
+    //Hash of the three bytes at 'data'
+    static unsigned get_bucket(const char* data)
+    {
+        quint32 trigram = static_cast<quint32>(static_cast<uchar>(data[0])) | static_cast<quint32>(static_cast<uchar>(data[1])) << 8 | static_cast<quint32>(static_cast<uchar>(data[2])) << 16;
+        return (trigram * 2654435761u) >> 12;
+    }
+
+    const char* get_name_data(unsigned row) const
+    {
+        return names.data() + offsets[row];
+    }
+
+    int get_name_size(unsigned row) const
+    {
+        return static_cast<int>(offsets[row + 1] - offsets[row]);
+    }
+
+    int compare_names(unsigned first, unsigned second) const
+    {
+        int first_size = get_name_size(first);
+        int second_size = get_name_size(second);
+        int result = memcmp(get_name_data(first), get_name_data(second), static_cast<size_t>(min(first_size, second_size)));
+        return result != 0 ? result : first_size - second_size;
+    }
+
+    //Compares the start of the name of 'row' with 'prefix', '0' if the name starts with it
+    int compare_prefix(unsigned row, const QByteArray& prefix) const
+    {
+        int size = get_name_size(row);
+        int result = memcmp(get_name_data(row), prefix.constData(), static_cast<size_t>(min(size, prefix.size())));
+        return result != 0 ? result : (size < prefix.size() ? -1 : 0);
+    }
+
+    unsigned dataset_version;
+    unsigned append_origin;
+
+    vector<char> names;
+    vector<size_t> offsets;
+    vector<unsigned> sorted_rows;
+
+    //Rows of each trigram bucket, from 'bucket_starts[b]' to 'bucket_starts[b + 1]'
+    vector<quint64> bucket_starts;
+    vector<unsigned> bucket_rows;
+
+    //Rows indexed by 'build()', the ones after them have been appended: their names by name, and their rows by trigram bucket
+    unsigned base_count;
+    multimap<QByteArray, unsigned> appended_names;
+    QHash<unsigned, vector<unsigned>> appended_buckets;
+
+    qint64 base_bytes;
+    qint64 appended_bytes;
+    MemoryCounter memory;
+};
@@ -0,0 +1,143 @@
+/*
+    PARAMETER CALCULATION
+*/
+#pragma once
+
+#include <QString>
+#include <sstream>
+#include <iomanip>
+
+#include "converter.h"
+#include "star_dataset.h"
+
+using namespace std;
+
+class ParameterCalculation
+{
+public:
+    static QString get_spectral_class_str(QString temperature_value)
+    {
+        return get_spectral_class_name(StarFunctions::get_spectral_type(temperature_value.toInt()));
+    }
+
+    //Returns the name of a spectral class from its numeric form: for example 'get_spectral_class_name(52)' will return 'G2'
+    static QString get_spectral_class_name(int spectral_type)
+    {
+        //Calculate the spectral class
+        QString str_spectral_class = QString::number(spectral_type);
+        switch (str_spectral_class.toStdString()[0])
+        {
+            case '1':
+                str_spectral_class[0] = 'O';
+                break;
+            case '2':
+                str_spectral_class[0] = 'B';
+                break;
+            case '3':
+                str_spectral_class[0] = 'A';
+                break;
+            case '4':
+                str_spectral_class[0] = 'F';
+                break;
+            case '5':
+                str_spectral_class[0] = 'G';
+                break;
+            case '6':
+                str_spectral_class[0] = 'K';
+                break;
+            case '7':
+                str_spectral_class[0] = 'M';
+                break;
+        }
+
+        return str_spectral_class;
+    }
+
+    static QString get_temperature_str(QString spectral_class_value)
+    {
+        //Calculate the temperature
+        QString num_spectral_class = spectral_class_value.toUpper();
+        switch (num_spectral_class.toStdString()[0])
+        {
+            case 'O':
+                num_spectral_class[0] = '1';
+                break;
+            case 'B':
+                num_spectral_class[0] = '2';
+                break;
+            case 'A':
+                num_spectral_class[0] = '3';
+                break;
+            case 'F':
+                num_spectral_class[0] = '4';
+                break;
+            case 'G':
+                num_spectral_class[0] = '5';
+                break;
+            case 'K':
+                num_spectral_class[0] = '6';
+                break;
+            case 'M':
+                num_spectral_class[0] = '7';
+                break;
+        }
+
+        return QString::number(StarFunctions::get_temperature(num_spectral_class.toInt()));
+    }
+
+    static QString get_absolute_magnitude_str(QString luminosity_value)
+    {
+        //Calculate the absolute magnitude
+        return format_value(StarFunctions::get_absolute_magnitude(luminosity_value.toDouble()));
+    }
+
+    //Returns 'value' with ten decimal places at most, without trailing zeros
+    static QString format_value(double value)
+    {
+        stringstream tempss;
+        tempss << fixed;
+        tempss << setprecision(10);
+        tempss << value;
+        QString formatted_value = QString::fromStdString(tempss.str());
+
+        while(formatted_value[formatted_value.size() - 1] == '0' && formatted_value.size() > 3)
+        {
+            formatted_value.truncate(formatted_value.size() - 1);
+        }
+        return formatted_value;
+    }
+
+    //Returns the text shown in the column 'column' of the star at index 'row', calculating the derived columns only now
+    static QString get_column_str(const StarDataset& list, unsigned row, int column)
+    {
+        if(column < stored_column_count)
+        {
+            return list[row][static_cast<unsigned>(column)];
+        }
+
+        double value = list.get_derived(static_cast<DerivedColumn>(column), row);
+        if(column == spectral_class_column)
+        {
+            return get_spectral_class_name(static_cast<int>(value));
+        }
+        return format_value(value);
+    }
+
+    static QString get_relative_luminosity_str(QString absolute_magnitude_value)
+    {
+        //Calculate the relative luminosity
+        stringstream tempss;
+        tempss << fixed;
+        tempss << setprecision(10);
+        tempss << StarFunctions::get_relative_luminosity(absolute_magnitude_value.toDouble());
+        QString luminosity_value = QString::fromStdString(tempss.str());
+
+        while(luminosity_value[luminosity_value.size() - 1] == '0' && luminosity_value.size() > 3)
+        {
+            luminosity_value.truncate(luminosity_value.size() - 1);
+        }
+
+        return luminosity_value;
+    }
+
+};
@@ -0,0 +1,168 @@
+/*
+    PLAYBACK PANEL
+*/
+#pragma once
+
+#include <QCheckBox>
+#include <QDialog>
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QSlider>
+#include <QSpinBox>
+#include <QTimer>
+#include <QVBoxLayout>
+#include <functional>
+
+#include "snapshot_playback.h"
+
+using namespace std;
+
+//Window playing a sequence of snapshot lists: play and pause, a slider to scrub through the frames, the frame rate and looping
+//Each frame is handed to 'show_frame' with 'playing' false once the playback stops on it, so the views which are too slow to follow every frame can be updated then
+class PlaybackPanel : public QDialog
+{
+public:
+    explicit PlaybackPanel(QWidget* parent = nullptr) : QDialog(parent)
+    {
+        setWindowTitle("Snapshot playback");
+        play_button = new QPushButton("Play", this);
+        frame_slider = new QSlider(Qt::Horizontal, this);
+        frame_label = new QLabel(this);
+        rate_box = new QSpinBox(this);
+        rate_box->setRange(1, 60);
+        rate_box->setValue(10);
+        rate_box->setSuffix(" frames/s");
+        loop_box = new QCheckBox("Loop", this);
+
+        QHBoxLayout* controls = new QHBoxLayout();
+        controls->addWidget(play_button);
+        controls->addWidget(rate_box);
+        controls->addWidget(loop_box);
+        QVBoxLayout* layout = new QVBoxLayout(this);
+        layout->addWidget(frame_slider);
+        layout->addWidget(frame_label);
+        layout->addLayout(controls);
+
+        frame_timer = new QTimer(this);
+        connect(frame_timer, &QTimer::timeout, this, [this]()
+        {
+            tick();
+        });
+        connect(play_button, &QPushButton::clicked, this, [this]()
+        {
+            set_playing(!frame_timer->isActive());
+        });
+        connect(rate_box, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, [this](int rate)
+        {
+            frame_timer->setInterval(1000 / rate);
+        });
+        connect(loop_box, &QCheckBox::toggled, this, [this](bool checked)
+        {
+            player.set_loop(checked);
+        });
+        //Scrubbing pauses the playback and shows the frame under the slider as soon as it is decoded
+        connect(frame_slider, &QSlider::valueChanged, this, [this](int value)
+        {
+            if(value != shown_index)
+            {
+                set_playing(false);
+                wanted_index = value;
+                frame_timer->start();
+            }
+        });
+    }
+
+    //Play 'file_names' from the first frame, 'show_frame' is called with each frame shown
+    void start(QStringList file_names, function<void(const PlaybackFrame&, bool)> show)
+    {
+        show_frame = show;
+        player.set_files(file_names, loop_box->isChecked());
+        shown_index = -1;
+        wanted_index = 0;
+        frame_slider->blockSignals(true);
+        frame_slider->setRange(0, max(0, file_names.size() - 1));
+        frame_slider->setValue(0);
+        frame_slider->blockSignals(false);
+        player.prefetch(0);
+        show();
+        raise();
+        set_playing(true);
+    }
+
+protected:
+    void hideEvent(QHideEvent* event)
+    {
+        set_playing(false);
+        QDialog::hideEvent(event);
+    }
+
+private:
+    void set_playing(bool play)
+    {
+        playing = play;
+        play_button->setText(play ? "Pause" : "Play");
+        if(play)
+        {
+            //Playing again goes on from the frame after the one shown, or starts over at the end
+            if(shown_index >= 0)
+            {
+                wanted_index = max(0, player.get_next_index(shown_index));
+            }
+            frame_timer->start(1000 / rate_box->value());
+        }
+    }
+
+    //Show the wanted frame if it has been decoded; while playing, the next one is wanted after it, and a frame which is late is waited for instead of skipped
+    void tick()
+    {
+        if(wanted_index < 0 || player.get_frame_count() == 0)
+        {
+            set_playing(false);
+            frame_timer->stop();
+            return;
+        }
+
+        PlaybackFrame frame;
+        if(!player.take_frame(wanted_index, frame))
+        {
+            frame_label->setText("Decoding " + QFileInfo(player.get_file_name(wanted_index)).fileName() + "...");
+            return;
+        }
+
+        shown_index = frame.index;
+        frame_slider->blockSignals(true);
+        frame_slider->setValue(shown_index);
+        frame_slider->blockSignals(false);
+        frame_label->setText(QString::number(shown_index + 1) + " / " + QString::number(player.get_frame_count()) + ": " + QFileInfo(player.get_file_name(shown_index)).fileName() + (frame.supported ? "" : " (not supported)"));
+
+        if(playing)
+        {
+            wanted_index = player.get_next_index(shown_index);
+            if(wanted_index < 0)
+            {
+                set_playing(false);
+            }
+        }
+        if(!playing)
+        {
+            frame_timer->stop();
+            player.prefetch(max(0, player.get_next_index(shown_index)));
+        }
+        show_frame(frame, playing);
+    }
+
+    SnapshotPlayer player;
+    function<void(const PlaybackFrame&, bool)> show_frame;
+    int shown_index = -1;
+    int wanted_index = -1;
+    bool playing = false;
+
+    QPushButton* play_button;
+    QSlider* frame_slider;
+    QLabel* frame_label;
+    QSpinBox* rate_box;
+    QCheckBox* loop_box;
+    QTimer* frame_timer;
+};
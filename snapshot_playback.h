@@ -0,0 +1,228 @@
+/*
+    SNAPSHOT PLAYBACK
+*/
+#pragma once
+
+#include <QCollator>
+#include <QDir>
+#include <QFileInfo>
+#include <QFuture>
+#include <QStringList>
+#include <QtConcurrent>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "catalog_layers.h"
+#include "diagram_projection.h"
+#include "file_manager.h"
+#include "star_dataset.h"
+
+using namespace std;
+
+//A snapshot of a sequence, decoded along with its vertices in the projection current when it was decoded
+struct PlaybackFrame
+{
+    int index;
+    bool supported;
+    DatasetSnapshot dataset;
+    DiagramProjection projection;
+    shared_ptr<const vector<float>> vertices;
+    int faint_count;
+};
+
+//Class playing a sequence of lists, one per time step of a simulation, as the frames of an animation
+//The frames after the one shown are decoded on the thread pool, at most 'prefetch_count' ahead, so showing a frame only uploads vertices which are already built
+//A frame which is not wanted anymore is cancelled and stops before its next step; at most 'prefetch_count' decodes run at once, cancelled ones included, so scrubbing does not pile discarded decodes up ahead of the wanted frame
+class SnapshotPlayer
+{
+public:
+    //Frames decoded ahead of the one shown
+    static const int prefetch_count = 8;
+
+    ~SnapshotPlayer()
+    {
+        cancel_all();
+    }
+
+    //Returns the lists and csv tables of 'directory', sorted so that "step_9" comes before "step_10"
+    static QStringList get_sequence_files(QString directory)
+    {
+        QStringList names = QDir(directory).entryList(QStringList() << "*.sgl" << "*.csv", QDir::Files);
+        QCollator collator;
+        collator.setNumericMode(true);
+        sort(names.begin(), names.end(), [&collator](const QString& first, const QString& second)
+        {
+            return collator.compare(first, second) < 0;
+        });
+
+        QStringList files;
+        for(int i = 0; i < names.size(); i ++)
+        {
+            files << QDir(directory).filePath(names[i]);
+        }
+        return files;
+    }
+
+    void set_files(QStringList file_names, bool loop_frames)
+    {
+        cancel_all();
+        files = file_names;
+        loop = loop_frames;
+    }
+
+    void set_loop(bool loop_frames)
+    {
+        loop = loop_frames;
+    }
+
+    int get_frame_count() const
+    {
+        return files.size();
+    }
+
+    QString get_file_name(int index) const
+    {
+        return files[index];
+    }
+
+    //Returns the frame shown after 'index', '-1' at the end of a sequence which is not looped
+    int get_next_index(int index) const
+    {
+        if(index + 1 < files.size())
+        {
+            return index + 1;
+        }
+        return loop && !files.isEmpty() ? 0 : -1;
+    }
+
+    //Decode the frames from 'index' onwards, the decoded frames outside of the new window are dropped, so scrubbing keeps the memory bounded
+    //The frame 'index' is always started, the others only while fewer than 'prefetch_count' decodes are running
+    void prefetch(int index)
+    {
+        vector<int> window;
+        for(int i = index, n = 0; i >= 0 && n < prefetch_count; i = get_next_index(i), n ++)
+        {
+            if(find(window.begin(), window.end(), i) != window.end())
+            {
+                break;
+            }
+            window.push_back(i);
+        }
+
+        for(map<int, FrameJob>::iterator it = queue.begin(); it != queue.end();)
+        {
+            if(find(window.begin(), window.end(), it->first) == window.end())
+            {
+                cancel(it->second);
+                it = queue.erase(it);
+            }
+            else
+            {
+                ++ it;
+            }
+        }
+        cancelled_jobs.erase(remove_if(cancelled_jobs.begin(), cancelled_jobs.end(), [](const QFuture<PlaybackFrame>& future)
+        {
+            return future.isFinished();
+        }), cancelled_jobs.end());
+
+        int running = static_cast<int>(cancelled_jobs.size());
+        for(map<int, FrameJob>::iterator it = queue.begin(); it != queue.end(); ++ it)
+        {
+            running += it->second.future.isFinished() ? 0 : 1;
+        }
+        for(unsigned i = 0; i < window.size(); i ++)
+        {
+            if(queue.find(window[i]) == queue.end() && (i == 0 || running < prefetch_count))
+            {
+                FrameJob job;
+                job.cancelled = make_shared<atomic<bool>>(false);
+                job.future = QtConcurrent::run(load_frame, files[window[i]], window[i], ProjectionFunctions::get_view(), job.cancelled);
+                queue[window[i]] = job;
+                running ++;
+            }
+        }
+    }
+
+    //Move the frame 'index' to 'frame' if it has been decoded, returns false if it is not ready yet
+    bool take_frame(int index, PlaybackFrame& frame)
+    {
+        prefetch(index);
+        QFuture<PlaybackFrame>& future = queue[index].future;
+        if(!future.isFinished())
+        {
+            return false;
+        }
+        frame = future.result();
+        queue.erase(index);
+
+        //Vertices built in a projection which has been changed since are built again when the frame is drawn
+        if(frame.projection != diagram_projection)
+        {
+            frame.vertices.reset();
+        }
+        return true;
+    }
+
+private:
+    //A frame being decoded, with the flag asking it to stop
+    struct FrameJob
+    {
+        QFuture<PlaybackFrame> future;
+        shared_ptr<atomic<bool>> cancelled;
+    };
+
+    //Decode the list 'file_name' and build its vertices in 'view', on a thread of the pool
+    //A cancelled frame stops before reading the file and before building its vertices, and is returned without them
+    static PlaybackFrame load_frame(QString file_name, int index, DiagramView view, shared_ptr<atomic<bool>> cancelled)
+    {
+        PlaybackFrame frame;
+        frame.index = index;
+        frame.supported = false;
+        frame.projection = view.projection;
+        frame.faint_count = 0;
+        if(*cancelled)
+        {
+            return frame;
+        }
+        frame.dataset = StarDataset::from_rows(FileIOFunctions::load_any(file_name, &frame.supported));
+        if(*cancelled)
+        {
+            return frame;
+        }
+
+        shared_ptr<vector<float>> vertices = make_shared<vector<float>>();
+        frame.faint_count = LayerFunctions::build_vertices(view, *frame.dataset, *vertices);
+        frame.vertices = vertices;
+        return frame;
+    }
+
+    //Ask a frame to stop, it is counted among the running decodes until it has
+    void cancel(FrameJob& job)
+    {
+        *job.cancelled = true;
+        if(!job.future.isFinished())
+        {
+            cancelled_jobs.push_back(job.future);
+        }
+    }
+
+    void cancel_all()
+    {
+        for(map<int, FrameJob>::iterator it = queue.begin(); it != queue.end(); ++ it)
+        {
+            cancel(it->second);
+        }
+        queue.clear();
+    }
+
+    QStringList files;
+    bool loop = false;
+    //Frames being decoded or decoded, by index
+    map<int, FrameJob> queue;
+    //Frames cancelled while they were being decoded
+    vector<QFuture<PlaybackFrame>> cancelled_jobs;
+};
@@ -0,0 +1,703 @@
+/*
+    STAR DATASET
+*/
+#pragma once
+
+#include <QString>
+#include <QtConcurrent>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "compact_storage.h"
+#include "converter.h"
+#include "memory_budget.h"
+
+using namespace std;
+
+class StarDataset;
+
+//Reference-counted, immutable version of the star list: readers on any thread keep it alive for as long as they use it
+typedef shared_ptr<const StarDataset> DatasetSnapshot;
+
+//Snapshot currently shown by the user interface, only replaced through 'DatasetFunctions::publish()'
+extern DatasetSnapshot current_dataset;
+
+//Columns calculated from the temperature and the luminosity, numbered after the three stored ones
+enum DerivedColumn
+{
+    spectral_class_column = 3,
+    absolute_magnitude_column = 4,
+    radius_column = 5,
+    mass_column = 6
+};
+
+//Number of stored and derived columns
+static const int stored_column_count = 3;
+static const int column_count = 7;
+
+//Rows of a part of the star list, either as strings or, in compact storage mode, as packed columns
+struct StarChunk
+{
+    StarChunk() : packed(false), memory(dataset_memory)
+    {
+        clear_derived();
+    }
+
+    template<class Iterator> StarChunk(Iterator first, Iterator last, bool packed_form) : packed(packed_form), memory(dataset_memory)
+    {
+        clear_derived();
+        if(packed)
+        {
+            columns = PackingFunctions::pack(first, last);
+        }
+        else
+        {
+            rows.assign(first, last);
+        }
+        count_memory();
+    }
+
+    //The copy keeps its own copy of the derived values published so far
+    StarChunk(const StarChunk& other) : rows(other.rows), packed(other.packed), columns(other.columns), memory(other.memory)
+    {
+        for(int c = 0; c < column_count - stored_column_count; c ++)
+        {
+            const vector<double>* values = other.derived[c].load(memory_order_acquire);
+            derived[c].store(nullptr, memory_order_relaxed);
+            if(values != nullptr)
+            {
+                publish_derived(c, new vector<double>(*values));
+            }
+        }
+    }
+
+    StarChunk& operator=(const StarChunk&) = delete;
+
+    ~StarChunk()
+    {
+        for(int c = 0; c < column_count - stored_column_count; c ++)
+        {
+            set_derived(c, nullptr);
+        }
+    }
+
+    //Returns the values of a derived column for the whole chunk, or null if they were not calculated yet
+    const vector<double>* get_derived(int index) const
+    {
+        return derived[index].load(memory_order_acquire);
+    }
+
+    //Publish the values of a derived column calculated by the caller, unless another thread did it first
+    //Returns the values published, which are never changed afterwards, so they are read without any lock
+    const vector<double>* publish_derived(int index, vector<double>* values) const
+    {
+        const vector<double>* expected = nullptr;
+        if(!derived[index].compare_exchange_strong(expected, values, memory_order_acq_rel, memory_order_acquire))
+        {
+            delete values;
+            return expected;
+        }
+        MemoryFunctions::add(dataset_memory, static_cast<qint64>(values->capacity() * sizeof(double)));
+        return values;
+    }
+
+    //Replace the values of a derived column, only while the chunk is still being built and not shared with other threads
+    void set_derived(int index, vector<double>* values)
+    {
+        const vector<double>* old_values = derived[index].exchange(values, memory_order_acq_rel);
+        if(old_values != nullptr)
+        {
+            MemoryFunctions::add(dataset_memory, -static_cast<qint64>(old_values->capacity() * sizeof(double)));
+            delete old_values;
+        }
+        if(values != nullptr)
+        {
+            MemoryFunctions::add(dataset_memory, static_cast<qint64>(values->capacity() * sizeof(double)));
+        }
+    }
+
+    unsigned size() const
+    {
+        return static_cast<unsigned>(packed ? columns.temperatures.size() : rows.size());
+    }
+
+    //Returns the stored values of the row 'i': name, temperature and luminosity
+    vector<QString> get_row(unsigned i) const
+    {
+        return packed ? PackingFunctions::get_row(columns, i) : rows[i];
+    }
+
+    //Returns a copy of the rows, unpacking them if needed
+    vector<vector<QString>> get_rows() const
+    {
+        if(!packed)
+        {
+            return rows;
+        }
+        vector<vector<QString>> unpacked_rows;
+        for(unsigned i = 0; i < size(); i ++)
+        {
+            unpacked_rows.push_back(PackingFunctions::get_row(columns, i));
+        }
+        return unpacked_rows;
+    }
+
+    QString get_name(unsigned i) const
+    {
+        return packed ? PackingFunctions::get_name(columns, i) : rows[i][0];
+    }
+
+    //The numeric values are read directly from the packed columns, without converting them to strings
+    double get_temperature(unsigned i) const
+    {
+        return packed ? columns.temperatures[i] : rows[i][1].toDouble();
+    }
+
+    double get_luminosity(unsigned i) const
+    {
+        return packed ? PackingFunctions::unpack_luminosity(columns.log_luminosities[i]) : rows[i][2].toDouble();
+    }
+
+    //Returns the log10 of the luminosity, minus infinity if the luminosity is not positive
+    double get_log_luminosity(unsigned i) const
+    {
+        if(packed)
+        {
+            return PackingFunctions::unpack_log_luminosity(columns.log_luminosities[i]);
+        }
+        double luminosity = rows[i][2].toDouble();
+        return luminosity > 0 ? MathFunctions::log_base_10(luminosity) : -numeric_limits<double>::infinity();
+    }
+
+    //Count the memory of the chunk again once its rows have changed, the derived values are counted when they are published
+    void count_memory() const
+    {
+        qint64 bytes = sizeof(StarChunk) + MemoryFunctions::get_rows_size(rows);
+        bytes += static_cast<qint64>(columns.temperatures.capacity() * sizeof(quint16) + columns.log_luminosities.capacity() * sizeof(qint16) + columns.spectral_types.capacity());
+        bytes += columns.names.capacity() + static_cast<qint64>(columns.name_buckets.capacity() * sizeof(quint32));
+        memory.set(bytes);
+    }
+
+    vector<vector<QString>> rows;
+    bool packed;
+    PackedColumns columns;
+
+    //Counted in 'dataset_memory' for as long as the chunk exists, so the chunks shared by several snapshots are counted once
+    mutable MemoryCounter memory;
+
+private:
+    void clear_derived()
+    {
+        for(int c = 0; c < column_count - stored_column_count; c ++)
+        {
+            derived[c].store(nullptr, memory_order_relaxed);
+        }
+    }
+
+    //Derived values by column, null until requested for the first time and then calculated for the whole chunk
+    mutable atomic<const vector<double>*> derived[column_count - stored_column_count];
+};
+
+//Interface of the stores which keep the chunks of a list outside of memory and load them when requested
+class ChunkSource
+{
+public:
+    virtual ~ChunkSource()
+    {
+    }
+
+    //Column files count their rows with 64 bits, a snapshot can only index the first 2^32 of them
+    virtual quint64 get_row_count() const = 0;
+
+    //Returns the chunk at index 'index', which stays valid for as long as the caller keeps it
+    virtual shared_ptr<const StarChunk> load_chunk(unsigned index) = 0;
+};
+
+//Class containing an immutable star list
+//The rows are stored in chunks which are shared between snapshots, so changing one row only copies the chunk it belongs to
+//Each row only stores the name, the temperature and the luminosity: the other columns are calculated for a whole chunk when they are first requested and then kept
+//The chunks of an out-of-core list are loaded from its 'ChunkSource' when needed, except the ones which have been changed
+class StarDataset
+{
+public:
+    typedef StarChunk Chunk;
+
+    //Number of rows stored in each chunk
+    static const unsigned chunk_size = 1024;
+
+    //Returns the number of stars in the list
+    unsigned size() const
+    {
+        return row_count;
+    }
+
+    bool empty() const
+    {
+        return row_count == 0;
+    }
+
+    unsigned get_chunk_count() const
+    {
+        return static_cast<unsigned>(chunks.size());
+    }
+
+    //Returns the chunk at index 'index', loading it from the source if the list is out-of-core
+    //Loops over a whole list should go chunk by chunk, so each chunk of an out-of-core list is only loaded once
+    shared_ptr<const Chunk> get_chunk(unsigned index) const
+    {
+        return chunks[index] ? chunks[index] : source->load_chunk(index);
+    }
+
+    bool is_out_of_core() const
+    {
+        return source != nullptr;
+    }
+
+    //Returns the memory counted for the chunks in memory, without the ones only held by the cache of the source
+    qint64 get_memory_size() const
+    {
+        qint64 bytes = 0;
+        for(unsigned i = 0; i < chunks.size(); i ++)
+        {
+            bytes += chunks[i] ? chunks[i]->memory.get() : 0;
+        }
+        return bytes;
+    }
+
+    //Returns true if the list is kept in the packed form, so the lists made from it can be packed as well
+    bool is_packed() const
+    {
+        return !chunks.empty() && get_chunk(0)->packed;
+    }
+
+    //Returns the stored values of the star at index 'i': name, temperature and luminosity
+    vector<QString> operator[](unsigned i) const
+    {
+        return get_chunk(i / chunk_size)->get_row(i % chunk_size);
+    }
+
+    QString get_name(unsigned i) const
+    {
+        return get_chunk(i / chunk_size)->get_name(i % chunk_size);
+    }
+
+    double get_temperature(unsigned i) const
+    {
+        return get_chunk(i / chunk_size)->get_temperature(i % chunk_size);
+    }
+
+    double get_luminosity(unsigned i) const
+    {
+        return get_chunk(i / chunk_size)->get_luminosity(i % chunk_size);
+    }
+
+    double get_log_luminosity(unsigned i) const
+    {
+        return get_chunk(i / chunk_size)->get_log_luminosity(i % chunk_size);
+    }
+
+    //Returns the value of a derived column for the star at index 'i', calculating it for the whole chunk if needed
+    //The spectral class is returned in the numeric form used by 'StarFunctions::get_spectral_type()'
+    double get_derived(DerivedColumn column, unsigned i) const
+    {
+        shared_ptr<const Chunk> chunk_ref = get_chunk(i / chunk_size);
+        const Chunk& chunk = *chunk_ref;
+        unsigned row = i % chunk_size;
+        int index = column - stored_column_count;
+
+        //The packed form already stores the spectral type
+        if(chunk.packed && column == spectral_class_column)
+        {
+            return chunk.columns.spectral_types[row];
+        }
+
+        //Snapshots are read by several threads: the values of a chunk are published once and only read afterwards
+        //Two threads missing at the same time both calculate the column, and the values of the first one are kept
+        const vector<double>* values = chunk.get_derived(index);
+        if(values == nullptr)
+        {
+            vector<double>* calculated = new vector<double>(chunk.size());
+            vector<unsigned> all_rows(chunk.size());
+            for(unsigned r = 0; r < chunk.size(); r ++)
+            {
+                all_rows[r] = r;
+            }
+            calculate_derived(column, chunk, all_rows, *calculated);
+            values = chunk.publish_derived(index, calculated);
+        }
+        return (*values)[row];
+    }
+
+    //Returns a number which changes every time a new snapshot is created
+    unsigned get_version() const
+    {
+        return version;
+    }
+
+    //Returns the version of the first snapshot of the chain of appends this one was made by, so the rows of every snapshot of the chain are unchanged up to its size
+    //A snapshot made in any other way starts a chain and returns its own version
+    unsigned get_append_origin() const
+    {
+        return append_origin;
+    }
+
+    //Returns a copy of the rows, the strings themselves are implicitly shared
+    vector<vector<QString>> to_rows() const
+    {
+        vector<vector<QString>> rows;
+        rows.reserve(row_count);
+        for(unsigned i = 0; i < chunks.size(); i ++)
+        {
+            vector<vector<QString>> chunk_rows = get_chunk(i)->get_rows();
+            rows.insert(rows.end(), chunk_rows.begin(), chunk_rows.end());
+        }
+        return rows;
+    }
+
+    //Create a snapshot from a whole list, packing it if 'packed' is set
+    static DatasetSnapshot from_rows(const vector<vector<QString>>& rows, bool packed = compact_storage)
+    {
+        shared_ptr<StarDataset> dataset(new StarDataset());
+        for(unsigned i = 0; i < rows.size(); i += chunk_size)
+        {
+            unsigned end = min(static_cast<unsigned>(rows.size()), i + chunk_size);
+            shared_ptr<Chunk> chunk = make_shared<Chunk>(rows.begin() + i, rows.begin() + end, packed);
+            for(unsigned j = 0; j < chunk->rows.size(); j ++)
+            {
+                if(chunk->rows[j].size() > stored_column_count)
+                {
+                    chunk->rows[j].resize(stored_column_count);
+                }
+            }
+            chunk->count_memory();
+            dataset->chunks.push_back(chunk);
+        }
+        dataset->row_count = static_cast<unsigned>(rows.size());
+        return dataset;
+    }
+
+    //Create a snapshot of an out-of-core list, no chunk is loaded until it is requested
+    //Returns 'nullptr' if the source has more rows than a snapshot can index
+    static DatasetSnapshot from_source(shared_ptr<ChunkSource> source)
+    {
+        if(source->get_row_count() > numeric_limits<unsigned>::max())
+        {
+            return nullptr;
+        }
+        shared_ptr<StarDataset> dataset(new StarDataset());
+        dataset->source = source;
+        dataset->row_count = static_cast<unsigned>(source->get_row_count());
+        dataset->chunks.resize((dataset->row_count + chunk_size - 1) / chunk_size);
+        return dataset;
+    }
+
+    //Returns a new snapshot with 'entry' appended: only the last chunk is copied, keeping its derived values
+    DatasetSnapshot with_appended(const vector<QString>& entry) const
+    {
+        shared_ptr<StarDataset> dataset(new StarDataset(*this));
+        if(row_count % chunk_size == 0)
+        {
+            vector<vector<QString>> rows(1, get_stored_values(entry));
+            dataset->chunks.push_back(make_shared<Chunk>(rows.begin(), rows.end(), compact_storage));
+        }
+        else
+        {
+            shared_ptr<Chunk> last_chunk = copy_chunk(*get_chunk(static_cast<unsigned>(chunks.size()) - 1));
+            set_chunk_row(*last_chunk, last_chunk->size(), get_stored_values(entry));
+            dataset->chunks.back() = last_chunk;
+        }
+        dataset->row_count ++;
+        dataset->append_origin = append_origin;
+        return dataset;
+    }
+
+    //Returns a new snapshot with the row 'i' replaced by 'entry': only the chunk containing it is copied, and only the derived values of that row are calculated again
+    DatasetSnapshot with_row(unsigned i, const vector<QString>& entry) const
+    {
+        shared_ptr<StarDataset> dataset(new StarDataset(*this));
+        shared_ptr<Chunk> chunk = copy_chunk(*get_chunk(i / chunk_size));
+        set_chunk_row(*chunk, i % chunk_size, get_stored_values(entry));
+        dataset->chunks[i / chunk_size] = chunk;
+        return dataset;
+    }
+
+    //Returns a new snapshot with the rows of 'replaced', sorted by index, changed and the rows of 'appended' added at the end
+    //Each chunk with changed rows is built again only once, in parallel with the others, and the unchanged chunks are shared
+    DatasetSnapshot with_changes(const vector<pair<unsigned, vector<QString>>>& replaced, const vector<vector<QString>>& appended) const
+    {
+        shared_ptr<StarDataset> dataset(new StarDataset(*this));
+        bool packed = chunks.empty() ? compact_storage : is_packed();
+
+        //Index of the first replaced row of each chunk
+        vector<unsigned> chunk_starts;
+        for(unsigned i = 0; i < replaced.size(); i ++)
+        {
+            if(i == 0 || replaced[i].first / chunk_size != replaced[i - 1].first / chunk_size)
+            {
+                chunk_starts.push_back(i);
+            }
+        }
+        QtConcurrent::blockingMap(chunk_starts, [&](unsigned& start)
+        {
+            unsigned c = replaced[start].first / chunk_size;
+            shared_ptr<const Chunk> chunk = get_chunk(c);
+            vector<vector<QString>> rows = chunk->get_rows();
+            for(unsigned i = start; i < replaced.size() && replaced[i].first / chunk_size == c; i ++)
+            {
+                rows[replaced[i].first % chunk_size] = get_stored_values(replaced[i].second);
+            }
+            dataset->chunks[c] = make_shared<Chunk>(rows.begin(), rows.end(), chunk->packed);
+        });
+
+        //Fill the last chunk before adding new ones
+        unsigned first = 0;
+        if(row_count % chunk_size != 0 && !appended.empty())
+        {
+            shared_ptr<const Chunk> last_chunk = dataset->get_chunk(static_cast<unsigned>(chunks.size()) - 1);
+            vector<vector<QString>> rows = last_chunk->get_rows();
+            first = min(static_cast<unsigned>(appended.size()), chunk_size - last_chunk->size());
+            for(unsigned i = 0; i < first; i ++)
+            {
+                rows.push_back(get_stored_values(appended[i]));
+            }
+            dataset->chunks.back() = make_shared<Chunk>(rows.begin(), rows.end(), last_chunk->packed);
+        }
+        for(unsigned i = first; i < appended.size(); i += chunk_size)
+        {
+            vector<vector<QString>> rows;
+            for(unsigned j = i; j < min(static_cast<unsigned>(appended.size()), i + chunk_size); j ++)
+            {
+                rows.push_back(get_stored_values(appended[j]));
+            }
+            dataset->chunks.push_back(make_shared<Chunk>(rows.begin(), rows.end(), packed));
+        }
+        dataset->row_count += static_cast<unsigned>(appended.size());
+        if(replaced.empty())
+        {
+            dataset->append_origin = append_origin;
+        }
+        return dataset;
+    }
+
+    //Returns a new snapshot without the rows whose bit is set in 'removed', one bit for each row
+    //The chunks before the first removed row are shared, the rows after it are moved up one chunk at a time, so the whole list is never copied at once
+    DatasetSnapshot without_rows(const vector<quint64>& removed) const
+    {
+        shared_ptr<StarDataset> dataset(new StarDataset(*this));
+        unsigned first_chunk = 0;
+        while(first_chunk < chunks.size() && !has_removed_rows(removed, first_chunk))
+        {
+            first_chunk ++;
+        }
+        if(first_chunk == chunks.size())
+        {
+            return dataset;
+        }
+
+        bool packed = is_packed();
+        dataset->chunks.resize(first_chunk);
+        dataset->row_count = first_chunk * chunk_size;
+        vector<vector<QString>> rows;
+        for(unsigned c = first_chunk; c < chunks.size(); c ++)
+        {
+            shared_ptr<const Chunk> chunk = get_chunk(c);
+            for(unsigned i = 0; i < chunk->size(); i ++)
+            {
+                unsigned row = c * chunk_size + i;
+                if(row / 64 < removed.size() && (removed[row / 64] >> (row % 64)) & 1)
+                {
+                    continue;
+                }
+                rows.push_back(chunk->get_row(i));
+                if(rows.size() == chunk_size)
+                {
+                    dataset->chunks.push_back(make_shared<Chunk>(rows.begin(), rows.end(), packed));
+                    dataset->row_count += chunk_size;
+                    rows.clear();
+                }
+            }
+        }
+        if(!rows.empty())
+        {
+            dataset->chunks.push_back(make_shared<Chunk>(rows.begin(), rows.end(), packed));
+            dataset->row_count += static_cast<unsigned>(rows.size());
+        }
+        return dataset;
+    }
+
+private:
+    StarDataset() : row_count(0), version(next_version()), append_origin(version)
+    {
+    }
+
+    StarDataset(const StarDataset& other) : chunks(other.chunks), source(other.source), row_count(other.row_count), version(next_version()), append_origin(version)
+    {
+    }
+
+    static bool has_removed_rows(const vector<quint64>& removed, unsigned c)
+    {
+        for(unsigned w = c * chunk_size / 64; w < (c + 1) * chunk_size / 64 && w < removed.size(); w ++)
+        {
+            if(removed[w] != 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //Returns only the name, the temperature and the luminosity of 'entry'
+    static vector<QString> get_stored_values(const vector<QString>& entry)
+    {
+        return vector<QString>(entry.begin(), entry.begin() + min(static_cast<int>(entry.size()), stored_column_count));
+    }
+
+    //Replace or, if 'row' is the size of the chunk, append a row
+    //A packed chunk is packed again as a whole, since the names are front-coded
+    static void set_chunk_row(Chunk& chunk, unsigned row, const vector<QString>& entry)
+    {
+        vector<vector<QString>> rows = chunk.packed ? chunk.get_rows() : vector<vector<QString>>();
+        vector<vector<QString>>& target = chunk.packed ? rows : chunk.rows;
+        if(row == target.size())
+        {
+            target.push_back(entry);
+        }
+        else
+        {
+            target[row] = entry;
+        }
+        if(chunk.packed)
+        {
+            chunk.columns = PackingFunctions::pack(rows.begin(), rows.end());
+        }
+        chunk.count_memory();
+
+        //The derived values already published for the chunk are kept, only the ones of this row are calculated again
+        vector<unsigned> changed_rows(1, row);
+        for(int c = 0; c < column_count - stored_column_count; c ++)
+        {
+            const vector<double>* values = chunk.get_derived(c);
+            if(values != nullptr)
+            {
+                vector<double>* updated = new vector<double>(*values);
+                updated->resize(chunk.size());
+                calculate_derived(static_cast<DerivedColumn>(c + stored_column_count), chunk, changed_rows, *updated);
+                chunk.set_derived(c, updated);
+            }
+        }
+    }
+
+    //Copy a chunk together with the derived values calculated so far
+    static shared_ptr<Chunk> copy_chunk(const Chunk& chunk)
+    {
+        return make_shared<Chunk>(chunk);
+    }
+
+    //Calculate the values of 'column' for the rows 'pending' of a chunk
+    //The stored values are read first, so the formulas run over plain arrays of numbers
+    static void calculate_derived(DerivedColumn column, const Chunk& chunk, const vector<unsigned>& pending, vector<double>& values)
+    {
+        unsigned count = static_cast<unsigned>(pending.size());
+        vector<double> temperatures(count);
+        vector<double> luminosities(count);
+        vector<double> results(count);
+        for(unsigned i = 0; i < count; i ++)
+        {
+            temperatures[i] = chunk.get_temperature(pending[i]);
+            luminosities[i] = chunk.get_luminosity(pending[i]);
+        }
+
+        switch(column)
+        {
+            case spectral_class_column:
+                for(unsigned i = 0; i < count; i ++)
+                {
+                    results[i] = StarFunctions::get_spectral_type(static_cast<int>(temperatures[i]));
+                }
+                break;
+
+            case absolute_magnitude_column:
+                for(unsigned i = 0; i < count; i ++)
+                {
+                    results[i] = StarFunctions::get_absolute_magnitude(luminosities[i]);
+                }
+                break;
+
+            case radius_column:
+                for(unsigned i = 0; i < count; i ++)
+                {
+                    results[i] = StarFunctions::get_radius(temperatures[i], luminosities[i]);
+                }
+                break;
+
+            case mass_column:
+                for(unsigned i = 0; i < count; i ++)
+                {
+                    results[i] = StarFunctions::get_main_sequence_mass(luminosities[i]);
+                }
+                break;
+        }
+
+        for(unsigned i = 0; i < count; i ++)
+        {
+            values[pending[i]] = results[i];
+        }
+    }
+
+    static unsigned next_version()
+    {
+        static atomic<unsigned> version_counter(0);
+        return version_counter ++;
+    }
+
+    //The chunks which are not in memory are 'nullptr'
+    vector<shared_ptr<const Chunk>> chunks;
+    shared_ptr<ChunkSource> source;
+    unsigned row_count;
+    unsigned version;
+    unsigned append_origin;
+};
+
+//Class containing the functions used to read and replace the current snapshot
+//Only the GUI thread publishes new snapshots, every other thread takes one with 'current()' and never sees it change
+class DatasetFunctions
+{
+public:
+    //Returns the current snapshot
+    static DatasetSnapshot current()
+    {
+        DatasetSnapshot dataset = atomic_load(&current_dataset);
+        if(!dataset)
+        {
+            dataset = StarDataset::from_rows(vector<vector<QString>>());
+        }
+        return dataset;
+    }
+
+    //Atomically replace the current snapshot
+    static void publish(DatasetSnapshot dataset)
+    {
+        atomic_store(&current_dataset, dataset);
+    }
+
+    //Replace the whole list
+    static void publish_rows(const vector<vector<QString>>& rows)
+    {
+        publish(StarDataset::from_rows(rows));
+    }
+
+    //Append a star to the list
+    static void append(const vector<QString>& entry)
+    {
+        publish(current()->with_appended(entry));
+    }
+
+    //Replace the values of the star at index 'row'
+    static void set_row(unsigned row, const vector<QString>& entry)
+    {
+        publish(current()->with_row(row, entry));
+    }
+};
@@ -0,0 +1,188 @@
+/*
+    STAR SELECTION
+*/
+#pragma once
+
+#include <QPolygonF>
+#include <QtAlgorithms>
+#include <QtConcurrent>
+#include <cmath>
+#include <vector>
+
+#include "catalog_layers.h"
+#include "gl_diagram.h"
+#include "star_dataset.h"
+
+using namespace std;
+
+//Stars selected on the diagram, one bit for each row of the snapshot 'dataset_version'
+struct StarSelection
+{
+    vector<quint64> bits;
+    unsigned count;
+    unsigned dataset_version;
+    //Changes every time the selection does
+    unsigned version;
+};
+
+extern StarSelection star_selection;
+
+//Class containing the functions used to select stars on the diagram and to work on all of them at once
+class SelectionFunctions
+{
+public:
+    //Number of bitmap words covering a chunk, so each chunk is written by a single thread
+    static const unsigned chunk_words = StarDataset::chunk_size / 64;
+
+    //Select the stars of 'dataset' whose position lies inside 'polygon', given in the coordinates of 'ProjectionFunctions'
+    //The chunks are tested in parallel, each one edge at a time over plain arrays of coordinates
+    static void select_polygon(const StarDataset& dataset, const QPolygonF& polygon)
+    {
+        vector<quint64> bits(static_cast<size_t>(dataset.get_chunk_count()) * chunk_words, 0);
+        if(polygon.size() >= 3)
+        {
+            QRectF bounds = polygon.boundingRect();
+            DiagramView view = ProjectionFunctions::get_view();
+            vector<unsigned> chunk_indexes(dataset.get_chunk_count());
+            for(unsigned c = 0; c < chunk_indexes.size(); c ++)
+            {
+                chunk_indexes[c] = c;
+            }
+            QtConcurrent::blockingMap(chunk_indexes, [&](unsigned& c)
+            {
+                select_chunk(view, dataset, c, polygon, bounds, &bits[static_cast<size_t>(c) * chunk_words]);
+            });
+        }
+
+        unsigned count = 0;
+        for(unsigned i = 0; i < bits.size(); i ++)
+        {
+            count += qPopulationCount(bits[i]);
+        }
+
+        star_selection.bits.swap(bits);
+        star_selection.count = count;
+        star_selection.dataset_version = dataset.get_version();
+        star_selection.version ++;
+    }
+
+    static void clear()
+    {
+        star_selection.bits.clear();
+        star_selection.count = 0;
+        star_selection.version ++;
+    }
+
+    //Returns the number of selected stars of 'dataset', '0' if the selection was made on another snapshot
+    static unsigned get_count(const StarDataset& dataset)
+    {
+        return star_selection.dataset_version == dataset.get_version() ? star_selection.count : 0;
+    }
+
+    static bool is_selected(unsigned row)
+    {
+        return (star_selection.bits[row / 64] >> (row % 64)) & 1;
+    }
+
+    //Returns the rows of 'dataset' which are selected, or the ones which are not if 'selected' is false
+    static vector<vector<QString>> get_rows(const StarDataset& dataset, bool selected)
+    {
+        vector<vector<QString>> rows;
+        for(unsigned c = 0; c < dataset.get_chunk_count(); c ++)
+        {
+            shared_ptr<const StarChunk> chunk = dataset.get_chunk(c);
+            for(unsigned i = 0; i < chunk->size(); i ++)
+            {
+                if(is_selected(c * StarDataset::chunk_size + i) == selected)
+                {
+                    rows.push_back(chunk->get_row(i));
+                }
+            }
+        }
+        return rows;
+    }
+
+    //Fill 'vertices' with the selected stars in the layout of 'LayerFunctions::build_vertices()', skipping the chunks without any
+    static int build_vertices(const StarDataset& dataset, vector<float>& vertices)
+    {
+        vector<float> bright_vertices;
+        vertices.clear();
+        double pivot = ProjectionFunctions::get_kernels().get_y_scale(ProjectionFunctions::get_view()).pivot;
+        vector<double> x_values(StarDataset::chunk_size);
+        vector<double> y_values(StarDataset::chunk_size);
+        for(unsigned c = 0; c < dataset.get_chunk_count(); c ++)
+        {
+            const quint64* words = &star_selection.bits[static_cast<size_t>(c) * chunk_words];
+            bool any = false;
+            for(unsigned w = 0; w < chunk_words; w ++)
+            {
+                any = any || words[w] != 0;
+            }
+            if(!any)
+            {
+                continue;
+            }
+
+            shared_ptr<const StarChunk> chunk = dataset.get_chunk(c);
+            ProjectionFunctions::get_values(*chunk, x_values.data(), y_values.data());
+            for(unsigned w = 0; w < chunk_words; w ++)
+            {
+                for(quint64 word = words[w]; word != 0; word &= word - 1)
+                {
+                    unsigned i = w * 64 + qCountTrailingZeroBits(word);
+                    if(!ProjectionFunctions::is_finite(x_values[i], y_values[i]))
+                    {
+                        continue;
+                    }
+                    float vertex[LayerFunctions::vertex_size] = { static_cast<float>(x_values[i]), static_cast<float>(y_values[i]), 1, 0, 1 };
+                    vector<float>& target = y_values[i] < pivot ? vertices : bright_vertices;
+                    target.insert(target.end(), vertex, vertex + LayerFunctions::vertex_size);
+                }
+            }
+        }
+
+        int faint_count = static_cast<int>(vertices.size()) / LayerFunctions::vertex_size;
+        vertices.insert(vertices.end(), bright_vertices.begin(), bright_vertices.end());
+        return faint_count;
+    }
+
+private:
+    //Crossing number test of every star of a chunk against every edge of 'polygon'
+    static void select_chunk(const DiagramView& view, const StarDataset& dataset, unsigned c, const QPolygonF& polygon, QRectF bounds, quint64* words)
+    {
+        shared_ptr<const StarChunk> chunk = dataset.get_chunk(c);
+        unsigned count = chunk->size();
+
+        //Project the stars in 'view', the current settings when the selection was started, without rounding to whole pixels
+        //The positions which are not finite are never inside the bounds of the polygon, so those stars are never selected
+        vector<double> xs(count);
+        vector<double> ys(count);
+        vector<char> inside(count, 0);
+        ProjectionFunctions::project_chunk(view, *chunk, xs.data(), ys.data());
+
+        for(int e = 0; e < polygon.size(); e ++)
+        {
+            QPointF start = polygon[e];
+            QPointF end = polygon[(e + 1) % polygon.size()];
+            if(start.y() == end.y())
+            {
+                continue;
+            }
+            double inverse_slope = (end.x() - start.x()) / (end.y() - start.y());
+            for(unsigned i = 0; i < count; i ++)
+            {
+                bool crosses = (start.y() > ys[i]) != (end.y() > ys[i]);
+                bool left = xs[i] < start.x() + (ys[i] - start.y()) * inverse_slope;
+                inside[i] ^= static_cast<char>(crosses & left);
+            }
+        }
+
+        for(unsigned i = 0; i < count; i ++)
+        {
+            if(inside[i] && bounds.contains(xs[i], ys[i]))
+            {
+                words[i / 64] |= static_cast<quint64>(1) << (i % 64);
+            }
+        }
+    }
+};
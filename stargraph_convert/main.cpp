@@ -0,0 +1,130 @@
+/*
+    COMMAND LINE CONVERTER
+*/
+
+#include "stargraph_core.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <vector>
+
+using namespace std;
+
+//A file to convert and the result of its conversion
+struct ConversionJob
+{
+    QString input_name;
+    QString output_name;
+    //With '--pyramid' the density pyramid of the output is built next to it once it is written
+    bool build_pyramid;
+    bool converted;
+    quint64 row_count;
+    qint64 elapsed_ms;
+};
+
+//Convert a file with the core library, reading and writing it as a csv table if its extension is '.csv' and as a '.sgl' list otherwise
+//The journal of a snapshot stays next to the original list, so the converted list does not refer to it
+static void convert(ConversionJob& job)
+{
+    QElapsedTimer timer;
+    timer.start();
+    job.converted = StarGraphCore::convert_list(job.input_name, job.output_name, &job.row_count);
+    if(job.converted && job.build_pyramid)
+    {
+        quint64 pyramid_rows = 0;
+        job.converted = StarGraphCore::build_pyramid(job.output_name, &pyramid_rows);
+    }
+    job.elapsed_ms = timer.elapsed();
+}
+
+static QString get_rate_str(quint64 row_count, qint64 elapsed_ms)
+{
+    return QString::number(static_cast<double>(row_count) * 1000 / max<qint64>(elapsed_ms, 1), 'f', 0);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QTextStream output(stdout);
+    QTextStream error_output(stderr);
+
+    //Read the options and the pairs of files
+    QStringList arguments = a.arguments();
+    bool show_stats = false;
+    bool build_pyramids = false;
+    int job_count = QThread::idealThreadCount();
+    QStringList file_names;
+    bool valid_arguments = true;
+    for(int i = 1; i < arguments.length(); i ++)
+    {
+        if(arguments[i] == "--stats")
+        {
+            show_stats = true;
+        }
+        else if(arguments[i] == "--pyramid")
+        {
+            build_pyramids = true;
+        }
+        else if(arguments[i] == "--jobs" && i + 1 < arguments.length())
+        {
+            job_count = arguments[++ i].toInt(&valid_arguments);
+            valid_arguments = valid_arguments && job_count > 0;
+        }
+        else if(arguments[i].startsWith("--"))
+        {
+            valid_arguments = false;
+        }
+        else
+        {
+            file_names << arguments[i];
+        }
+    }
+    if(!valid_arguments || file_names.isEmpty() || file_names.length() % 2 != 0)
+    {
+        error_output << "Usage: stargraph_convert [--stats] [--jobs N] [--pyramid] INPUT OUTPUT [INPUT OUTPUT ...]\n";
+        error_output << "Files ending in '.csv' are read and written as csv tables, any other file as a '.sgl' list.\n";
+        error_output << "With --pyramid the density pyramid of each output is built next to it, as StarGraph does.\n";
+        error_output << "The files are converted in parallel, N at a time (" << QThread::idealThreadCount() << " by default).\n";
+        return 2;
+    }
+
+    vector<ConversionJob> jobs;
+    for(int i = 0; i < file_names.length(); i += 2)
+    {
+        ConversionJob job = { file_names[i], file_names[i + 1], build_pyramids, false, 0, 0 };
+        jobs.push_back(job);
+    }
+
+    QThreadPool::globalInstance()->setMaxThreadCount(job_count);
+    QElapsedTimer timer;
+    timer.start();
+    QtConcurrent::blockingMap(jobs, convert);
+    qint64 elapsed_ms = timer.elapsed();
+
+    int failed_count = 0;
+    quint64 total_rows = 0;
+    for(unsigned i = 0; i < jobs.size(); i ++)
+    {
+        if(!jobs[i].converted)
+        {
+            error_output << jobs[i].input_name << ": the file could not be converted to " << jobs[i].output_name << "\n";
+            failed_count ++;
+            continue;
+        }
+        total_rows += jobs[i].row_count;
+        if(show_stats)
+        {
+            output << jobs[i].input_name << " -> " << jobs[i].output_name << ": " << jobs[i].row_count << " rows in " << jobs[i].elapsed_ms << " ms, " << get_rate_str(jobs[i].row_count, jobs[i].elapsed_ms) << " rows/s\n";
+        }
+    }
+    if(show_stats && jobs.size() > 1)
+    {
+        output << "Total: " << total_rows << " rows in " << elapsed_ms << " ms, " << get_rate_str(total_rows, elapsed_ms) << " rows/s\n";
+    }
+
+    return failed_count == 0 ? 0 : 1;
+}
@@ -0,0 +1,40 @@
+#-------------------------------------------------
+#
+# Command line converter between csv tables and StarGraph lists
+#
+#-------------------------------------------------
+
+QT       += core gui concurrent
+QT       -= widgets
+
+TARGET = stargraph_convert
+TEMPLATE = app
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# The conversion comes from the core library, built first by StarGraphSuite.pro
+INCLUDEPATH += .. ../stargraph_core
+DEPENDPATH += ../stargraph_core
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../stargraph_core/release -lstargraph_core
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../stargraph_core/debug -lstargraph_core
+else: LIBS += -L$$OUT_PWD/../stargraph_core -lstargraph_core
+
+win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../stargraph_core/release/libstargraph_core.a
+else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../stargraph_core/debug/libstargraph_core.a
+else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../stargraph_core/release/stargraph_core.lib
+else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../stargraph_core/debug/stargraph_core.lib
+else: PRE_TARGETDEPS += $$OUT_PWD/../stargraph_core/libstargraph_core.a
+
+SOURCES += \
+    main.cpp
+
+HEADERS += \
+    ../stargraph_core/stargraph_core.h
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
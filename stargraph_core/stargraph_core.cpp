@@ -0,0 +1,164 @@
+/*
+    STARGRAPH CORE LIBRARY
+*/
+
+#include "stargraph_core.h"
+#include "density_pyramid.h"
+#include "diagram_painter.h"
+#include "file_manager.h"
+#include "parameter_calculation.h"
+
+#include <QCoreApplication>
+#include <QGuiApplication>
+
+using namespace std;
+
+//Version
+QString stargraph_version = "1.0.3";
+
+//Assign the default values to the extern variables shared with the application
+DatasetSnapshot current_dataset;
+bool compact_storage = false;
+
+int temp_min = 3000;
+int temp_max = 15000;
+int lum_min = -8;
+int lum_max = 8;
+int diagram_width = 640;
+int diagram_height = 640;
+
+DiagramProjection diagram_projection = hr_projection;
+
+//Rows held in memory by a conversion
+static const unsigned convert_block_rows = 16 * 1024;
+
+DatasetSnapshot StarGraphCore::create_list(const vector<vector<QString>>& rows)
+{
+    return StarDataset::from_rows(rows);
+}
+
+DatasetSnapshot StarGraphCore::load_list(QString file_name, bool* supported)
+{
+    return StarDataset::from_rows(FileIOFunctions::load_any(file_name, supported));
+}
+
+DatasetSnapshot StarGraphCore::load_preview(QString file_name, unsigned sample_size, SampleMode mode, quint64* row_count, bool* supported)
+{
+    ListSample sample = SampleFunctions::read_sample(file_name, sample_size, mode);
+    *row_count = sample.row_count;
+    *supported = sample.supported;
+    return StarDataset::from_rows(sample.rows);
+}
+
+bool StarGraphCore::save_list(QString file_name, DatasetSnapshot list)
+{
+    return FileIOFunctions::write_list(file_name, list, -1);
+}
+
+bool StarGraphCore::convert_list(QString input_name, QString output_name, quint64* row_count)
+{
+    *row_count = 0;
+    ListReader reader;
+    ListWriter writer(output_name);
+    if(!reader.open(input_name) || !writer.open())
+    {
+        return false;
+    }
+
+    vector<vector<QString>> rows;
+    bool more_rows = true;
+    bool written = true;
+    while(more_rows && written)
+    {
+        more_rows = reader.read_rows(rows, convert_block_rows);
+        for(unsigned i = 0; i < rows.size() && written; i ++)
+        {
+            written = writer.write_row(rows[i]);
+        }
+        *row_count += rows.size();
+        rows.clear();
+    }
+    return written && reader.is_supported() && writer.commit();
+}
+
+bool StarGraphCore::build_pyramid(QString list_name, quint64* row_count)
+{
+    *row_count = 0;
+    QFileInfo list_info(list_name);
+    ListReader reader;
+    if(!reader.open(list_name))
+    {
+        return false;
+    }
+
+    PyramidBuilder builder;
+    vector<vector<QString>> rows;
+    bool more_rows = true;
+    while(more_rows)
+    {
+        more_rows = reader.read_rows(rows, convert_block_rows);
+        for(unsigned i = 0; i < rows.size(); i ++)
+        {
+            double luminosity = rows[i][2].toDouble();
+            builder.add_star(rows[i][1].toDouble(), luminosity > 0 ? MathFunctions::log_base_10(luminosity) : -numeric_limits<double>::infinity());
+        }
+        *row_count += rows.size();
+        rows.clear();
+    }
+    return reader.is_supported() && builder.write(list_name, list_info.size(), list_info.lastModified().toMSecsSinceEpoch());
+}
+
+QString StarGraphCore::get_column_str(DatasetSnapshot list, unsigned row, int column)
+{
+    return ParameterCalculation::get_column_str(*list, row, column);
+}
+
+RenderOptions StarGraphCore::get_default_render_options()
+{
+    RenderOptions options = { { 3000, 15000, -8, 8, 640, 640, hr_projection }, 1.0, 3.0f, false, false, false, true, 2500, 10, 25 };
+    return options;
+}
+
+QImage StarGraphCore::render_image(DatasetSnapshot list, const RenderOptions& options)
+{
+    const DiagramView& view = options.view;
+    QImage image(qRound(view.width * options.scale), qRound(view.height * options.scale), QImage::Format_RGB32);
+    image.fill(Qt::black);
+
+    //Fonts need the font database of a 'QGuiApplication'
+    bool draw_text = qobject_cast<QGuiApplication*>(QCoreApplication::instance()) != nullptr;
+
+    QPainter painter(&image);
+    painter.scale(options.scale, options.scale);
+
+    //The inner drawing area is squeezed into the frame the same way the OpenGL viewport does
+    double scale_x = static_cast<double>(view.width - 64) / view.width;
+    double scale_y = static_cast<double>(view.height - 64) / view.height;
+    painter.save();
+    painter.translate(32, 32);
+    painter.scale(scale_x, scale_y);
+    painter.setClipRect(0, 0, view.width, view.height);
+
+    //Draw the reference lines, the stars and their names
+    double brightness = static_cast<double>(options.lines_opacity) / 100.0;
+    painter.setPen(QPen(QColor::fromRgbF(brightness, brightness, brightness), 1.0 / scale_x));
+    DiagramPainterFunctions::draw_lines(painter, DiagramPainterFunctions::get_reference_lines(view, options.show_v_lines, options.show_h_lines, options.line_h_step, options.line_v_step));
+    DiagramPainterFunctions::draw_star_points(painter, view, *list, true, QColor(), options.round_markers, options.point_size / scale_x);
+    if(options.show_names && draw_text)
+    {
+        painter.setPen(Qt::white);
+        DiagramPainterFunctions::draw_star_name_labels(painter, view, *list);
+    }
+    painter.restore();
+
+    //Draw the white frame and the scale information
+    painter.setPen(QPen(Qt::white, 2.0));
+    DiagramPainterFunctions::draw_lines(painter, DiagramPainterFunctions::get_frame_lines(view, 32));
+    if(draw_text)
+    {
+        painter.setPen(Qt::white);
+        DiagramPainterFunctions::draw_scale_text(painter, view);
+    }
+    painter.end();
+    return image;
+}
@@ -0,0 +1,69 @@
+/*
+    STARGRAPH CORE LIBRARY
+*/
+#pragma once
+
+#include <QImage>
+#include <QString>
+#include <vector>
+
+#include "diagram_projection.h"
+#include "list_sampling.h"
+#include "star_dataset.h"
+
+using namespace std;
+
+//Version of StarGraph and of its lists
+extern QString stargraph_version;
+
+//Look of an image rendered by 'StarGraphCore::render_image()', the same settings as the graph settings of the window
+//Everything the image depends on is in the options, so several images can be rendered at once on different threads
+struct RenderOptions
+{
+    //Ranges of the axes, 'temperature' in Kelvin and 'luminosity' as powers of ten, size of the diagram in pixels and quantities the axes show
+    DiagramView view;
+    //Pixels of the image for each pixel of the diagram
+    double scale;
+    float point_size;
+    bool round_markers;
+    bool show_names;
+    bool show_h_lines;
+    bool show_v_lines;
+    int line_h_step;
+    int line_v_step;
+    int lines_opacity;
+};
+
+//Entry points of the core library: lists, files and rendering, without the widgets or OpenGL
+//A process using it needs a 'QCoreApplication'; names and scale text are only drawn when it is a 'QGuiApplication', which the "offscreen" platform provides without a display
+//The headers the library is built from stay usable on their own, these functions are the part which is kept stable for the services embedding it
+class StarGraphCore
+{
+public:
+    //Build a list from rows of name, temperature and luminosity
+    static DatasetSnapshot create_list(const vector<vector<QString>>& rows);
+
+    //Load a '.sgl' list or a csv table, setting 'supported' to false if it is a table with rows that do not have five columns
+    static DatasetSnapshot load_list(QString file_name, bool* supported);
+
+    //Load a sample of at most 'sample_size' stars of a list or a table, read in a single pass; 'row_count' is set to the number of stars of the whole file
+    static DatasetSnapshot load_preview(QString file_name, unsigned sample_size, SampleMode mode, quint64* row_count, bool* supported);
+
+    //Write 'list' to 'file_name', as a csv table if its extension is '.csv' and as a '.sgl' list otherwise
+    static bool save_list(QString file_name, DatasetSnapshot list);
+
+    //Convert 'input_name' to 'output_name' a block of rows at a time, with the formats chosen by the extensions as in 'save_list()'
+    static bool convert_list(QString input_name, QString output_name, quint64* row_count);
+
+    //Build the density pyramid of the list or table 'list_name' next to it, reading a block of rows at a time, so the list never has to fit in memory
+    static bool build_pyramid(QString list_name, quint64* row_count);
+
+    //Returns the text of 'column' of 'row' as the table shows it, including the calculated spectral class and absolute magnitude
+    static QString get_column_str(DatasetSnapshot list, unsigned row, int column);
+
+    //Returns the options of the diagram window when it is first opened
+    static RenderOptions get_default_render_options();
+
+    //Render 'list' the way the diagram window draws it, on a black background with the frame, the reference lines and the scale text
+    static QImage render_image(DatasetSnapshot list, const RenderOptions& options);
+};
@@ -0,0 +1,39 @@
+#-------------------------------------------------
+#
+# Core library: lists, files and offscreen rendering without the widgets
+#
+#-------------------------------------------------
+
+QT       += core gui concurrent
+QT       -= widgets
+
+TARGET = stargraph_core
+TEMPLATE = lib
+
+CONFIG += staticlib c++11
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# The headers are shared with StarGraph and stargraph_convert
+INCLUDEPATH += ..
+
+SOURCES += \
+    stargraph_core.cpp
+
+HEADERS += \
+    stargraph_core.h \
+    ../file_manager.h \
+    ../base64_codec.h \
+    ../density_pyramid.h \
+    ../journal_manager.h \
+    ../memory_budget.h \
+    ../list_sampling.h \
+    ../parameter_calculation.h \
+    ../star_dataset.h \
+    ../compact_storage.h \
+    ../converter.h \
+    ../diagram_projection.h \
+    ../diagram_painter.h
+
+# The font of the scale text, registered by 'DiagramPainterFunctions::draw_scale_text()'
+RESOURCES += ../fonts.qrc
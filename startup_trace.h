@@ -0,0 +1,64 @@
+/*
+    STARTUP TRACE
+*/
+#pragma once
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QTextStream>
+#include <cstdio>
+
+using namespace std;
+
+//Class containing the functions used to time the phases of the startup, from 'main()' to the first paint of the diagram
+//The timings are only printed when StarGraph is started with '--startup-trace', each phase with the time since 'main()' and its own duration
+class StartupTraceFunctions
+{
+public:
+    //Start the clock, at the beginning of 'main()'
+    static void start(int argc, char* argv[])
+    {
+        TraceState& state = get_state();
+        state.timer.start();
+        for(int i = 1; i < argc; i ++)
+        {
+            if(QString(argv[i]) == "--startup-trace")
+            {
+                state.enabled = true;
+            }
+        }
+    }
+
+    //Record the end of the phase 'phase'
+    static void mark(QString phase)
+    {
+        TraceState& state = get_state();
+        if(!state.enabled)
+        {
+            return;
+        }
+        qint64 elapsed_ms = state.timer.elapsed();
+        QTextStream(stderr) << "startup: " << phase << ": " << elapsed_ms << " ms (+" << elapsed_ms - state.last_ms << " ms)\n";
+        state.last_ms = elapsed_ms;
+    }
+
+    //Record the first paint of the diagram, the end of the startup; the work deferred until then is marked after it
+    static void finish()
+    {
+        mark("first paint");
+    }
+
+private:
+    struct TraceState
+    {
+        QElapsedTimer timer;
+        bool enabled = false;
+        qint64 last_ms = 0;
+    };
+
+    static TraceState& get_state()
+    {
+        static TraceState state;
+        return state;
+    }
+};
@@ -0,0 +1,136 @@
+/*
+    STATISTICS PANEL
+*/
+#pragma once
+
+#include <QDialog>
+#include <QLabel>
+#include <QPainter>
+#include <QVBoxLayout>
+#include <QWidget>
+#include <vector>
+
+#include "list_statistics.h"
+
+using namespace std;
+
+//Widget drawing the bars of a histogram, scaled to its highest bar
+class HistogramView : public QWidget
+{
+public:
+    explicit HistogramView(QWidget* parent = nullptr) : QWidget(parent)
+    {
+        setMinimumSize(400, 110);
+    }
+
+    void set_bars(const vector<quint64>& counts, QString low_label, QString high_label)
+    {
+        bar_counts = counts;
+        low_text = low_label;
+        high_text = high_label;
+        update();
+    }
+
+protected:
+    void paintEvent(QPaintEvent*)
+    {
+        QPainter painter(this);
+        int label_height = fontMetrics().height();
+        int chart_height = height() - label_height - 2;
+        quint64 max_count = 1;
+        for(unsigned i = 0; i < bar_counts.size(); i ++)
+        {
+            max_count = max(max_count, bar_counts[i]);
+        }
+
+        double bar_width = static_cast<double>(width()) / max(1, static_cast<int>(bar_counts.size()));
+        for(unsigned i = 0; i < bar_counts.size(); i ++)
+        {
+            int bar_height = static_cast<int>(static_cast<double>(bar_counts[i]) / max_count * chart_height);
+            painter.fillRect(QRectF(i * bar_width + 1, chart_height - bar_height, bar_width - 1, bar_height), palette().color(QPalette::Highlight));
+        }
+        painter.setPen(palette().color(QPalette::WindowText));
+        painter.drawLine(0, chart_height, width(), chart_height);
+        painter.drawText(QRect(0, chart_height + 2, width(), label_height), Qt::AlignLeft, low_text);
+        painter.drawText(QRect(0, chart_height + 2, width(), label_height), Qt::AlignRight, high_text);
+    }
+
+private:
+    vector<quint64> bar_counts;
+    QString low_text;
+    QString high_text;
+};
+
+//Window summarizing the current list: percentiles, moments, histograms, spectral classes and the main sequence fraction
+class StatisticsPanel : public QDialog
+{
+public:
+    explicit StatisticsPanel(QWidget* parent = nullptr) : QDialog(parent)
+    {
+        setWindowTitle("List statistics");
+        summary_label = new QLabel(this);
+        summary_label->setTextInteractionFlags(Qt::TextSelectableByMouse);
+        temperature_view = new HistogramView(this);
+        luminosity_view = new HistogramView(this);
+
+        QVBoxLayout* layout = new QVBoxLayout(this);
+        layout->addWidget(summary_label);
+        layout->addWidget(new QLabel("Temperature, 2000 K to 42000 K:", this));
+        layout->addWidget(temperature_view);
+        layout->addWidget(new QLabel("Relative luminosity, 1e-5 to 1e7:", this));
+        layout->addWidget(luminosity_view);
+    }
+
+    void show_statistics(const ListStatistics& statistics)
+    {
+        const ValueSketch& temperature = statistics.temperature;
+        const ValueSketch& log_luminosity = statistics.log_luminosity;
+        double total = max<double>(1, statistics.star_count);
+
+        QString summary = "<b>" + QString::number(statistics.star_count) + " stars</b><br>";
+        summary += "Temperature: mean " + QString::number(temperature.mean, 'f', 0) + " K, standard deviation " + QString::number(StatisticsFunctions::get_standard_deviation(temperature), 'f', 0) + " K<br>";
+        summary += "&nbsp;&nbsp;percentiles 5 / 25 / 50 / 75 / 95: " + get_percentiles_str(temperature, false) + " K<br>";
+        summary += "Luminosity: mean log10 " + QString::number(log_luminosity.mean, 'f', 2) + ", standard deviation " + QString::number(StatisticsFunctions::get_standard_deviation(log_luminosity), 'f', 2) + " dex<br>";
+        summary += "&nbsp;&nbsp;percentiles 5 / 25 / 50 / 75 / 95: " + get_percentiles_str(log_luminosity, true) + " Sol<br>";
+
+        static const char* class_names[8] = { "O", "B", "A", "F", "G", "K", "M", "outside O-M" };
+        summary += "Spectral classes:";
+        for(int i = 0; i < 8; i ++)
+        {
+            summary += QString(" ") + class_names[i] + " " + QString::number(statistics.class_counts[i]) + (i < 7 ? "," : "");
+        }
+        summary += "<br>Main sequence: " + QString::number(100.0 * statistics.main_sequence_count / total, 'f', 1) + "% of the stars (within " + QString::number(StatisticsFunctions::main_sequence_width, 'f', 0) + " dex of L = (T / 5772 K)^7)";
+        summary_label->setText(summary);
+
+        vector<quint64> temperature_bars;
+        for(int t = 2000; t < 42000; t += 1000)
+        {
+            temperature_bars.push_back(StatisticsFunctions::count_range(temperature, t, t + 1000, false));
+        }
+        temperature_view->set_bars(temperature_bars, "2000 K", "42000 K");
+
+        vector<quint64> luminosity_bars;
+        for(double l = -5; l < 7; l += 0.25)
+        {
+            luminosity_bars.push_back(StatisticsFunctions::count_range(log_luminosity, l, l + 0.25, true));
+        }
+        luminosity_view->set_bars(luminosity_bars, "1e-5", "1e7");
+    }
+
+private:
+    static QString get_percentiles_str(const ValueSketch& sketch, bool log_luminosity)
+    {
+        static const double fractions[5] = { 0.05, 0.25, 0.5, 0.75, 0.95 };
+        QString percentiles;
+        for(int i = 0; i < 5; i ++)
+        {
+            double value = StatisticsFunctions::get_percentile(sketch, fractions[i], log_luminosity);
+            percentiles += (i > 0 ? " / " : "") + (log_luminosity ? QString::number(MathFunctions::power_of(10, value), 'g', 3) : QString::number(value, 'f', 0));
+        }
+        return percentiles;
+    }
+
+    QLabel* summary_label;
+    HistogramView* temperature_view;
+    HistogramView* luminosity_view;
+};
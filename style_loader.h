@@ -0,0 +1,31 @@
+/*
+    STYLE LOADER
+*/
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <QWidget>
+
+using namespace std;
+
+//Class containing the functions used to apply the dark stylesheet
+//The sheet is applied in a single pass before the window is shown, so every widget is polished once against it
+class StyleFunctions
+{
+public:
+    static QString load_stylesheet()
+    {
+        QFile file(":/qdarkstyle/style.qss");
+        if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            return QString();
+        }
+        return QString::fromUtf8(file.readAll());
+    }
+
+    static void apply_stylesheet(QWidget* window)
+    {
+        window->setStyleSheet(load_stylesheet());
+    }
+};
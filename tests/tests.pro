@@ -0,0 +1,38 @@
+#-------------------------------------------------
+#
+# Unit tests of the journal, the base64url codec, the list merge and the statistics
+#
+#-------------------------------------------------
+
+QT       += core gui concurrent testlib
+QT       -= widgets
+
+TARGET = stargraph_tests
+TEMPLATE = app
+
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# The lists come from the core library, built first by StarGraphSuite.pro
+INCLUDEPATH += .. ../stargraph_core
+DEPENDPATH += ../stargraph_core
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/../stargraph_core/release -lstargraph_core
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/../stargraph_core/debug -lstargraph_core
+else: LIBS += -L$$OUT_PWD/../stargraph_core -lstargraph_core
+
+win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../stargraph_core/release/libstargraph_core.a
+else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../stargraph_core/debug/libstargraph_core.a
+else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../stargraph_core/release/stargraph_core.lib
+else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/../stargraph_core/debug/stargraph_core.lib
+else: PRE_TARGETDEPS += $$OUT_PWD/../stargraph_core/libstargraph_core.a
+
+SOURCES += \
+    tst_stargraph.cpp
+
+HEADERS += \
+    ../base64_codec.h \
+    ../journal_manager.h \
+    ../list_merge.h \
+    ../list_statistics.h
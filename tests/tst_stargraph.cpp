@@ -0,0 +1,304 @@
+/*
+    UNIT TESTS
+*/
+
+#include "base64_codec.h"
+#include "journal_manager.h"
+#include "list_merge.h"
+#include "list_statistics.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+using namespace std;
+
+//Assign the values of the extern variables which are defined by the application, not by the core library
+QString current_list_path = "";
+bool journaled_saving = true;
+int journal_next_seq = 0;
+int journal_records_since_snapshot = 0;
+QByteArray journal_pending;
+ListStatistics list_statistics = StatisticsFunctions::create(static_cast<unsigned>(-1));
+int memory_budget = 0;
+
+class StarGraphTests : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void journal_replay();
+    void journal_replay_skips_old_and_interrupted_records();
+    void base64_round_trip();
+    void base64_invalid_input();
+    void merge_updates_and_appends();
+    void merge_keeps_existing_stars();
+    void merge_normalized_names();
+    void statistics_record_appended();
+    void statistics_record_add_and_edit();
+
+private:
+    static vector<QString> star(QString name, QString temperature, QString luminosity)
+    {
+        vector<QString> entry;
+        entry.push_back(name);
+        entry.push_back(temperature);
+        entry.push_back(luminosity);
+        return entry;
+    }
+
+    static vector<vector<QString>> get_rows(const StarDataset& dataset)
+    {
+        vector<vector<QString>> rows;
+        for(unsigned i = 0; i < dataset.size(); i ++)
+        {
+            rows.push_back(dataset[i]);
+        }
+        return rows;
+    }
+
+    //The counts must be the same, the moments are calculated in another order so they only have to be close
+    static void compare_statistics(const ListStatistics& actual, const ListStatistics& expected)
+    {
+        QCOMPARE(actual.star_count, expected.star_count);
+        QCOMPARE(actual.main_sequence_count, expected.main_sequence_count);
+        for(int i = 0; i < 8; i ++)
+        {
+            QCOMPARE(actual.class_counts[i], expected.class_counts[i]);
+        }
+        QCOMPARE(actual.temperature.count, expected.temperature.count);
+        QCOMPARE(actual.log_luminosity.count, expected.log_luminosity.count);
+        QVERIFY(actual.temperature.bins == expected.temperature.bins);
+        QVERIFY(actual.log_luminosity.bins == expected.log_luminosity.bins);
+        QVERIFY(std::fabs(actual.temperature.mean - expected.temperature.mean) < 1e-6 * std::fabs(expected.temperature.mean) + 1e-9);
+        QVERIFY(std::fabs(actual.log_luminosity.mean - expected.log_luminosity.mean) < 1e-9);
+        double expected_deviation = StatisticsFunctions::get_standard_deviation(expected.temperature);
+        QVERIFY(std::fabs(StatisticsFunctions::get_standard_deviation(actual.temperature) - expected_deviation) < 1e-6 * expected_deviation + 1e-9);
+    }
+
+    static vector<vector<QString>> get_sample_rows(unsigned count)
+    {
+        vector<vector<QString>> rows;
+        for(unsigned i = 0; i < count; i ++)
+        {
+            rows.push_back(star("Star " + QString::number(i), QString::number(3000 + (i * 37) % 12000), QString::number(0.001 * (1 + (i * 7919) % 100000))));
+        }
+        return rows;
+    }
+};
+
+//The records added, edited and deleted are appended to the journal, and replaying them on the snapshot gives the list as it was edited
+void StarGraphTests::journal_replay()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    current_list_path = dir.filePath("list.sgl");
+    JournalFunctions::reset(1);
+
+    vector<vector<QString>> snapshot;
+    snapshot.push_back(star("Sun", "5772", "1"));
+    snapshot.push_back(star("Sirius", "9940", "25.4"));
+    snapshot.push_back(star("Vega", "9602", "40.12"));
+    snapshot.push_back(star("Deneb", "8525", "196000"));
+
+    //A bulk delete records the rows from the last to the first
+    JournalFunctions::record_delete(3);
+    JournalFunctions::record_delete(2);
+    JournalFunctions::record_edit(0, star("Sun", "5778", "1"));
+    JournalFunctions::record_add(star("Name with\ttab", "3042", "0.0017"));
+    QVERIFY(JournalFunctions::flush());
+    QVERIFY(journal_pending.isEmpty());
+    QCOMPARE(journal_records_since_snapshot, 4);
+
+    vector<vector<QString>> list = snapshot;
+    int last_seq = 0;
+    QCOMPARE(JournalFunctions::replay(current_list_path, list, 0, &last_seq), 4);
+    QCOMPARE(last_seq, 4);
+    QCOMPARE(static_cast<int>(list.size()), 3);
+    QVERIFY(list[0] == star("Sun", "5778", "1"));
+    QVERIFY(list[1] == snapshot[1]);
+    QVERIFY(list[2] == star("Name with\ttab", "3042", "0.0017"));
+
+    //Recovering continues the journal after the last record
+    list = snapshot;
+    QCOMPARE(JournalFunctions::recover(current_list_path, list, 0), 4);
+    QCOMPARE(journal_next_seq, 5);
+
+    current_list_path = "";
+}
+
+void StarGraphTests::journal_replay_skips_old_and_interrupted_records()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    current_list_path = dir.filePath("list.sgl");
+    JournalFunctions::reset(1);
+
+    JournalFunctions::record_add(star("Included", "5000", "1"));
+    JournalFunctions::record_add(star("Newer", "6000", "2"));
+    QVERIFY(JournalFunctions::flush());
+
+    //A record cut short by a crash has no trailing newline
+    QFile journal(JournalFunctions::get_journal_path(current_list_path));
+    QVERIFY(journal.open(QIODevice::WriteOnly | QIODevice::Append));
+    journal.write("A\t3\t-1\tCut\t70");
+    journal.close();
+
+    vector<vector<QString>> list;
+    list.push_back(star("Included", "5000", "1"));
+    int last_seq = 1;
+    QCOMPARE(JournalFunctions::replay(current_list_path, list, 1, &last_seq), 1);
+    QCOMPARE(last_seq, 2);
+    QCOMPARE(static_cast<int>(list.size()), 2);
+    QVERIFY(list[1] == star("Newer", "6000", "2"));
+
+    //Compacting keeps only the records newer than the snapshot
+    QVERIFY(JournalFunctions::compact(current_list_path, 1));
+    QCOMPARE(journal_records_since_snapshot, 1);
+
+    //A list without a journal keeps no records
+    current_list_path = "";
+    JournalFunctions::record_add(star("Lost", "4000", "1"));
+    QVERIFY(journal_pending.isEmpty());
+}
+
+//Every length covers the blocks and the one or two bytes of an incomplete group, and the result matches the base64url encoding of Qt
+void StarGraphTests::base64_round_trip()
+{
+    for(int size = 0; size < 300; size ++)
+    {
+        QByteArray bytes;
+        for(int i = 0; i < size; i ++)
+        {
+            bytes.append(static_cast<char>((i * 131 + size * 17) & 0xff));
+        }
+
+        QByteArray encoded(Base64UrlFunctions::get_encoded_size(size), '\0');
+        QCOMPARE(Base64UrlFunctions::encode(bytes.constData(), size, encoded.data()), encoded.size());
+        QCOMPARE(encoded, bytes.toBase64(QByteArray::Base64UrlEncoding | QByteArray::OmitTrailingEquals));
+
+        QByteArray decoded(Base64UrlFunctions::get_decoded_size(encoded.size()), '\0');
+        QCOMPARE(Base64UrlFunctions::decode(encoded.constData(), encoded.size(), decoded.data()), size);
+        QCOMPARE(decoded, bytes);
+    }
+}
+
+void StarGraphTests::base64_invalid_input()
+{
+    QByteArray output(64, '\0');
+
+    //Characters of the standard alphabet, padding and bytes above 127 are outside the base64url alphabet, wherever they are
+    QCOMPARE(Base64UrlFunctions::decode("ab+c", 4, output.data()), -1);
+    QCOMPARE(Base64UrlFunctions::decode("abc/", 4, output.data()), -1);
+    QCOMPARE(Base64UrlFunctions::decode("abc=", 4, output.data()), -1);
+    QByteArray long_input(80, 'A');
+    long_input[70] = static_cast<char>(0xc3);
+    QCOMPARE(Base64UrlFunctions::decode(long_input.constData(), long_input.size(), output.data()), -1);
+
+    //A single character after the last group cannot be decoded
+    QCOMPARE(Base64UrlFunctions::decode("abcde", 5, output.data()), -1);
+}
+
+//A matching star with other values is a conflict and is updated, a new star is appended, a repeated one is ignored
+void StarGraphTests::merge_updates_and_appends()
+{
+    vector<vector<QString>> list_rows;
+    list_rows.push_back(star("Sun", "5772", "1"));
+    list_rows.push_back(star("Sirius", "9940", "25.4"));
+    vector<vector<QString>> incoming_rows;
+    incoming_rows.push_back(star("Sirius", "9900", "25.4"));
+    incoming_rows.push_back(star("Vega", "9602", "40.12"));
+    incoming_rows.push_back(star("Vega", "9000", "40"));
+    incoming_rows.push_back(star("Sun", "5772", "1"));
+
+    MergeResult result = MergeFunctions::merge(StarDataset::from_rows(list_rows), StarDataset::from_rows(incoming_rows), update_existing_stars, false);
+    QCOMPARE(result.matched_count, 2u);
+    QCOMPARE(result.updated_count, 1u);
+    QCOMPARE(result.appended_count, 1u);
+    QCOMPARE(result.duplicate_count, 1u);
+    QCOMPARE(static_cast<int>(result.conflicts.size()), 1);
+    QCOMPARE(result.conflicts[0].row, 1u);
+
+    vector<vector<QString>> rows = get_rows(*result.dataset);
+    QCOMPARE(static_cast<int>(rows.size()), 3);
+    QVERIFY(rows[0] == list_rows[0]);
+    QVERIFY(rows[1] == star("Sirius", "9900", "25.4"));
+    QVERIFY(rows[2] == star("Vega", "9602", "40.12"));
+}
+
+void StarGraphTests::merge_keeps_existing_stars()
+{
+    vector<vector<QString>> list_rows;
+    list_rows.push_back(star("Sirius", "9940", "25.4"));
+    vector<vector<QString>> incoming_rows;
+    incoming_rows.push_back(star("Sirius", "9900", "25.4"));
+
+    DatasetSnapshot list = StarDataset::from_rows(list_rows);
+    MergeResult result = MergeFunctions::merge(list, StarDataset::from_rows(incoming_rows), keep_existing_stars, false);
+    QCOMPARE(static_cast<int>(result.conflicts.size()), 1);
+    QCOMPARE(result.updated_count, 0u);
+    QVERIFY(result.dataset == list);
+}
+
+//Normalized names match whatever their case and spacing, and the star keeps the name of the list
+void StarGraphTests::merge_normalized_names()
+{
+    vector<vector<QString>> list_rows;
+    list_rows.push_back(star("HD 48915", "9940", "25.4"));
+    vector<vector<QString>> incoming_rows;
+    incoming_rows.push_back(star("hd48915", "9900", "25.4"));
+
+    DatasetSnapshot list = StarDataset::from_rows(list_rows);
+    QCOMPARE(MergeFunctions::merge(list, StarDataset::from_rows(incoming_rows), update_existing_stars, false).appended_count, 1u);
+
+    MergeResult result = MergeFunctions::merge(list, StarDataset::from_rows(incoming_rows), update_existing_stars, true);
+    QCOMPARE(result.matched_count, 1u);
+    QCOMPARE(result.appended_count, 0u);
+    QVERIFY((*result.dataset)[0] == star("HD 48915", "9900", "25.4"));
+}
+
+//Appending stars to the snapshot of the statistics only adds the new ones, and gives the statistics of the whole list
+void StarGraphTests::statistics_record_appended()
+{
+    vector<vector<QString>> rows = get_sample_rows(5000);
+    vector<vector<QString>> first_rows(rows.begin(), rows.begin() + 3000);
+    vector<vector<QString>> appended(rows.begin() + 3000, rows.end());
+
+    DatasetSnapshot list = StarDataset::from_rows(first_rows);
+    ListStatistics statistics = StatisticsFunctions::build(list);
+    DatasetSnapshot appended_list = list->with_changes(vector<pair<unsigned, vector<QString>>>(), appended);
+    QVERIFY(StatisticsFunctions::record_appended(statistics, appended_list));
+    QCOMPARE(statistics.dataset_version, appended_list->get_version());
+    compare_statistics(statistics, StatisticsFunctions::build(appended_list));
+
+    //A snapshot with a changed row does not continue the appends
+    DatasetSnapshot edited_list = appended_list->with_row(0, star("Edited", "4000", "2"));
+    QVERIFY(!StatisticsFunctions::record_appended(statistics, edited_list));
+}
+
+//Adding or changing a star of the snapshot of the statistics updates them star by star
+void StarGraphTests::statistics_record_add_and_edit()
+{
+    DatasetSnapshot list = StarDataset::from_rows(get_sample_rows(2000));
+    list_statistics = StatisticsFunctions::build(list);
+
+    vector<QString> added = star("Added", "5772", "1");
+    DatasetSnapshot added_list = list->with_appended(added);
+    StatisticsFunctions::record_add(list->get_version(), added_list->get_version(), added);
+    QCOMPARE(list_statistics.dataset_version, added_list->get_version());
+
+    vector<QString> old_entry = (*added_list)[10];
+    vector<QString> new_entry = star(old_entry[0], "30000", "50000");
+    DatasetSnapshot edited_list = added_list->with_row(10, new_entry);
+    StatisticsFunctions::record_edit(added_list->get_version(), edited_list->get_version(), old_entry, new_entry);
+    QCOMPARE(list_statistics.dataset_version, edited_list->get_version());
+    compare_statistics(list_statistics, StatisticsFunctions::build(edited_list));
+
+    //Statistics of another snapshot are left alone
+    StatisticsFunctions::record_add(list->get_version(), added_list->get_version(), added);
+    QCOMPARE(list_statistics.dataset_version, edited_list->get_version());
+}
+
+QTEST_GUILESS_MAIN(StarGraphTests)
+
+#include "tst_stargraph.moc"
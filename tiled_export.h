@@ -0,0 +1,336 @@
+/*
+    TILED IMAGE EXPORTER
+*/
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QImage>
+#include <QString>
+#include <QtEndian>
+#include <cstring>
+#include <vector>
+
+#if defined(__has_include)
+#if __has_include(<QtZlib/zlib.h>)
+#include <QtZlib/zlib.h>
+#else
+#include <zlib.h>
+#endif
+#else
+#include <zlib.h>
+#endif
+
+#include "gl_diagram.h"
+
+using namespace std;
+
+//Class writing a PNG image one row at a time, compressing the rows as they arrive
+class PngStreamWriter
+{
+public:
+    PngStreamWriter() : image_width(0), stream_open(false)
+    {
+    }
+
+    ~PngStreamWriter()
+    {
+        if(stream_open)
+        {
+            deflateEnd(&stream);
+        }
+    }
+
+    bool open(QString file_name, int width, int height)
+    {
+        image_width = width;
+        png_out.setFileName(file_name);
+        if(!png_out.open(QIODevice::WriteOnly))
+        {
+            return false;
+        }
+
+        //Signature and header: 8 bit RGB, no interlacing
+        static const char signature[8] = { '\x89', 'P', 'N', 'G', '\r', '\n', '\x1a', '\n' };
+        png_out.write(signature, 8);
+
+        QByteArray header(13, '\0');
+        qToBigEndian<quint32>(static_cast<quint32>(width), reinterpret_cast<uchar*>(header.data()));
+        qToBigEndian<quint32>(static_cast<quint32>(height), reinterpret_cast<uchar*>(header.data() + 4));
+        header[8] = 8;
+        header[9] = 2;
+        write_chunk("IHDR", header);
+
+        stream.zalloc = Z_NULL;
+        stream.zfree = Z_NULL;
+        stream.opaque = Z_NULL;
+        stream_open = deflateInit(&stream, 6) == Z_OK;
+        return stream_open;
+    }
+
+    //Append the rows of 'rows', which must be as wide as the image
+    bool write_rows(const QImage& rows)
+    {
+        QImage rgb_rows = rows.convertToFormat(QImage::Format_RGB888);
+        QByteArray scanline(image_width * 3 + 1, '\0');
+        for(int y = 0; y < rgb_rows.height(); y ++)
+        {
+            //Every scanline starts with its filter type, '0' means no filter
+            memcpy(scanline.data() + 1, rgb_rows.constScanLine(y), static_cast<size_t>(image_width * 3));
+            if(!compress(scanline, Z_NO_FLUSH))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool close()
+    {
+        bool written = compress(QByteArray(), Z_FINISH);
+        written = write_chunk("IEND", QByteArray()) && written;
+        png_out.close();
+        return written;
+    }
+
+private:
+    bool compress(const QByteArray& data, int flush)
+    {
+        char buffer[65536];
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.constData()));
+        stream.avail_in = static_cast<uInt>(data.size());
+        do
+        {
+            stream.next_out = reinterpret_cast<Bytef*>(buffer);
+            stream.avail_out = sizeof(buffer);
+            if(deflate(&stream, flush) == Z_STREAM_ERROR)
+            {
+                return false;
+            }
+            int produced = static_cast<int>(sizeof(buffer) - stream.avail_out);
+            if(produced > 0 && !write_chunk("IDAT", QByteArray::fromRawData(buffer, produced)))
+            {
+                return false;
+            }
+        }
+        while(stream.avail_out == 0);
+        return true;
+    }
+
+    bool write_chunk(const char* type, const QByteArray& data)
+    {
+        uchar length[4];
+        qToBigEndian<quint32>(static_cast<quint32>(data.size()), length);
+
+        uLong crc = crc32(0, reinterpret_cast<const Bytef*>(type), 4);
+        crc = crc32(crc, reinterpret_cast<const Bytef*>(data.constData()), static_cast<uInt>(data.size()));
+        uchar crc_bytes[4];
+        qToBigEndian<quint32>(static_cast<quint32>(crc), crc_bytes);
+
+        return png_out.write(reinterpret_cast<const char*>(length), 4) == 4 && png_out.write(type, 4) == 4 && png_out.write(data) == data.size() && png_out.write(reinterpret_cast<const char*>(crc_bytes), 4) == 4;
+    }
+
+    QFile png_out;
+    int image_width;
+    z_stream stream;
+    bool stream_open;
+};
+
+//Class writing a tiled TIFF image one tile at a time, each tile is compressed on its own
+class TiffTileWriter
+{
+public:
+    bool open(QString file_name, int width, int height, int tile_size)
+    {
+        image_width = width;
+        image_height = height;
+        tile_side = tile_size;
+        tile_offsets.clear();
+        tile_byte_counts.clear();
+
+        tiff_out.setFileName(file_name);
+        if(!tiff_out.open(QIODevice::WriteOnly))
+        {
+            return false;
+        }
+
+        //Little endian header, the offset of the directory is written once all the tiles are known
+        QByteArray header("II*\0\0\0\0\0", 8);
+        return tiff_out.write(header) == 8;
+    }
+
+    //Append the next tile, in left to right and top to bottom order: the tiles on the edges are padded to the full size
+    bool write_tile(const QImage& tile)
+    {
+        QImage rgb_tile = tile.convertToFormat(QImage::Format_RGB888);
+        QByteArray tile_data(tile_side * tile_side * 3, '\0');
+        for(int y = 0; y < rgb_tile.height() && y < tile_side; y ++)
+        {
+            memcpy(tile_data.data() + y * tile_side * 3, rgb_tile.constScanLine(y), static_cast<size_t>(qMin(rgb_tile.width(), tile_side) * 3));
+        }
+
+        //'qCompress()' prepends the uncompressed size to a zlib stream, which is exactly what the deflate compression of TIFF expects
+        QByteArray compressed = qCompress(tile_data).mid(4);
+
+        //Classic TIFF files use 32 bit offsets
+        if(tiff_out.pos() + compressed.size() > 0xffffffffLL)
+        {
+            return false;
+        }
+        tile_offsets.push_back(static_cast<quint32>(tiff_out.pos()));
+        tile_byte_counts.push_back(static_cast<quint32>(compressed.size()));
+        return tiff_out.write(compressed) == compressed.size();
+    }
+
+    bool close()
+    {
+        //Word-align the arrays and the directory
+        if(tiff_out.pos() % 2)
+        {
+            tiff_out.write("\0", 1);
+        }
+
+        quint32 bits_offset = static_cast<quint32>(tiff_out.pos());
+        write_short(8);
+        write_short(8);
+        write_short(8);
+
+        quint32 offsets_offset = static_cast<quint32>(tiff_out.pos());
+        for(unsigned i = 0; i < tile_offsets.size(); i ++)
+        {
+            write_long(tile_offsets[i]);
+        }
+        quint32 byte_counts_offset = static_cast<quint32>(tiff_out.pos());
+        for(unsigned i = 0; i < tile_byte_counts.size(); i ++)
+        {
+            write_long(tile_byte_counts[i]);
+        }
+
+        quint32 directory_offset = static_cast<quint32>(tiff_out.pos());
+        quint32 tile_count = static_cast<quint32>(tile_offsets.size());
+        write_short(11);
+        write_entry(256, 4, 1, static_cast<quint32>(image_width));
+        write_entry(257, 4, 1, static_cast<quint32>(image_height));
+        write_entry(258, 3, 3, bits_offset);
+        //Deflate compression
+        write_entry(259, 3, 1, 8);
+        //RGB
+        write_entry(262, 3, 1, 2);
+        write_entry(277, 3, 1, 3);
+        write_entry(284, 3, 1, 1);
+        write_entry(322, 4, 1, static_cast<quint32>(tile_side));
+        write_entry(323, 4, 1, static_cast<quint32>(tile_side));
+        write_entry(324, 4, tile_count, tile_count == 1 ? tile_offsets[0] : offsets_offset);
+        write_entry(325, 4, tile_count, tile_count == 1 ? tile_byte_counts[0] : byte_counts_offset);
+        write_long(0);
+
+        //Point the header to the directory
+        tiff_out.seek(4);
+        write_long(directory_offset);
+
+        bool written = tiff_out.error() == QFileDevice::NoError;
+        tiff_out.close();
+        return written;
+    }
+
+private:
+    void write_short(quint16 value)
+    {
+        uchar bytes[2];
+        qToLittleEndian<quint16>(value, bytes);
+        tiff_out.write(reinterpret_cast<const char*>(bytes), 2);
+    }
+
+    void write_long(quint32 value)
+    {
+        uchar bytes[4];
+        qToLittleEndian<quint32>(value, bytes);
+        tiff_out.write(reinterpret_cast<const char*>(bytes), 4);
+    }
+
+    //Write a directory entry: short values are stored in the first bytes of the value field
+    void write_entry(quint16 tag, quint16 type, quint32 count, quint32 value)
+    {
+        write_short(tag);
+        write_short(type);
+        write_long(count);
+        if(type == 3 && count == 1)
+        {
+            write_short(static_cast<quint16>(value));
+            write_short(0);
+        }
+        else
+        {
+            write_long(value);
+        }
+    }
+
+    QFile tiff_out;
+    int image_width;
+    int image_height;
+    int tile_side;
+    vector<quint32> tile_offsets;
+    vector<quint32> tile_byte_counts;
+};
+
+//Class containing the functions used to export the diagram at a resolution larger than the framebuffer
+class TiledExportFunctions
+{
+public:
+    //Side of the tiles rendered offscreen, a multiple of 16 as required by TIFF
+    static const int tile_size = 512;
+
+    //Render the diagram 'width' pixels wide tile by tile and save it to 'file_name' as a PNG or TIFF image
+    //A TIFF image only keeps one tile in memory, a PNG image one row of tiles since it has to be written top to bottom
+    static bool save_tiled(GL_Diagram* diagram, QString file_name, int width)
+    {
+        double scale = static_cast<double>(width) / diagram_width;
+        int height = qRound(diagram_height * scale);
+        int columns = (width + tile_size - 1) / tile_size;
+        int rows = (height + tile_size - 1) / tile_size;
+
+        if(file_name.endsWith(".tif", Qt::CaseInsensitive) || file_name.endsWith(".tiff", Qt::CaseInsensitive))
+        {
+            TiffTileWriter tiff_writer;
+            if(!tiff_writer.open(file_name, width, height, tile_size))
+            {
+                return false;
+            }
+            for(int row = 0; row < rows; row ++)
+            {
+                for(int column = 0; column < columns; column ++)
+                {
+                    if(!tiff_writer.write_tile(diagram->render_tile_image(scale, QRect(column * tile_size, row * tile_size, tile_size, tile_size))))
+                    {
+                        return false;
+                    }
+                }
+            }
+            return tiff_writer.close();
+        }
+
+        PngStreamWriter png_writer;
+        if(!png_writer.open(file_name, width, height))
+        {
+            return false;
+        }
+        for(int row = 0; row < rows; row ++)
+        {
+            int strip_height = qMin(tile_size, height - row * tile_size);
+            QImage strip(width, strip_height, QImage::Format_RGB888);
+            QPainter strip_painter(&strip);
+            for(int column = 0; column < columns; column ++)
+            {
+                int tile_width = qMin(tile_size, width - column * tile_size);
+                strip_painter.drawImage(column * tile_size, 0, diagram->render_tile_image(scale, QRect(column * tile_size, row * tile_size, tile_width, strip_height)));
+            }
+            strip_painter.end();
+
+            if(!png_writer.write_rows(strip))
+            {
+                return false;
+            }
+        }
+        return png_writer.close();
+    }
+};
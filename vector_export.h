@@ -0,0 +1,210 @@
+/*
+    VECTOR EXPORTER
+*/
+#pragma once
+
+#include <QHash>
+#include <QMap>
+#include <QPageSize>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPdfWriter>
+#include <QSvgGenerator>
+#include <cmath>
+
+#include "catalog_layers.h"
+#include "diagram_painter.h"
+#include "gl_diagram.h"
+#include "mainwindow.h"
+#include "star_dataset.h"
+
+using namespace std;
+
+//Class containing the functions used to export the diagram as SVG or PDF
+//Both QSvgGenerator and QPdfWriter write every primitive to the file as soon as it is painted, so no document tree is kept in memory
+class VectorExportFunctions
+{
+public:
+    //Export the diagram to 'file_name': the stars closer than one dot at 'dpi' are merged into a single point
+    static bool save_vector(QString file_name, int dpi)
+    {
+        //The diagram is measured in pixels at 96 dpi, like the OpenGL widget
+        double cell_size = 96.0 / dpi;
+
+        QPainter painter;
+        if(file_name.endsWith(".pdf", Qt::CaseInsensitive))
+        {
+            QPdfWriter pdf_writer(file_name);
+            pdf_writer.setResolution(dpi);
+            pdf_writer.setPageSize(QPageSize(QSizeF(diagram_width / 96.0, diagram_height / 96.0), QPageSize::Inch));
+            pdf_writer.setPageMargins(QMarginsF(0, 0, 0, 0));
+
+            if(!painter.begin(&pdf_writer))
+            {
+                return false;
+            }
+            painter.setWindow(0, 0, diagram_width, diagram_height);
+            painter.setViewport(0, 0, pdf_writer.width(), pdf_writer.height());
+            paint_diagram(painter, cell_size);
+            return painter.end();
+        }
+
+        QSvgGenerator svg_generator;
+        svg_generator.setFileName(file_name);
+        svg_generator.setResolution(96);
+        svg_generator.setSize(QSize(diagram_width, diagram_height));
+        svg_generator.setViewBox(QRect(0, 0, diagram_width, diagram_height));
+        svg_generator.setTitle("Hertzsprung-Russel Diagram");
+        svg_generator.setDescription("Generated by StarGraph v" + stargraph_version);
+
+        if(!painter.begin(&svg_generator))
+        {
+            return false;
+        }
+        paint_diagram(painter, cell_size);
+        return painter.end();
+    }
+
+    //Paint the diagram in the same order as 'GL_Diagram::paintGL()', using vector primitives
+    static void paint_diagram(QPainter& painter, double cell_size)
+    {
+        DatasetSnapshot list = DatasetFunctions::current();
+        DiagramView view = ProjectionFunctions::get_view();
+
+        painter.fillRect(0, 0, view.width, view.height, Qt::black);
+
+        //The inner drawing area is squeezed into the frame the same way the OpenGL viewport does
+        double scale_x = static_cast<double>(view.width - 64) / view.width;
+        double scale_y = static_cast<double>(view.height - 64) / view.height;
+        painter.save();
+        painter.translate(32, 32);
+        painter.scale(scale_x, scale_y);
+        painter.setClipRect(0, 0, view.width, view.height);
+
+        //Draw the reference lines
+        double brightness = static_cast<double>(graph_lines_opacity) / 100.0;
+        painter.setPen(QPen(QColor::fromRgbF(brightness, brightness, brightness), 1.0 / scale_x));
+        DiagramPainterFunctions::draw_lines(painter, DiagramPainterFunctions::get_reference_lines(view, graph_show_v_lines, graph_show_h_lines, graph_line_h_step, graph_line_v_step));
+
+        //Draw the visible overlaid catalogs, the current list, then the layers drawn over it
+        for(unsigned i = 0; i < catalog_layers.size(); i ++)
+        {
+            if(catalog_layers[i].visible && !catalog_layers[i].over_list)
+            {
+                draw_merged_stars(painter, view, *catalog_layers[i].dataset, catalog_layers[i].temperature_colour, catalog_layers[i].colour, catalog_layers[i].round_markers, catalog_layers[i].point_size / scale_x, cell_size / scale_x);
+            }
+        }
+        draw_merged_stars(painter, view, *list, true, QColor(), false, graph_point_size / scale_x, cell_size / scale_x);
+        for(unsigned i = 0; i < catalog_layers.size(); i ++)
+        {
+            if(catalog_layers[i].visible && catalog_layers[i].over_list)
+            {
+                draw_merged_stars(painter, view, *catalog_layers[i].dataset, catalog_layers[i].temperature_colour, catalog_layers[i].colour, catalog_layers[i].round_markers, catalog_layers[i].point_size / scale_x, cell_size / scale_x);
+            }
+        }
+
+        //Draw the names of the stars and the selected star
+        painter.setPen(Qt::white);
+        if(graph_show_names)
+        {
+            DiagramPainterFunctions::draw_star_name_labels(painter, view, *list);
+        }
+        int star = selected_star;
+        if(star != -1 && star < static_cast<int>(list->size()) && graph_highlight_selected_star && list->get_luminosity(static_cast<unsigned>(star)) > 0)
+        {
+            QPointF center = ProjectionFunctions::project_star(view, list->get_temperature(static_cast<unsigned>(star)), MathFunctions::log_base_10(list->get_luminosity(static_cast<unsigned>(star))));
+            int center_x = static_cast<int>(center.x());
+            int center_y = static_cast<int>(center.y());
+            painter.setPen(QPen(QColor(255, 0, 255), 1.0 / scale_x));
+            painter.drawRect(center_x - graph_pos_square_size, center_y - graph_pos_square_size, graph_pos_square_size * 2, graph_pos_square_size * 2);
+            painter.setPen(Qt::white);
+            painter.setFont(QFont("Verdana", 10));
+            painter.drawText(center_x - graph_pos_square_size, center_y - (graph_pos_square_size + 8), list->get_name(static_cast<unsigned>(star)));
+        }
+        painter.restore();
+
+        //Draw the white frame and the scale information
+        painter.setPen(QPen(Qt::white, 2.0));
+        DiagramPainterFunctions::draw_lines(painter, DiagramPainterFunctions::get_frame_lines(view, 32));
+        painter.setPen(Qt::white);
+        DiagramPainterFunctions::draw_scale_text(painter, view);
+    }
+
+private:
+    //Sums of the temperatures and of the positions, and number of the stars which fall in the same cell
+    struct MergedCell
+    {
+        double temperature_sum;
+        double x_sum;
+        double y_sum;
+        int count;
+    };
+
+    //Draw the stars of 'dataset' in 'view', merging the ones which fall in the same 'cell_size' square into one point at their mean position with their mean colour
+    //Each colour is written as a single path, so the file size depends on the resolution and not on the number of stars
+    static void draw_merged_stars(QPainter& painter, const DiagramView& view, const StarDataset& dataset, bool temperature_colour, QColor colour, bool round_markers, double point_size, double cell_size)
+    {
+        QHash<quint64, MergedCell> cells;
+        vector<double> xs(StarDataset::chunk_size);
+        vector<double> ys(StarDataset::chunk_size);
+        for(unsigned c = 0; c < dataset.get_chunk_count(); c ++)
+        {
+            shared_ptr<const StarChunk> chunk = dataset.get_chunk(c);
+            //Same coordinates as the OpenGL widget, without rounding to whole pixels
+            ProjectionFunctions::project_chunk(view, *chunk, xs.data(), ys.data());
+            for(unsigned i = 0; i < chunk->size(); i ++)
+            {
+                double temperature = chunk->get_temperature(i);
+                double star_x = xs[i];
+                double star_y = ys[i];
+                if(!ProjectionFunctions::is_finite(star_x, star_y))
+                {
+                    continue;
+                }
+
+                if(star_x < -point_size || star_x > diagram_width + point_size || star_y < -point_size || star_y > diagram_height + point_size)
+                {
+                    continue;
+                }
+
+                //The cells left of or above the origin have negative indexes, which are converted to unsigned only once they are integers
+                quint64 key = (static_cast<quint64>(static_cast<quint32>(static_cast<qint32>(floor(star_x / cell_size)))) << 32) | static_cast<quint32>(static_cast<qint32>(floor(star_y / cell_size)));
+                MergedCell& cell = cells[key];
+                cell.temperature_sum += temperature;
+                cell.x_sum += star_x;
+                cell.y_sum += star_y;
+                cell.count ++;
+            }
+        }
+
+        //Group the points by colour, quantized to 32 levels per channel
+        QMap<QRgb, QPainterPath> paths;
+        for(QHash<quint64, MergedCell>::const_iterator it = cells.constBegin(); it != cells.constEnd(); ++ it)
+        {
+            QColor point_colour = temperature_colour ? DiagramPainterFunctions::get_star_colour(it.value().temperature_sum / it.value().count) : colour;
+            QRgb rgb = qRgb(point_colour.red() & 0xf8, point_colour.green() & 0xf8, point_colour.blue() & 0xf8);
+
+            double center_x = it.value().x_sum / it.value().count;
+            double center_y = it.value().y_sum / it.value().count;
+            QRectF point(center_x - point_size / 2, center_y - point_size / 2, point_size, point_size);
+
+            QPainterPath& path = paths[rgb];
+            if(round_markers)
+            {
+                path.addEllipse(point);
+            }
+            else
+            {
+                path.addRect(point);
+            }
+        }
+        cells.clear();
+
+        painter.setPen(Qt::NoPen);
+        for(QMap<QRgb, QPainterPath>::iterator it = paths.begin(); it != paths.end(); ++ it)
+        {
+            painter.fillPath(it.value(), QColor(it.key()));
+            it.value() = QPainterPath();
+        }
+    }
+};